@@ -0,0 +1,265 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Checks the background autosave (gsteditorautosave.c). Elements are
+ * moved between snapshots queued in quick succession, so that some are
+ * coalesced and some are written while the next ones are taken. Once
+ * the autosave is freed, the file must hold the layout the canvas ends
+ * up with, both for a pipeline with the layout in the key file and one
+ * large enough for a layout sidecar. A plain Gst-Launch autosave must
+ * parse back into the same number of elements.
+ * Exits with 1 on the first failure.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+
+#include <gst/common/gste-metadata.h>
+#include <gst/editor/editor.h>
+
+#include "gsteditorautosave.h"
+
+#define CHAIN_LENGTH 10
+#define ROUNDS 40
+/* fails instead of hanging (s) */
+#define TIMEOUT 60
+
+static const guint sizes[] = { 50, GSTE_METADATA_MIN_RECORDS + 50 };
+
+static guint n_saved, n_errors;
+
+#define check(expr) G_STMT_START {					\
+  if (!(expr)) {							\
+    g_printerr ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr);\
+    exit (1);								\
+  }									\
+} G_STMT_END
+
+/* n_elements elements in chains of fakesrc ! identity ! ... ! fakesink */
+static GstElement *
+make_pipeline (guint n_elements)
+{
+  GstElement *pipeline = gst_pipeline_new (NULL);
+  GstElement *prev = NULL;
+
+  for (guint i = 0; i < n_elements; i++) {
+    const gchar *factory;
+    GstElement *element;
+
+    if (i % CHAIN_LENGTH == 0)
+      factory = "fakesrc";
+    else if (i % CHAIN_LENGTH == CHAIN_LENGTH - 1 || i == n_elements - 1)
+      factory = "fakesink";
+    else
+      factory = "identity";
+
+    element = gst_element_factory_make (factory, NULL);
+    if (!element) {
+      g_printerr ("Could not create a %s element\n", factory);
+      exit (1);
+    }
+    gst_bin_add (GST_BIN (pipeline), element);
+    if (prev && i % CHAIN_LENGTH != 0)
+      gst_element_link (prev, element);
+    prev = element;
+  }
+
+  return pipeline;
+}
+
+static gboolean
+timeout_cb (gpointer user_data)
+{
+  g_printerr ("Timed out after %d s\n", TIMEOUT);
+  exit (1);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+saved_cb (const gchar * filename, const GError * error, gpointer user_data)
+{
+  if (error) {
+    g_printerr ("Could not save %s: %s\n", filename, error->message);
+    n_errors++;
+  }
+  n_saved++;
+}
+
+/* the file must hold the layout of every element of bin */
+static void
+check_layout (GstEditorBin * bin, const gchar * filename)
+{
+  GstEditorCanvasLoad *load;
+  GKeyFile *key_file = g_key_file_new ();
+  GError *error = NULL;
+
+  if (!g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE, &error)
+      || !(load = gst_editor_canvas_load_parse (key_file, filename, FALSE,
+              &error))) {
+    g_printerr ("Could not load %s: %s\n", filename, error->message);
+    exit (1);
+  }
+  g_key_file_free (key_file);
+
+  for (guint i = 0; i < bin->sort.len; i++) {
+    GstEditorItem *item = GST_EDITOR_ITEM (bin->sort.elements[i]);
+    GstEditorItemAttr *attr;
+    cairo_matrix_t matrix;
+
+    attr = g_hash_table_lookup (load->attributes,
+        GST_OBJECT_NAME (item->object));
+    check (attr != NULL);
+
+    cairo_matrix_init_identity (&matrix);
+    goo_canvas_item_get_transform (GOO_CANVAS_ITEM (item), &matrix);
+
+    check (ABS (attr->x - matrix.x0) < 0.01);
+    check (ABS (attr->y - matrix.y0) < 0.01);
+    check (ABS (attr->w - item->width) < 0.01);
+    check (ABS (attr->h - item->height) < 0.01);
+  }
+
+  gst_editor_canvas_load_free (load);
+}
+
+static void
+check_launch (const gchar * filename, guint n_elements)
+{
+  GstElement *pipeline;
+  GError *error = NULL;
+  gchar *description;
+
+  check (g_file_get_contents (filename, &description, NULL, NULL));
+  pipeline = gst_parse_launch (description, &error);
+  if (!pipeline) {
+    g_printerr ("Could not parse %s: %s\n", filename, error->message);
+    exit (1);
+  }
+  check (GST_BIN (pipeline)->numchildren == n_elements);
+
+  gst_object_unref (pipeline);
+  g_free (description);
+}
+
+static void
+run (guint n_elements, const gchar * dirname)
+{
+  GstEditorAutosave *autosave;
+  GstEditorCanvas *canvas;
+  GstEditorBin *bin;
+  gchar *basename, *filename, *launch_filename, *sidecar_name;
+
+  basename = g_strdup_printf ("autosave-%u.gep", n_elements);
+  filename = g_build_filename (dirname, basename, NULL);
+  g_free (basename);
+  basename = g_strdup_printf ("autosave-%u.launch", n_elements);
+  launch_filename = g_build_filename (dirname, basename, NULL);
+  g_free (basename);
+  sidecar_name = gste_metadata_sidecar_name (filename);
+
+  canvas = g_object_new (GST_TYPE_EDITOR_CANVAS, NULL);
+  g_object_ref_sink (canvas);
+  g_object_set (canvas, "bin", make_pipeline (n_elements), NULL);
+  bin = canvas->bin;
+
+  n_saved = n_errors = 0;
+  autosave = gst_editor_autosave_new (saved_cb, NULL);
+
+  for (guint round = 0; round < ROUNDS; round++) {
+    /* a third of the elements changes between two snapshots */
+    for (guint i = round % 3; i < bin->sort.len; i += 3)
+      gst_editor_element_move (bin->sort.elements[i],
+          round % 2 ? 5 : -4, round % 2 ? -3 : 4);
+    gst_editor_canvas_flush_moves (canvas);
+
+    gst_editor_autosave_queue (autosave, GST_EDITOR_ITEM (bin), filename, 0,
+        TRUE);
+    gst_editor_autosave_queue (autosave, GST_EDITOR_ITEM (bin),
+        launch_filename, 0, FALSE);
+
+    /* now and then let the worker catch up */
+    if (round % 4 == 0)
+      g_usleep (2 * G_TIME_SPAN_MILLISECOND);
+    while (g_main_context_iteration (NULL, FALSE));
+  }
+
+  /* the results are dispatched in the main loop */
+  while (!n_saved)
+    g_main_context_iteration (NULL, TRUE);
+  /* writes the snapshots still pending */
+  gst_editor_autosave_free (autosave);
+
+  check (n_errors == 0);
+  check (n_saved <= 2 * ROUNDS);
+  check_layout (bin, filename);
+  check_launch (launch_filename, n_elements);
+  check (g_file_test (sidecar_name, G_FILE_TEST_EXISTS) ==
+      (n_elements >= GSTE_METADATA_MIN_RECORDS));
+
+  g_print ("%6u elements: %u of %u autosaves written, OK\n", n_elements,
+      n_saved, 2 * ROUNDS);
+
+  gtk_widget_destroy (GTK_WIDGET (canvas));
+  g_object_unref (canvas);
+
+  g_unlink (filename);
+  g_unlink (launch_filename);
+  g_unlink (sidecar_name);
+  g_free (filename);
+  g_free (launch_filename);
+  g_free (sidecar_name);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  gchar *dirname;
+
+  if (!gtk_init_check (&argc, &argv)) {
+    g_print ("No display, skipping\n");
+    /* the automake exit status of a skipped test */
+    return 77;
+  }
+  gst_init (&argc, &argv);
+  gste_init ();
+
+  g_timeout_add_seconds (TIMEOUT, timeout_cb, NULL);
+
+  if (!(dirname = g_dir_make_tmp ("gst-editor-check-XXXXXX", &error))) {
+    g_printerr ("Could not create a temporary directory: %s\n",
+        error->message);
+    return 1;
+  }
+
+  for (guint i = 0; i < G_N_ELEMENTS (sizes); i++)
+    run (sizes[i], dirname);
+
+  g_rmdir (dirname);
+  g_free (dirname);
+
+  g_print ("autosave: OK\n");
+
+  return 0;
+}
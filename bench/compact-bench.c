@@ -0,0 +1,156 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Compares the normal and the "compact" rendering of elements on
+ * synthetic pipelines of 100 and 1000 elements: the canvas items and
+ * the bytes of their instance structs per element, and the time to
+ * paint the whole canvas into an image surface.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+
+#include <gst/editor/editor.h>
+
+#define CHAIN_LENGTH 10
+#define PAINTS 5
+#define SURFACE_SIZE 2048
+
+static const guint sizes[] = { 100, 1000 };
+
+/* n_elements elements in chains of fakesrc ! identity ! ... ! fakesink */
+static GstElement *
+make_pipeline (guint n_elements)
+{
+  GstElement *pipeline = gst_pipeline_new (NULL);
+  GstElement *prev = NULL;
+
+  for (guint i = 0; i < n_elements; i++) {
+    const gchar *factory;
+    GstElement *element;
+
+    if (i % CHAIN_LENGTH == 0)
+      factory = "fakesrc";
+    else if (i % CHAIN_LENGTH == CHAIN_LENGTH - 1 || i == n_elements - 1)
+      factory = "fakesink";
+    else
+      factory = "identity";
+
+    element = gst_element_factory_make (factory, NULL);
+    if (!element) {
+      g_printerr ("Could not create a %s element\n", factory);
+      exit (1);
+    }
+    gst_bin_add (GST_BIN (pipeline), element);
+    if (prev && i % CHAIN_LENGTH != 0)
+      gst_element_link (prev, element);
+    prev = element;
+  }
+
+  return pipeline;
+}
+
+/* counts the canvas items below citem and the size of their instances */
+static guint
+count_canvas_items (GooCanvasItem * citem, gsize * bytes)
+{
+  GTypeQuery query;
+  guint n = 1;
+
+  g_type_query (G_OBJECT_TYPE (citem), &query);
+  *bytes += query.instance_size;
+
+  for (gint i = 0; i < goo_canvas_item_get_n_children (citem); i++)
+    n += count_canvas_items (goo_canvas_item_get_child (citem, i), bytes);
+
+  return n;
+}
+
+static void
+run (guint n_elements, gboolean compact)
+{
+  GstEditorCanvas *canvas;
+  GstElement *pipeline;
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  gsize bytes = 0;
+  guint n_items = 0, n = 0;
+  gint64 total = 0;
+
+  pipeline = make_pipeline (n_elements);
+  canvas = g_object_new (GST_TYPE_EDITOR_CANVAS, "compact", compact, NULL);
+  g_object_ref_sink (canvas);
+  gst_editor_canvas_freeze (canvas);
+  g_object_set (canvas, "bin", pipeline, NULL);
+  gst_editor_canvas_thaw (canvas);
+
+  for (guint i = 0; i < canvas->bin->sort.len; i++) {
+    GstEditorElement *element = canvas->bin->sort.elements[i];
+
+    if (GST_IS_EDITOR_BIN (element))
+      continue;
+    n_items += count_canvas_items (GOO_CANVAS_ITEM (element), &bytes);
+    n++;
+  }
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SURFACE_SIZE,
+      SURFACE_SIZE);
+  cr = cairo_create (surface);
+  /* the first paint is not timed, it loads the fonts and icons */
+  goo_canvas_render (GOO_CANVAS (canvas), cr, NULL, 1.0);
+  for (guint i = 0; i < PAINTS; i++) {
+    gint64 start = g_get_monotonic_time ();
+
+    goo_canvas_render (GOO_CANVAS (canvas), cr, NULL, 1.0);
+    total += g_get_monotonic_time () - start;
+  }
+  cairo_destroy (cr);
+  cairo_surface_destroy (surface);
+
+  g_print ("%6u elements, %-7s: %5.1f canvas items and %7.1f bytes per "
+      "element, paint %9.1f us (%6.2f us per element)\n", n,
+      compact ? "compact" : "normal", (gdouble) n_items / MAX (n, 1),
+      (gdouble) bytes / MAX (n, 1), (gdouble) total / PAINTS,
+      (gdouble) total / PAINTS / MAX (n, 1));
+
+  gtk_widget_destroy (GTK_WIDGET (canvas));
+  g_object_unref (canvas);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (!gtk_init_check (&argc, &argv)) {
+    g_print ("No display, skipping\n");
+    /* the automake exit status of a skipped test */
+    return 77;
+  }
+  gst_init (&argc, &argv);
+  gste_init ();
+
+  for (guint i = 0; i < G_N_ELEMENTS (sizes); i++) {
+    run (sizes[i], FALSE);
+    run (sizes[i], TRUE);
+  }
+
+  return 0;
+}
@@ -0,0 +1,232 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Checks the main thread dispatch (gsteditordispatch.c) under a storm
+ * of records pushed by several threads at once:
+ *  - every record runs exactly once, in the main thread and in the
+ *    order its thread pushed it
+ *  - the objects of a record are released once it has run
+ *  - a record dispatched in the main thread runs after all records
+ *    queued before it, also when it is dispatched by a queued record
+ * Exits with 1 on the first failure.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <gst/gst.h>
+
+#include "gsteditordispatch.h"
+
+#define N_THREADS 8
+#define N_RECORDS 10000
+/* fails instead of hanging (s) */
+#define TIMEOUT 60
+
+typedef struct
+{
+  GObject *target;
+  guint n_records;
+  /* main thread only */
+  guint next;
+  /* dispatch nested_cb from the first record */
+  gboolean nest;
+} Producer;
+
+static GThread *main_thread;
+static GMainLoop *loop;
+static GQuark seq_quark, producer_quark;
+static guint n_run, n_expected;
+static gint n_freed;
+
+#define check(expr) G_STMT_START {					\
+  if (!(expr)) {							\
+    g_printerr ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr);\
+    exit (1);								\
+  }									\
+} G_STMT_END
+
+static gboolean
+timeout_cb (gpointer user_data)
+{
+  g_printerr ("Timed out after %d s\n", TIMEOUT);
+  exit (1);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+freed_cb (gpointer data, GObject * where_the_object_was)
+{
+  g_atomic_int_inc (&n_freed);
+}
+
+/* runs after the rest of the batch the record that dispatched it was in */
+static void
+nested_cb (gpointer target, gpointer a, gpointer b)
+{
+  Producer *producer = g_object_get_qdata (target, producer_quark);
+
+  check (g_thread_self () == main_thread);
+  check (producer->next == producer->n_records);
+  n_run++;
+}
+
+static void
+seq_cb (gpointer target, gpointer a, gpointer b)
+{
+  Producer *producer = g_object_get_qdata (target, producer_quark);
+  guint seq = GPOINTER_TO_UINT (g_object_get_qdata (a, seq_quark));
+
+  check (g_thread_self () == main_thread);
+  check (b == NULL);
+  check (seq == producer->next);
+  producer->next++;
+  n_run++;
+
+  if (producer->nest && seq == 0) {
+    gst_editor_dispatch (nested_cb, target, NULL, NULL);
+    check (producer->next == producer->n_records);
+  }
+
+  if (n_run == n_expected)
+    g_main_loop_quit (loop);
+}
+
+/* the last record of a producer that is not waited for */
+static void
+last_cb (gpointer target, gpointer a, gpointer b)
+{
+  Producer *producer = g_object_get_qdata (target, producer_quark);
+
+  check (g_thread_self () == main_thread);
+  check (producer->next == producer->n_records);
+  n_run++;
+}
+
+static gpointer
+producer_func (gpointer user_data)
+{
+  Producer *producer = user_data;
+
+  for (guint i = 0; i < producer->n_records; i++) {
+    GstPad *pad = gst_pad_new (NULL, GST_PAD_SRC);
+
+    gst_object_ref_sink (pad);
+    g_object_set_qdata (G_OBJECT (pad), seq_quark, GUINT_TO_POINTER (i));
+    g_object_weak_ref (G_OBJECT (pad), freed_cb, NULL);
+    gst_editor_dispatch (seq_cb, producer->target, pad, NULL);
+    gst_object_unref (pad);
+  }
+
+  return NULL;
+}
+
+static Producer *
+producer_new (guint n_records, gboolean nest)
+{
+  Producer *producer = g_new0 (Producer, 1);
+
+  producer->target = g_object_new (G_TYPE_OBJECT, NULL);
+  g_object_set_qdata (producer->target, producer_quark, producer);
+  g_object_weak_ref (producer->target, freed_cb, NULL);
+  producer->n_records = n_records;
+  producer->nest = nest;
+
+  return producer;
+}
+
+static void
+check_storm (void)
+{
+  Producer *producers[N_THREADS];
+  GThread *threads[N_THREADS];
+
+  n_run = n_freed = 0;
+  n_expected = N_THREADS * N_RECORDS;
+
+  for (guint i = 0; i < N_THREADS; i++) {
+    producers[i] = producer_new (N_RECORDS, FALSE);
+    threads[i] = g_thread_new ("producer", producer_func, producers[i]);
+  }
+
+  g_main_loop_run (loop);
+
+  for (guint i = 0; i < N_THREADS; i++) {
+    g_thread_join (threads[i]);
+    check (producers[i]->next == N_RECORDS);
+    g_object_unref (producers[i]->target);
+    g_free (producers[i]);
+  }
+
+  check (n_run == n_expected);
+  /* the pads and the targets */
+  check (g_atomic_int_get (&n_freed) == N_THREADS * (N_RECORDS + 1));
+}
+
+static void
+check_main_thread (void)
+{
+  Producer *producer;
+  GThread *thread;
+
+  n_run = n_freed = 0;
+  n_expected = G_MAXUINT;
+
+  /* queued, but not drained yet */
+  producer = producer_new (N_RECORDS, TRUE);
+  thread = g_thread_new ("producer", producer_func, producer);
+  g_thread_join (thread);
+  check (producer->next == 0);
+
+  /* runs the queued records first, which dispatch nested_cb */
+  gst_editor_dispatch (last_cb, producer->target, NULL, NULL);
+  check (n_run == N_RECORDS + 2);
+
+  /* the drain scheduled by the producer has nothing left to do */
+  while (g_main_context_iteration (NULL, FALSE));
+  check (n_run == N_RECORDS + 2);
+
+  g_object_unref (producer->target);
+  g_free (producer);
+  check (g_atomic_int_get (&n_freed) == N_RECORDS + 1);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gst_init (&argc, &argv);
+
+  main_thread = g_thread_self ();
+  gst_editor_dispatch_init ();
+  seq_quark = g_quark_from_static_string ("dispatch-check-seq");
+  producer_quark = g_quark_from_static_string ("dispatch-check-producer");
+
+  loop = g_main_loop_new (NULL, FALSE);
+  g_timeout_add_seconds (TIMEOUT, timeout_cb, NULL);
+
+  check_storm ();
+  check_main_thread ();
+
+  g_main_loop_unref (loop);
+
+  g_print ("dispatch: OK\n");
+
+  return 0;
+}
@@ -0,0 +1,231 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Checks the background layout (gsteditorlayout.c) on a pipeline large
+ * enough for the repulsion forces to be split across the thread pool:
+ *  - a layout runs to the end, calls its callback once and leaves every
+ *    element inside its bin
+ *  - layouts stopped at arbitrary points never call their callback
+ *  - elements removed while a layout runs are skipped
+ * Exits with 1 on the first failure.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+
+#include <gst/editor/editor.h>
+
+#include "gsteditorlayout.h"
+
+#define CHAIN_LENGTH 10
+#define N_ELEMENTS 1000
+#define N_STOPS 50
+#define N_REMOVED 20
+/* fails instead of hanging (s) */
+#define TIMEOUT 120
+
+static GMainLoop *loop;
+static guint n_finished;
+
+#define check(expr) G_STMT_START {					\
+  if (!(expr)) {							\
+    g_printerr ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr);\
+    exit (1);								\
+  }									\
+} G_STMT_END
+
+/* n_elements elements in chains of fakesrc ! identity ! ... ! fakesink */
+static GstElement *
+make_pipeline (guint n_elements)
+{
+  GstElement *pipeline = gst_pipeline_new (NULL);
+  GstElement *prev = NULL;
+
+  for (guint i = 0; i < n_elements; i++) {
+    const gchar *factory;
+    GstElement *element;
+
+    if (i % CHAIN_LENGTH == 0)
+      factory = "fakesrc";
+    else if (i % CHAIN_LENGTH == CHAIN_LENGTH - 1 || i == n_elements - 1)
+      factory = "fakesink";
+    else
+      factory = "identity";
+
+    element = gst_element_factory_make (factory, NULL);
+    if (!element) {
+      g_printerr ("Could not create a %s element\n", factory);
+      exit (1);
+    }
+    gst_bin_add (GST_BIN (pipeline), element);
+    if (prev && i % CHAIN_LENGTH != 0)
+      gst_element_link (prev, element);
+    prev = element;
+  }
+
+  return pipeline;
+}
+
+static gboolean
+timeout_cb (gpointer user_data)
+{
+  g_printerr ("Timed out after %d s\n", TIMEOUT);
+  exit (1);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+finished_cb (GstEditorLayout * layout, gpointer user_data)
+{
+  n_finished++;
+  gst_editor_layout_stop (layout);
+  g_main_loop_quit (loop);
+}
+
+static void
+check_inside (GstEditorBin * bin)
+{
+  GstEditorItem *item = GST_EDITOR_ITEM (bin);
+
+  for (guint i = 0; i < bin->sort.len; i++) {
+    GstEditorItem *child = GST_EDITOR_ITEM (bin->sort.elements[i]);
+    cairo_matrix_t matrix;
+
+    cairo_matrix_init_identity (&matrix);
+    goo_canvas_item_get_transform (GOO_CANVAS_ITEM (child), &matrix);
+
+    check (isfinite (matrix.x0) && isfinite (matrix.y0));
+    check (matrix.x0 >= item->l.w - 0.5);
+    check (matrix.y0 >= item->t.h - 0.5);
+    check (matrix.x0 + child->width <= item->width - item->r.w + 0.5);
+    check (matrix.y0 + child->height <= item->height - item->b.h + 0.5);
+  }
+}
+
+/* runs a layout of bin to the end */
+static void
+run_layout (GstEditorBin * bin)
+{
+  n_finished = 0;
+  gst_editor_layout_heat (&bin->sort);
+  gst_editor_layout_start (bin, finished_cb, NULL);
+  g_main_loop_run (loop);
+  check (n_finished == 1);
+}
+
+static void
+check_converge (GstEditorBin * bin)
+{
+  run_layout (bin);
+  check_inside (bin);
+}
+
+static void
+check_stop (GstEditorBin * bin)
+{
+  gint64 end;
+
+  n_finished = 0;
+  for (guint i = 0; i < N_STOPS; i++) {
+    GstEditorLayout *layout;
+
+    gst_editor_layout_heat (&bin->sort);
+    layout = gst_editor_layout_start (bin, finished_cb, NULL);
+    /* some are stopped before any frame, some in the middle */
+    for (guint j = 0; j < i % 5; j++)
+      g_main_context_iteration (NULL, FALSE);
+    if (i % 7 == 0)
+      g_usleep (10 * G_TIME_SPAN_MILLISECOND);
+    gst_editor_layout_stop (layout);
+  }
+
+  /* nothing may be left to call back */
+  end = g_get_monotonic_time () + 200 * G_TIME_SPAN_MILLISECOND;
+  while (g_get_monotonic_time () < end)
+    g_main_context_iteration (NULL, FALSE);
+
+  check (n_finished == 0);
+  check_inside (bin);
+}
+
+static void
+check_remove (GstEditorBin * bin)
+{
+  GstBin *pipeline = GST_BIN (GST_EDITOR_ITEM (bin)->object);
+  guint len = bin->sort.len;
+
+  n_finished = 0;
+  gst_editor_layout_heat (&bin->sort);
+  gst_editor_layout_start (bin, finished_cb, NULL);
+
+  /* removed from the canvas while the layout thread works on a snapshot */
+  for (guint i = 0; i < N_REMOVED; i++) {
+    GList *children = pipeline->children;
+
+    g_main_context_iteration (NULL, FALSE);
+    gst_bin_remove (pipeline, GST_ELEMENT (children->data));
+  }
+
+  g_main_loop_run (loop);
+  check (n_finished == 1);
+  check (bin->sort.len == len - N_REMOVED);
+  check_inside (bin);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GstEditorCanvas *canvas;
+  GtkWidget *window;
+
+  if (!gtk_init_check (&argc, &argv)) {
+    g_print ("No display, skipping\n");
+    /* the automake exit status of a skipped test */
+    return 77;
+  }
+  gst_init (&argc, &argv);
+  gste_init ();
+
+  loop = g_main_loop_new (NULL, FALSE);
+  g_timeout_add_seconds (TIMEOUT, timeout_cb, NULL);
+
+  /* layouts are applied from the tick callback of the mapped canvas */
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 800, 600);
+  canvas = g_object_new (GST_TYPE_EDITOR_CANVAS, NULL);
+  gtk_container_add (GTK_CONTAINER (window), GTK_WIDGET (canvas));
+  g_object_set (canvas, "bin", make_pipeline (N_ELEMENTS), NULL);
+  gtk_widget_show_all (window);
+
+  check_converge (canvas->bin);
+  check_stop (canvas->bin);
+  check_remove (canvas->bin);
+
+  gtk_widget_destroy (window);
+  g_main_loop_unref (loop);
+
+  g_print ("layout: OK\n");
+
+  return 0;
+}
@@ -0,0 +1,173 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Times loading synthetic save files of 100, 1000 and 10000 elements,
+ * split into parsing (gst_editor_canvas_load_parse()) and showing the
+ * pipeline on a canvas (gst_editor_canvas_load_apply()). With linear
+ * loading the time per element stays roughly the same for all sizes.
+ *
+ * "load-bench --generate N FILE" only writes a save file of N elements,
+ * e.g. to open it in the editor.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+
+#include <gst/editor/editor.h>
+
+#define CHAIN_LENGTH 10
+
+static const guint sizes[] = { 100, 1000, 10000 };
+
+/*
+ * Writes a save file with n_elements elements in chains of
+ * fakesrc ! identity ! ... ! fakesink, laid out in a grid with one
+ * chain per row.
+ */
+static gboolean
+generate (guint n_elements, const gchar * filename, GError ** error)
+{
+  GKeyFile *key_file = g_key_file_new ();
+  GString *pipeline = g_string_new (NULL);
+  gboolean ret;
+
+  g_key_file_set_string (key_file, PACKAGE_NAME, "Version", PACKAGE_VERSION);
+
+  for (guint i = 0; i < n_elements; i++) {
+    const gchar *factory;
+    gchar *group;
+
+    if (i % CHAIN_LENGTH == 0)
+      factory = "fakesrc";
+    else if (i % CHAIN_LENGTH == CHAIN_LENGTH - 1 || i == n_elements - 1)
+      factory = "fakesink";
+    else
+      factory = "identity";
+
+    if (i % CHAIN_LENGTH != 0)
+      g_string_append (pipeline, " ! ");
+    else if (i > 0)
+      g_string_append_c (pipeline, ' ');
+    g_string_append_printf (pipeline, "%s name=e%u", factory, i);
+
+    group = g_strdup_printf ("Element:e%u", i);
+    g_key_file_set_double (key_file, group, "X", (i % CHAIN_LENGTH) * 120.0);
+    g_key_file_set_double (key_file, group, "Y", (i / CHAIN_LENGTH) * 80.0);
+    g_key_file_set_double (key_file, group, "Width", 100.0);
+    g_key_file_set_double (key_file, group, "Height", 60.0);
+    g_free (group);
+  }
+
+  g_key_file_set_string (key_file, PACKAGE_NAME, "Pipeline", pipeline->str);
+  g_key_file_set_boolean (key_file, PACKAGE_NAME, "Autosize", FALSE);
+
+  ret = g_key_file_save_to_file (key_file, filename, error);
+  g_string_free (pipeline, TRUE);
+  g_key_file_free (key_file);
+
+  return ret;
+}
+
+static void
+run (guint n_elements, const gchar * dirname)
+{
+  GstEditorCanvasLoad *load;
+  GstEditorCanvas *canvas;
+  GKeyFile *key_file;
+  GError *error = NULL;
+  gchar *basename, *filename;
+  gint64 start, parsed, applied;
+
+  basename = g_strdup_printf ("bench-%u.gep", n_elements);
+  filename = g_build_filename (dirname, basename, NULL);
+  g_free (basename);
+  if (!generate (n_elements, filename, &error)) {
+    g_printerr ("Could not write %s: %s\n", filename, error->message);
+    exit (1);
+  }
+
+  canvas = g_object_new (GST_TYPE_EDITOR_CANVAS, NULL);
+  g_object_ref_sink (canvas);
+
+  start = g_get_monotonic_time ();
+  key_file = g_key_file_new ();
+  if (!g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE, &error)
+      || !(load = gst_editor_canvas_load_parse (key_file, filename, FALSE,
+              &error))) {
+    g_printerr ("Could not load %s: %s\n", filename, error->message);
+    exit (1);
+  }
+  g_key_file_free (key_file);
+  parsed = g_get_monotonic_time ();
+
+  gst_editor_canvas_load_apply (canvas, load);
+  gst_editor_canvas_load_free (load);
+  applied = g_get_monotonic_time ();
+
+  g_print ("%6u elements: parse %9.1f ms (%6.2f us per element), "
+      "apply %9.1f ms (%6.2f us per element)\n", n_elements,
+      (parsed - start) / 1000.0, (gdouble) (parsed - start) / n_elements,
+      (applied - parsed) / 1000.0, (gdouble) (applied - parsed) / n_elements);
+
+  gtk_widget_destroy (GTK_WIDGET (canvas));
+  g_object_unref (canvas);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  gchar *dirname;
+
+  if (argc == 4 && g_str_equal (argv[1], "--generate")) {
+    if (!generate (strtoul (argv[2], NULL, 10), argv[3], &error)) {
+      g_printerr ("Could not write %s: %s\n", argv[3], error->message);
+      return 1;
+    }
+    return 0;
+  }
+
+  if (!gtk_init_check (&argc, &argv)) {
+    g_print ("No display, skipping\n");
+    /* the automake exit status of a skipped test */
+    return 77;
+  }
+  gst_init (&argc, &argv);
+  gste_init ();
+
+  if (!(dirname = g_dir_make_tmp ("gst-editor-bench-XXXXXX", &error))) {
+    g_printerr ("Could not create a temporary directory: %s\n",
+        error->message);
+    return 1;
+  }
+
+  for (guint i = 0; i < G_N_ELEMENTS (sizes); i++)
+    run (sizes[i], dirname);
+
+  g_rmdir (dirname);
+  g_free (dirname);
+
+  return 0;
+}
@@ -0,0 +1,305 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Checks the asynchronous loader (gsteditorloader.c) on a save file
+ * large enough to be realized in several slices:
+ *  - a load reports increasing progress up to 1, finishes once and
+ *    leaves the whole pipeline on a thawed canvas
+ *  - loads stopped while the worker thread parses never call back and
+ *    leave the canvas alone, even when the next load has been started
+ *  - a load stopped while realizing leaves an empty pipeline
+ *  - a missing file finishes with an error
+ * Exits with 1 on the first failure.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+
+#include <gst/editor/editor.h>
+
+#include "gsteditorloader.h"
+
+#define CHAIN_LENGTH 10
+#define N_ELEMENTS 5000
+#define N_STOPS 20
+/* fails instead of hanging (s) */
+#define TIMEOUT 120
+
+typedef struct
+{
+  guint n_progress, n_finished;
+  gdouble fraction;
+  gboolean error;
+  /* quit the main loop on the first progress */
+  gboolean quit_on_progress;
+} LoadState;
+
+static GMainLoop *loop;
+
+#define check(expr) G_STMT_START {					\
+  if (!(expr)) {							\
+    g_printerr ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr);\
+    exit (1);								\
+  }									\
+} G_STMT_END
+
+/*
+ * Writes a save file with n_elements elements in chains of
+ * fakesrc ! identity ! ... ! fakesink, laid out in a grid with one
+ * chain per row.
+ */
+static gboolean
+generate (guint n_elements, const gchar * filename, GError ** error)
+{
+  GKeyFile *key_file = g_key_file_new ();
+  GString *pipeline = g_string_new (NULL);
+  gboolean ret;
+
+  g_key_file_set_string (key_file, PACKAGE_NAME, "Version", PACKAGE_VERSION);
+
+  for (guint i = 0; i < n_elements; i++) {
+    const gchar *factory;
+    gchar *group;
+
+    if (i % CHAIN_LENGTH == 0)
+      factory = "fakesrc";
+    else if (i % CHAIN_LENGTH == CHAIN_LENGTH - 1 || i == n_elements - 1)
+      factory = "fakesink";
+    else
+      factory = "identity";
+
+    if (i % CHAIN_LENGTH != 0)
+      g_string_append (pipeline, " ! ");
+    else if (i > 0)
+      g_string_append_c (pipeline, ' ');
+    g_string_append_printf (pipeline, "%s name=e%u", factory, i);
+
+    group = g_strdup_printf ("Element:e%u", i);
+    g_key_file_set_double (key_file, group, "X", (i % CHAIN_LENGTH) * 120.0);
+    g_key_file_set_double (key_file, group, "Y", (i / CHAIN_LENGTH) * 80.0);
+    g_key_file_set_double (key_file, group, "Width", 100.0);
+    g_key_file_set_double (key_file, group, "Height", 60.0);
+    g_free (group);
+  }
+
+  g_key_file_set_string (key_file, PACKAGE_NAME, "Pipeline", pipeline->str);
+  g_key_file_set_boolean (key_file, PACKAGE_NAME, "Autosize", FALSE);
+
+  ret = g_key_file_save_to_file (key_file, filename, error);
+  g_string_free (pipeline, TRUE);
+  g_key_file_free (key_file);
+
+  return ret;
+}
+
+static gboolean
+timeout_cb (gpointer user_data)
+{
+  g_printerr ("Timed out after %d s\n", TIMEOUT);
+  exit (1);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+progress_cb (GstEditorLoader * loader, gdouble fraction, gpointer user_data)
+{
+  LoadState *state = user_data;
+
+  check (fraction >= state->fraction && fraction <= 1.);
+  state->fraction = fraction;
+  state->n_progress++;
+
+  if (state->quit_on_progress && fraction < 1.)
+    g_main_loop_quit (loop);
+}
+
+static void
+finished_cb (GstEditorLoader * loader, const GError * error,
+    gpointer user_data)
+{
+  LoadState *state = user_data;
+
+  state->n_finished++;
+  state->error = error != NULL;
+  gst_editor_loader_stop (loader);
+  g_main_loop_quit (loop);
+}
+
+static guint
+n_children (GstEditorCanvas * canvas)
+{
+  return GST_BIN (gst_editor_canvas_get_pipeline (canvas))->numchildren;
+}
+
+static void
+check_thawed (GstEditorCanvas * canvas)
+{
+  check (canvas->freeze_count == 0);
+  check (!canvas->progressive);
+  check (g_queue_is_empty (&canvas->deferred));
+}
+
+static void
+check_load (GstEditorCanvas * canvas, const gchar * filename)
+{
+  LoadState state = { 0, };
+
+  gst_editor_loader_start (canvas, filename, progress_cb, finished_cb,
+      &state);
+  g_main_loop_run (loop);
+
+  check (state.n_finished == 1);
+  check (!state.error);
+  /* realized in several slices */
+  check (state.n_progress > 1);
+  check (state.fraction == 1.);
+  check (n_children (canvas) == N_ELEMENTS);
+  check (canvas->bin->sort.len == N_ELEMENTS);
+  check_thawed (canvas);
+}
+
+static void
+check_stop_parsing (GstEditorCanvas * canvas, const gchar * filename)
+{
+  static LoadState states[N_STOPS];
+  GstElement *pipeline = gst_editor_canvas_get_pipeline (canvas);
+  gint64 end;
+
+  for (guint i = 0; i < N_STOPS; i++) {
+    GstEditorLoader *loader;
+
+    loader = gst_editor_loader_start (canvas, filename, progress_cb,
+        finished_cb, &states[i]);
+    /* some are stopped before the worker starts, some while it parses */
+    if (i % 2)
+      g_usleep (i * G_TIME_SPAN_MILLISECOND);
+    gst_editor_loader_stop (loader);
+  }
+
+  /* let the workers return */
+  end = g_get_monotonic_time () + 2 * G_TIME_SPAN_SECOND;
+  while (g_get_monotonic_time () < end)
+    g_main_context_iteration (NULL, FALSE);
+
+  for (guint i = 0; i < N_STOPS; i++)
+    check (states[i].n_progress == 0 && states[i].n_finished == 0);
+  check (gst_editor_canvas_get_pipeline (canvas) == pipeline);
+  check_thawed (canvas);
+}
+
+static void
+check_stop_realizing (GstEditorCanvas * canvas, const gchar * filename)
+{
+  LoadState state = { 0, };
+  GstEditorLoader *loader;
+  gint64 end;
+
+  state.quit_on_progress = TRUE;
+  loader = gst_editor_loader_start (canvas, filename, progress_cb,
+      finished_cb, &state);
+  g_main_loop_run (loop);
+
+  check (state.n_finished == 0);
+  check (state.fraction < 1.);
+  gst_editor_loader_stop (loader);
+
+  end = g_get_monotonic_time () + 200 * G_TIME_SPAN_MILLISECOND;
+  while (g_get_monotonic_time () < end)
+    g_main_context_iteration (NULL, FALSE);
+
+  check (state.n_finished == 0);
+  check (n_children (canvas) == 0);
+  check_thawed (canvas);
+}
+
+static void
+check_missing (GstEditorCanvas * canvas, const gchar * filename)
+{
+  LoadState state = { 0, };
+
+  gst_editor_loader_start (canvas, filename, progress_cb, finished_cb,
+      &state);
+  g_main_loop_run (loop);
+
+  check (state.n_finished == 1);
+  check (state.error);
+  check (state.n_progress == 0);
+  check_thawed (canvas);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GstEditorCanvas *canvas;
+  GError *error = NULL;
+  gchar *dirname, *filename, *missing;
+
+  if (!gtk_init_check (&argc, &argv)) {
+    g_print ("No display, skipping\n");
+    /* the automake exit status of a skipped test */
+    return 77;
+  }
+  gst_init (&argc, &argv);
+  gste_init ();
+
+  loop = g_main_loop_new (NULL, FALSE);
+  g_timeout_add_seconds (TIMEOUT, timeout_cb, NULL);
+
+  if (!(dirname = g_dir_make_tmp ("gst-editor-check-XXXXXX", &error))) {
+    g_printerr ("Could not create a temporary directory: %s\n",
+        error->message);
+    return 1;
+  }
+  filename = g_build_filename (dirname, "loader.gep", NULL);
+  missing = g_build_filename (dirname, "missing.gep", NULL);
+  if (!generate (N_ELEMENTS, filename, &error)) {
+    g_printerr ("Could not write %s: %s\n", filename, error->message);
+    return 1;
+  }
+
+  canvas = g_object_new (GST_TYPE_EDITOR_CANVAS, NULL);
+  g_object_ref_sink (canvas);
+  g_object_set (canvas, "bin", gst_pipeline_new (NULL), NULL);
+
+  check_load (canvas, filename);
+  check_stop_parsing (canvas, filename);
+  check_stop_realizing (canvas, filename);
+  check_missing (canvas, missing);
+  /* the canvas is still usable */
+  check_load (canvas, filename);
+
+  gtk_widget_destroy (GTK_WIDGET (canvas));
+  g_object_unref (canvas);
+  g_main_loop_unref (loop);
+
+  g_unlink (filename);
+  g_rmdir (dirname);
+  g_free (missing);
+  g_free (filename);
+  g_free (dirname);
+
+  g_print ("loader: OK\n");
+
+  return 0;
+}
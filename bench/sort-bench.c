@@ -0,0 +1,127 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Times one gst_editor_bin_sort() step on synthetic pipelines of
+ * 100, 1000 and 10000 elements. The pipelines consist of linked chains
+ * of CHAIN_LENGTH elements, all placed at the same spot, so every step
+ * has both link and repulsion forces to compute. With a linear sort
+ * step the time per element stays roughly the same for all sizes.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+
+#include <gst/editor/editor.h>
+
+#include "gsteditorlayout.h"
+
+#define CHAIN_LENGTH 10
+#define STEPS 5
+
+static const guint sizes[] = { 100, 1000, 10000 };
+
+/* n_elements elements in chains of fakesrc ! identity ! ... ! fakesink */
+static GstElement *
+make_pipeline (guint n_elements)
+{
+  GstElement *pipeline = gst_pipeline_new (NULL);
+  GstElement *prev = NULL;
+
+  for (guint i = 0; i < n_elements; i++) {
+    const gchar *factory;
+    GstElement *element;
+
+    if (i % CHAIN_LENGTH == 0)
+      factory = "fakesrc";
+    else if (i % CHAIN_LENGTH == CHAIN_LENGTH - 1 || i == n_elements - 1)
+      factory = "fakesink";
+    else
+      factory = "identity";
+
+    element = gst_element_factory_make (factory, NULL);
+    if (!element) {
+      g_printerr ("Could not create a %s element\n", factory);
+      exit (1);
+    }
+    gst_bin_add (GST_BIN (pipeline), element);
+    if (prev && i % CHAIN_LENGTH != 0)
+      gst_element_link (prev, element);
+    prev = element;
+  }
+
+  return pipeline;
+}
+
+static void
+run (guint n_elements)
+{
+  GstEditorCanvas *canvas;
+  GstEditorBin *bin;
+  GstElement *pipeline;
+  gint64 total = 0;
+
+  pipeline = make_pipeline (n_elements);
+  canvas = g_object_new (GST_TYPE_EDITOR_CANVAS, NULL);
+  g_object_ref_sink (canvas);
+  gst_editor_canvas_freeze (canvas);
+  g_object_set (canvas, "bin", pipeline, NULL);
+  gst_editor_canvas_thaw (canvas);
+  bin = canvas->bin;
+
+  /* the first step is not timed, it lets the allocations settle */
+  gst_editor_layout_heat (&bin->sort);
+  gst_editor_bin_sort (bin);
+
+  for (guint i = 0; i < STEPS; i++) {
+    gint64 start;
+
+    /* keep the bin from settling between the steps */
+    gst_editor_layout_heat (&bin->sort);
+    start = g_get_monotonic_time ();
+    gst_editor_bin_sort (bin);
+    total += g_get_monotonic_time () - start;
+  }
+
+  g_print ("%6u elements: %10.1f us per step, %6.3f us per element\n",
+      bin->sort.len, (gdouble) total / STEPS,
+      (gdouble) total / STEPS / MAX (bin->sort.len, 1));
+
+  gtk_widget_destroy (GTK_WIDGET (canvas));
+  g_object_unref (canvas);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (!gtk_init_check (&argc, &argv)) {
+    g_print ("No display, skipping\n");
+    /* the automake exit status of a skipped test */
+    return 77;
+  }
+  gst_init (&argc, &argv);
+  gste_init ();
+
+  for (guint i = 0; i < G_N_ELEMENTS (sizes); i++)
+    run (sizes[i]);
+
+  return 0;
+}
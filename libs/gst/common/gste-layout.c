@@ -0,0 +1,591 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Deterministic layered (Sugiyama-style) layout of GStreamer bins.
+ * This works on the GstBin hierarchy alone, so pipelines can be
+ * laid out without any canvas (e.g. from the command line).
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <gst/gst.h>
+
+#include "gste-serialize.h"
+#include "gste-layout.h"
+#include "gste-metadata.h"
+#include "gste-placeholder.h"
+
+/* space between the bin border and its children */
+#define LAYERED_MARGIN_X      20.
+#define LAYERED_MARGIN_TOP    30.
+#define LAYERED_MARGIN_BOTTOM 30.
+/* space between layers and between elements of a layer */
+#define LAYERED_SPACING_X     60.
+#define LAYERED_SPACING_Y     20.
+/* number of barycenter sweeps for crossing reduction */
+#define LAYERED_SWEEPS        8
+
+/* the minimum size of a GstEditorBin */
+#define LAYERED_BIN_WIDTH     300.
+#define LAYERED_BIN_HEIGHT    125.
+
+typedef struct _LayeredNode {
+  /* NULL for dummy nodes splitting links across several layers */
+  GstObject *object;
+  gdouble width, height;
+
+  gint rank;
+  guint index;                  /* position in the layer */
+  gdouble barycenter;
+  gdouble x, y;
+
+  /* node indices of neighbours in adjacent layers */
+  GArray *preds, *succs;
+} LayeredNode;
+
+typedef struct _LayeredEdge {
+  guint src, sink;
+} LayeredEdge;
+
+static void
+layered_node_free (LayeredNode * node)
+{
+  g_array_free (node->preds, TRUE);
+  g_array_free (node->succs, TRUE);
+  g_free (node);
+}
+
+static guint
+layered_node_add (GPtrArray * nodes, GstObject * object,
+    gdouble width, gdouble height)
+{
+  LayeredNode *node = g_new0 (LayeredNode, 1);
+
+  node->object = object;
+  node->width = width;
+  node->height = height;
+  node->preds = g_array_new (FALSE, FALSE, sizeof (guint));
+  node->succs = g_array_new (FALSE, FALSE, sizeof (guint));
+  g_ptr_array_add (nodes, node);
+
+  return nodes->len - 1;
+}
+
+static void
+layered_node_link (GPtrArray * nodes, guint src, guint sink)
+{
+  LayeredNode *src_node = g_ptr_array_index (nodes, src);
+  LayeredNode *sink_node = g_ptr_array_index (nodes, sink);
+
+  g_array_append_val (src_node->succs, sink);
+  g_array_append_val (sink_node->preds, src);
+}
+
+/*
+ * GstEditorBin only renders plain GstBins and GstPipelines
+ * as bins by default.
+ */
+static inline gboolean
+layered_child_as_bin (GstObject * child)
+{
+  return G_OBJECT_TYPE (child) == GST_TYPE_BIN ||
+      G_OBJECT_TYPE (child) == GST_TYPE_PIPELINE;
+}
+
+/*
+ * Roughly what a GstEditorElement needs for its title,
+ * pads and state icons.
+ * The editor computes the real element sizes on its own.
+ */
+static void
+layered_element_size (GstElement * element, gdouble * width, gdouble * height)
+{
+  guint sinks = 0, srcs = 0;
+  gsize sink_len = 0, src_len = 0;
+
+  for (GList *l = GST_ELEMENT_PADS (element); l; l = g_list_next (l)) {
+    GstPad *pad = GST_PAD_CAST (l->data);
+    gsize len = strlen (GST_OBJECT_NAME (pad));
+
+    if (gst_pad_get_direction (pad) == GST_PAD_SRC) {
+      srcs++;
+      src_len = MAX (src_len, len);
+    } else {
+      sinks++;
+      sink_len = MAX (sink_len, len);
+    }
+  }
+
+  *width = MAX (strlen (GST_OBJECT_NAME (element)) * 7. + 20.,
+      (sink_len + src_len) * 7. + 40.);
+  *width = MAX (*width, 4 * 18. + 10.);
+  *height = 20. + 18. + 6. + MAX (sinks, srcs) * 16.;
+}
+
+/*
+ * Find the direct child of bin containing object.
+ */
+static GstObject *
+layered_find_child (GstBin * bin, GstObject * object)
+{
+  while (object && GST_OBJECT_PARENT (object) != GST_OBJECT_CAST (bin))
+    object = GST_OBJECT_PARENT (object);
+
+  return object;
+}
+
+static gint
+layered_compare_barycenter (gconstpointer a, gconstpointer b,
+    gpointer user_data)
+{
+  GPtrArray *nodes = user_data;
+  LayeredNode *node_a = g_ptr_array_index (nodes, *(const guint *) a);
+  LayeredNode *node_b = g_ptr_array_index (nodes, *(const guint *) b);
+
+  if (node_a->barycenter < node_b->barycenter)
+    return -1;
+  return node_a->barycenter > node_b->barycenter;
+}
+
+/*
+ * Order a layer by the barycenters of the neighbours in the
+ * preceding (down) or following (!down) layer.
+ * The sort is stable, so the order is deterministic.
+ */
+static void
+layered_sort_layer (GPtrArray * nodes, GArray * layer, gboolean down)
+{
+  for (guint i = 0; i < layer->len; i++) {
+    LayeredNode *node = g_ptr_array_index (nodes, g_array_index (layer, guint, i));
+    GArray *neighbours = down ? node->preds : node->succs;
+
+    if (neighbours->len == 0) {
+      node->barycenter = node->index;
+      continue;
+    }
+
+    node->barycenter = 0;
+    for (guint j = 0; j < neighbours->len; j++) {
+      LayeredNode *neighbour = g_ptr_array_index (nodes,
+          g_array_index (neighbours, guint, j));
+      node->barycenter += neighbour->index;
+    }
+    node->barycenter /= neighbours->len;
+  }
+
+  g_array_sort_with_data (layer, layered_compare_barycenter, nodes);
+
+  for (guint i = 0; i < layer->len; i++) {
+    LayeredNode *node = g_ptr_array_index (nodes, g_array_index (layer, guint, i));
+    node->index = i;
+  }
+}
+
+static void
+layered_layout_bin (GstBin * bin, GHashTable * boxes,
+    gdouble * bin_width, gdouble * bin_height)
+{
+  GPtrArray *nodes = g_ptr_array_new_with_free_func ((GDestroyNotify) layered_node_free);
+  GHashTable *node_index = g_hash_table_new (NULL, NULL);
+  GArray *edges = g_array_new (FALSE, FALSE, sizeof (LayeredEdge));
+  GPtrArray *out_edges;
+  GPtrArray *layers;
+  GQueue ready = G_QUEUE_INIT;
+  guint *in_degree;
+  gboolean *ranked;
+  guint num_children, num_ranked = 0, cursor = 0;
+  gint max_rank = 0;
+  gdouble x, max_x = 0, max_y = 0;
+
+  /*
+   * Every child becomes a node. Child bins are laid out
+   * recursively first since we need their sizes.
+   * Children are iterated in the order they have been added.
+   */
+  for (GList *l = g_list_last (GST_BIN_CHILDREN (bin)); l; l = g_list_previous (l)) {
+    GstObject *child = GST_OBJECT_CAST (l->data);
+    gdouble width, height;
+
+    if (layered_child_as_bin (child))
+      layered_layout_bin (GST_BIN (child), boxes, &width, &height);
+    else
+      layered_element_size (GST_ELEMENT (child), &width, &height);
+
+    g_hash_table_insert (node_index, child,
+        GUINT_TO_POINTER (layered_node_add (nodes, child, width, height) + 1));
+  }
+  num_children = nodes->len;
+
+  /*
+   * Collect the links between children along src -> sink.
+   * Links into child bins lead to their ghost pads.
+   * Links leaving this bin are ignored.
+   */
+  out_edges = g_ptr_array_new_with_free_func ((GDestroyNotify) g_array_unref);
+  for (guint i = 0; i < num_children; i++) {
+    LayeredNode *node = g_ptr_array_index (nodes, i);
+
+    g_ptr_array_add (out_edges, g_array_new (FALSE, FALSE, sizeof (guint)));
+
+    for (GList *l = GST_ELEMENT_PADS (node->object); l; l = g_list_next (l)) {
+      GstPad *pad = GST_PAD_CAST (l->data);
+      GstPad *peer;
+      GstObject *peer_child;
+      guint j;
+
+      if (gst_pad_get_direction (pad) != GST_PAD_SRC)
+        continue;
+      peer = gst_pad_get_peer (pad);
+      if (!peer)
+        continue;
+
+      peer_child = layered_find_child (bin, GST_OBJECT_CAST (peer));
+      j = GPOINTER_TO_UINT (g_hash_table_lookup (node_index, peer_child));
+      gst_object_unref (peer);
+      if (!j-- || j == i)
+        continue;
+
+      g_array_append_val (g_ptr_array_index (out_edges, i), edges->len);
+      g_array_append_vals (edges, &(LayeredEdge) {i, j}, 1);
+    }
+  }
+
+  /*
+   * Rank the nodes in topological order (longest path from the sources).
+   * If there are no more sources but unranked nodes, we are in a cycle
+   * which is broken up by ranking the next unranked node in child order.
+   * Links to already ranked nodes are such cycles and are not considered
+   * for layering.
+   */
+  in_degree = g_new0 (guint, num_children);
+  ranked = g_new0 (gboolean, num_children);
+  for (guint i = 0; i < edges->len; i++)
+    in_degree[g_array_index (edges, LayeredEdge, i).sink]++;
+  for (guint i = 0; i < num_children; i++)
+    if (!in_degree[i])
+      g_queue_push_tail (&ready, GUINT_TO_POINTER (i));
+
+  while (num_ranked < num_children) {
+    guint v;
+    GArray *out;
+
+    if (g_queue_is_empty (&ready)) {
+      while (ranked[cursor])
+        cursor++;
+      g_queue_push_tail (&ready, GUINT_TO_POINTER (cursor));
+    }
+    v = GPOINTER_TO_UINT (g_queue_pop_head (&ready));
+    if (ranked[v])
+      continue;
+    ranked[v] = TRUE;
+    num_ranked++;
+
+    out = g_ptr_array_index (out_edges, v);
+    for (guint i = 0; i < out->len; i++) {
+      LayeredEdge *edge = &g_array_index (edges, LayeredEdge,
+          g_array_index (out, guint, i));
+      LayeredNode *src = g_ptr_array_index (nodes, edge->src);
+      LayeredNode *sink = g_ptr_array_index (nodes, edge->sink);
+
+      if (ranked[edge->sink]) {
+        /* cycle: ignore this link */
+        edge->sink = edge->src;
+        continue;
+      }
+
+      sink->rank = MAX (sink->rank, src->rank + 1);
+      max_rank = MAX (max_rank, sink->rank);
+      if (--in_degree[edge->sink] == 0)
+        g_queue_push_tail (&ready, GUINT_TO_POINTER (edge->sink));
+    }
+  }
+
+  g_free (ranked);
+  g_free (in_degree);
+  g_ptr_array_free (out_edges, TRUE);
+
+  /*
+   * Links spanning several layers are split up using dummy nodes,
+   * so every link connects adjacent layers.
+   */
+  for (guint i = 0; i < edges->len; i++) {
+    LayeredEdge *edge = &g_array_index (edges, LayeredEdge, i);
+    guint prev = edge->src;
+    gint sink_rank;
+
+    if (edge->src == edge->sink)
+      continue;
+
+    sink_rank = ((LayeredNode *) g_ptr_array_index (nodes, edge->sink))->rank;
+    for (gint r = ((LayeredNode *) g_ptr_array_index (nodes, prev))->rank + 1;
+        r < sink_rank; r++) {
+      guint dummy = layered_node_add (nodes, NULL, 0, 0);
+
+      ((LayeredNode *) g_ptr_array_index (nodes, dummy))->rank = r;
+      layered_node_link (nodes, prev, dummy);
+      prev = dummy;
+    }
+    layered_node_link (nodes, prev, edge->sink);
+  }
+
+  layers = g_ptr_array_new_with_free_func ((GDestroyNotify) g_array_unref);
+  for (gint r = 0; r <= max_rank; r++)
+    g_ptr_array_add (layers, g_array_new (FALSE, FALSE, sizeof (guint)));
+  for (guint i = 0; i < nodes->len; i++) {
+    LayeredNode *node = g_ptr_array_index (nodes, i);
+    GArray *layer = g_ptr_array_index (layers, node->rank);
+
+    node->index = layer->len;
+    g_array_append_val (layer, i);
+  }
+
+  /*
+   * Crossing reduction: alternating down and up sweeps with
+   * the barycenter heuristic.
+   */
+  for (guint sweep = 0; sweep < LAYERED_SWEEPS; sweep++) {
+    if (sweep % 2 == 0) {
+      for (guint r = 1; r < layers->len; r++)
+        layered_sort_layer (nodes, g_ptr_array_index (layers, r), TRUE);
+    } else {
+      for (gint r = (gint) layers->len - 2; r >= 0; r--)
+        layered_sort_layer (nodes, g_ptr_array_index (layers, r), FALSE);
+    }
+  }
+
+  /*
+   * Placement: layers are columns from left to right.
+   * Within a layer, elements are stacked top to bottom in order,
+   * but are moved down towards the center of their predecessors
+   * if there is room, which straightens most links.
+   */
+  x = LAYERED_MARGIN_X;
+  for (guint r = 0; r < layers->len; r++) {
+    GArray *layer = g_ptr_array_index (layers, r);
+    gdouble layer_width = 0;
+    gdouble bottom = LAYERED_MARGIN_TOP - LAYERED_SPACING_Y;
+
+    for (guint i = 0; i < layer->len; i++) {
+      LayeredNode *node = g_ptr_array_index (nodes, g_array_index (layer, guint, i));
+      gdouble y = LAYERED_MARGIN_TOP;
+
+      if (node->preds->len > 0) {
+        y = 0;
+        for (guint j = 0; j < node->preds->len; j++) {
+          LayeredNode *pred = g_ptr_array_index (nodes,
+              g_array_index (node->preds, guint, j));
+          y += pred->y + pred->height / 2;
+        }
+        y = y / node->preds->len - node->height / 2;
+      }
+
+      node->x = x;
+      node->y = MAX (y, bottom + LAYERED_SPACING_Y);
+      bottom = node->y + node->height;
+
+      layer_width = MAX (layer_width, node->width);
+      max_x = MAX (max_x, node->x + node->width);
+      max_y = MAX (max_y, bottom);
+    }
+
+    x += layer_width + LAYERED_SPACING_X;
+  }
+
+  for (guint i = 0; i < num_children; i++) {
+    LayeredNode *node = g_ptr_array_index (nodes, i);
+    GsteLayoutBox *box = g_new (GsteLayoutBox, 1);
+
+    box->x = node->x;
+    box->y = node->y;
+    box->width = node->width;
+    box->height = node->height;
+    g_hash_table_insert (boxes, node->object, box);
+  }
+
+  *bin_width = MAX (max_x + LAYERED_MARGIN_X, LAYERED_BIN_WIDTH);
+  *bin_height = MAX (max_y + LAYERED_MARGIN_BOTTOM, LAYERED_BIN_HEIGHT);
+
+  g_ptr_array_free (layers, TRUE);
+  g_array_free (edges, TRUE);
+  g_hash_table_unref (node_index);
+  g_ptr_array_free (nodes, TRUE);
+}
+
+/**
+ * Lay out all children of bin (recursively).
+ * Returns a hash table mapping the bin and all laid out GstObjects
+ * to GsteLayoutBoxes. The bin itself is placed at 0, 0.
+ */
+GHashTable *
+gste_layout_layered (GstBin * bin)
+{
+  GHashTable *boxes = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+  GsteLayoutBox *box = g_new0 (GsteLayoutBox, 1);
+
+  layered_layout_bin (bin, boxes, &box->width, &box->height);
+  g_hash_table_insert (boxes, bin, box);
+
+  return boxes;
+}
+
+typedef struct _LayoutSaveCtx {
+  GString *pipeline;
+  GKeyFile *key_file;
+  /* for large pipelines, NULL otherwise */
+  GsteMetadataBuilder *builder;
+  GHashTable *boxes;
+} LayoutSaveCtx;
+
+static void
+layout_append_cb (const gchar * str, gpointer user_data)
+{
+  LayoutSaveCtx *ctx = user_data;
+  g_string_append (ctx->pipeline, str);
+}
+
+static void
+layout_object_saved_cb (GstObject * object, gpointer user_data)
+{
+  LayoutSaveCtx *ctx = user_data;
+  GsteLayoutBox *box = g_hash_table_lookup (ctx->boxes, object);
+  gchar *group_name;
+
+  /* pads and children of self-managed bins */
+  if (!box)
+    return;
+
+  if (ctx->builder) {
+    gste_metadata_builder_add (ctx->builder, GST_OBJECT_NAME (object), box);
+    return;
+  }
+
+  group_name = g_strconcat ("Element:", GST_OBJECT_NAME (object), NULL);
+  g_key_file_set_double (ctx->key_file, group_name, "X", box->x);
+  g_key_file_set_double (ctx->key_file, group_name, "Y", box->y);
+  g_key_file_set_double (ctx->key_file, group_name, "Width", box->width);
+  g_key_file_set_double (ctx->key_file, group_name, "Height", box->height);
+  g_free (group_name);
+}
+
+/**
+ * Lay out the pipeline in in_file and save it with the layout
+ * as a GstEditor pipeline (.gep) to out_file.
+ * in_file may be a plain gst-launch pipeline or a GstEditor pipeline.
+ *
+ * The save file format must match gst_editor_item_save_with_metadata().
+ */
+gboolean
+gste_layout_file (const gchar * in_file, const gchar * out_file,
+    GError ** error)
+{
+  GsteSerializeFlags flags = 0;
+  gchar *description = NULL;
+  GstElement *pipeline;
+  GKeyFile *key_file;
+  LayoutSaveCtx ctx;
+  gchar *sidecar_name;
+  gboolean ret;
+
+  if (g_str_has_suffix (in_file, ".gep")) {
+    GKeyFile *in_key_file = g_key_file_new ();
+
+    if (g_key_file_load_from_file (in_key_file, in_file, G_KEY_FILE_NONE, error)) {
+      description = g_key_file_get_string (in_key_file, PACKAGE_NAME,
+          "Pipeline", error);
+      flags = g_key_file_get_integer (in_key_file, PACKAGE_NAME, "Flags", NULL);
+    }
+    g_key_file_unref (in_key_file);
+  } else {
+    g_file_get_contents (in_file, &description, NULL, error);
+  }
+  if (!description)
+    return FALSE;
+
+  /*
+   * The layout only depends on the structure of the pipeline,
+   * so there is no need to load any plugin.
+   */
+  pipeline = gste_placeholder_parse_launch (description, NULL);
+  if (!pipeline)
+    pipeline = gst_parse_launch_full (description, NULL,
+        GST_PARSE_FLAG_FATAL_ERRORS, error);
+  g_free (description);
+  if (!pipeline)
+    return FALSE;
+
+  /* GstParse does not wrap single elements into a pipeline */
+  if (!GST_IS_BIN (pipeline)) {
+    GstElement *bin = gst_pipeline_new (NULL);
+
+    gst_bin_add (GST_BIN (bin), pipeline);
+    pipeline = bin;
+  }
+
+  flags &= ~GSTE_SERIALIZE_NEED_SPACE;
+  flags |= GSTE_SERIALIZE_PIPELINES_AS_BINS |
+      GSTE_SERIALIZE_CAPSFILTER_AS_ELEMENT;
+
+  key_file = g_key_file_new ();
+  ctx.pipeline = g_string_new ("");
+  ctx.key_file = key_file;
+  ctx.boxes = gste_layout_layered (GST_BIN (pipeline));
+  ctx.builder = g_hash_table_size (ctx.boxes) >= GSTE_METADATA_MIN_RECORDS ?
+      gste_metadata_builder_new () : NULL;
+
+  g_key_file_set_string (key_file, PACKAGE_NAME, "Version", PACKAGE_VERSION);
+  g_key_file_set_integer (key_file, PACKAGE_NAME, "Flags", flags);
+  gste_serialize_save (GST_OBJECT (pipeline), flags,
+      layout_append_cb, layout_object_saved_cb, &ctx);
+  g_key_file_set_string (key_file, PACKAGE_NAME, "Pipeline", ctx.pipeline->str);
+  /* keep the bin size computed by the layout */
+  g_key_file_set_boolean (key_file, PACKAGE_NAME, "Autosize", FALSE);
+
+  sidecar_name = gste_metadata_sidecar_name (out_file);
+  if (ctx.builder) {
+    GBytes *sidecar = gste_metadata_builder_end (ctx.builder,
+        gste_metadata_stamp (ctx.pipeline->str));
+    gchar *basename = g_path_get_basename (sidecar_name);
+    gsize length;
+    const gchar *data = g_bytes_get_data (sidecar, &length);
+
+    g_key_file_set_string (key_file, PACKAGE_NAME, "Layout", basename);
+    ret = g_file_set_contents (sidecar_name, data, length, error);
+    g_free (basename);
+    g_bytes_unref (sidecar);
+  } else {
+    /* do not leave an outdated sidecar behind */
+    g_unlink (sidecar_name);
+    ret = TRUE;
+  }
+  g_free (sidecar_name);
+
+  ret = ret && g_key_file_save_to_file (key_file, out_file, error);
+
+  g_hash_table_unref (ctx.boxes);
+  g_string_free (ctx.pipeline, TRUE);
+  g_key_file_unref (key_file);
+  gst_object_unref (pipeline);
+
+  return ret;
+}
@@ -0,0 +1,36 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GSTE_LAYOUT_H__
+#define __GSTE_LAYOUT_H__
+
+#include <glib.h>
+
+#include <gst/gst.h>
+
+typedef struct _GsteLayoutBox {
+  /* position relative to the parent bin */
+  gdouble x, y;
+  gdouble width, height;
+} GsteLayoutBox;
+
+GHashTable *gste_layout_layered (GstBin * bin);
+gboolean gste_layout_file (const gchar * in_file, const gchar * out_file,
+    GError ** error);
+
+#endif /* __GSTE_LAYOUT_H__ */
@@ -0,0 +1,356 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Binary layout sidecar of GstEditor pipelines.
+ * The file consists of a header, a table of fixed-size records
+ * sorted by element name and a string table of element names.
+ * All integers and doubles are stored in little endian byte order,
+ * so the file can be memory-mapped and used without parsing.
+ * The stamp identifies the pipeline description the layout was
+ * written for, so stale sidecars can be detected.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "gste-layout.h"
+#include "gste-metadata.h"
+
+#define METADATA_MAGIC   "GSTEMETA"
+#define METADATA_VERSION 1
+
+typedef struct _MetadataHeader {
+  gchar magic[8];
+  guint32 version;
+  guint32 n_records;
+  guint32 stamp;
+  guint32 strings_size;
+} MetadataHeader;
+
+typedef struct _MetadataRecord {
+  /* NUL-terminated name in the string table */
+  guint32 name_offset;
+  guint32 name_length;
+  /* x, y, width, height as IEEE 754 doubles */
+  guint64 geometry[4];
+} MetadataRecord;
+
+/* records must stay aligned when following the header */
+G_STATIC_ASSERT (sizeof (MetadataHeader) == 24);
+G_STATIC_ASSERT (sizeof (MetadataRecord) == 40);
+
+struct _GsteMetadata {
+  GMappedFile *file;
+
+  guint n_records;
+  const MetadataRecord *records;
+  const gchar *strings;
+};
+
+typedef struct _BuilderEntry {
+  gchar *name;
+  GsteLayoutBox box;
+} BuilderEntry;
+
+struct _GsteMetadataBuilder {
+  GArray *entries;              /* BuilderEntry */
+};
+
+G_DEFINE_QUARK (gste-metadata-error-quark, gste_metadata_error)
+
+static inline guint64
+metadata_pack_double (gdouble value)
+{
+  union { gdouble d; guint64 i; } u = { .d = value };
+  return GUINT64_TO_LE (u.i);
+}
+
+static inline gdouble
+metadata_unpack_double (guint64 value)
+{
+  union { gdouble d; guint64 i; } u = { .i = GUINT64_FROM_LE (value) };
+  return u.d;
+}
+
+static void
+metadata_unpack_box (const MetadataRecord * record, GsteLayoutBox * box)
+{
+  box->x = metadata_unpack_double (record->geometry[0]);
+  box->y = metadata_unpack_double (record->geometry[1]);
+  box->width = metadata_unpack_double (record->geometry[2]);
+  box->height = metadata_unpack_double (record->geometry[3]);
+}
+
+/**
+ * Hash (FNV-1a) of the pipeline description a layout is written for.
+ */
+guint32
+gste_metadata_stamp (const gchar * pipeline)
+{
+  guint32 hash = 2166136261U;
+
+  for (const guchar * p = (const guchar *) pipeline; *p; p++) {
+    hash ^= *p;
+    hash *= 16777619U;
+  }
+
+  return hash;
+}
+
+gchar *
+gste_metadata_sidecar_name (const gchar * filename)
+{
+  return g_strconcat (filename, GSTE_METADATA_SUFFIX, NULL);
+}
+
+/**********************************************************************
+ * Writing
+ **********************************************************************/
+
+static void
+builder_entry_clear (BuilderEntry * entry)
+{
+  g_free (entry->name);
+}
+
+static gint
+builder_entry_compare (gconstpointer a, gconstpointer b)
+{
+  return strcmp (((const BuilderEntry *) a)->name,
+      ((const BuilderEntry *) b)->name);
+}
+
+GsteMetadataBuilder *
+gste_metadata_builder_new (void)
+{
+  GsteMetadataBuilder *builder = g_new (GsteMetadataBuilder, 1);
+
+  builder->entries = g_array_new (FALSE, FALSE, sizeof (BuilderEntry));
+  g_array_set_clear_func (builder->entries,
+      (GDestroyNotify) builder_entry_clear);
+
+  return builder;
+}
+
+void
+gste_metadata_builder_add (GsteMetadataBuilder * builder, const gchar * name,
+    const GsteLayoutBox * box)
+{
+  BuilderEntry entry;
+
+  entry.name = g_strdup (name);
+  entry.box = *box;
+  g_array_append_val (builder->entries, entry);
+}
+
+/**
+ * Serializes the records added to builder and frees it.
+ */
+GBytes *
+gste_metadata_builder_end (GsteMetadataBuilder * builder, guint32 stamp)
+{
+  GArray *entries = builder->entries;
+  GByteArray *data;
+  MetadataHeader header;
+  guint32 strings_size = 0;
+
+  /* allows binary searches on the mapped file */
+  g_array_sort (entries, builder_entry_compare);
+
+  for (guint i = 0; i < entries->len; i++)
+    strings_size += strlen (g_array_index (entries, BuilderEntry, i).name) + 1;
+
+  data = g_byte_array_sized_new (sizeof (header) +
+      entries->len * sizeof (MetadataRecord) + strings_size);
+
+  memcpy (header.magic, METADATA_MAGIC, sizeof (header.magic));
+  header.version = GUINT32_TO_LE (METADATA_VERSION);
+  header.n_records = GUINT32_TO_LE (entries->len);
+  header.stamp = GUINT32_TO_LE (stamp);
+  header.strings_size = GUINT32_TO_LE (strings_size);
+  g_byte_array_append (data, (const guint8 *) &header, sizeof (header));
+
+  strings_size = 0;
+  for (guint i = 0; i < entries->len; i++) {
+    BuilderEntry *entry = &g_array_index (entries, BuilderEntry, i);
+    MetadataRecord record;
+    guint32 length = strlen (entry->name);
+
+    record.name_offset = GUINT32_TO_LE (strings_size);
+    record.name_length = GUINT32_TO_LE (length);
+    record.geometry[0] = metadata_pack_double (entry->box.x);
+    record.geometry[1] = metadata_pack_double (entry->box.y);
+    record.geometry[2] = metadata_pack_double (entry->box.width);
+    record.geometry[3] = metadata_pack_double (entry->box.height);
+    g_byte_array_append (data, (const guint8 *) &record, sizeof (record));
+
+    strings_size += length + 1;
+  }
+
+  for (guint i = 0; i < entries->len; i++) {
+    const gchar *name = g_array_index (entries, BuilderEntry, i).name;
+    g_byte_array_append (data, (const guint8 *) name, strlen (name) + 1);
+  }
+
+  g_array_free (entries, TRUE);
+  g_free (builder);
+
+  return g_byte_array_free_to_bytes (data);
+}
+
+/**********************************************************************
+ * Reading
+ **********************************************************************/
+
+static gboolean
+metadata_validate (GsteMetadata * metadata, const gchar * contents,
+    gsize length, guint32 stamp, GError ** error)
+{
+  MetadataHeader header;
+  guint32 strings_size;
+
+  if (length < sizeof (header))
+    goto corrupt;
+  memcpy (&header, contents, sizeof (header));
+
+  if (memcmp (header.magic, METADATA_MAGIC, sizeof (header.magic)) != 0 ||
+      GUINT32_FROM_LE (header.version) != METADATA_VERSION)
+    goto corrupt;
+
+  if (GUINT32_FROM_LE (header.stamp) != stamp) {
+    g_set_error (error, GSTE_METADATA_ERROR, GSTE_METADATA_ERROR_STALE,
+        "Layout was saved for a different pipeline");
+    return FALSE;
+  }
+
+  metadata->n_records = GUINT32_FROM_LE (header.n_records);
+  strings_size = GUINT32_FROM_LE (header.strings_size);
+  if ((length - sizeof (header)) / sizeof (MetadataRecord) <
+      metadata->n_records ||
+      length - sizeof (header) - metadata->n_records * sizeof (MetadataRecord)
+      != strings_size)
+    goto corrupt;
+
+  metadata->records = (const MetadataRecord *) (contents + sizeof (header));
+  metadata->strings = (const gchar *) (metadata->records + metadata->n_records);
+
+  /* every name must be NUL-terminated within the string table */
+  for (guint i = 0; i < metadata->n_records; i++) {
+    guint32 offset = GUINT32_FROM_LE (metadata->records[i].name_offset);
+    guint32 name_length = GUINT32_FROM_LE (metadata->records[i].name_length);
+
+    if (offset >= strings_size || name_length >= strings_size - offset ||
+        metadata->strings[offset + name_length] != '\0')
+      goto corrupt;
+  }
+
+  return TRUE;
+
+corrupt:
+  g_set_error (error, GSTE_METADATA_ERROR, GSTE_METADATA_ERROR_CORRUPT,
+      "Invalid or truncated layout file");
+  return FALSE;
+}
+
+/**
+ * Maps the layout sidecar filename.
+ * Fails if it was not written for a pipeline with the given stamp
+ * (see gste_metadata_stamp()).
+ */
+GsteMetadata *
+gste_metadata_open (const gchar * filename, guint32 stamp, GError ** error)
+{
+  GsteMetadata *metadata = g_new0 (GsteMetadata, 1);
+
+  metadata->file = g_mapped_file_new (filename, FALSE, error);
+  if (!metadata->file) {
+    g_free (metadata);
+    return NULL;
+  }
+
+  if (!metadata_validate (metadata, g_mapped_file_get_contents (metadata->file),
+          g_mapped_file_get_length (metadata->file), stamp, error)) {
+    g_prefix_error (error, "%s: ", filename);
+    gste_metadata_free (metadata);
+    return NULL;
+  }
+
+  return metadata;
+}
+
+guint
+gste_metadata_get_n_records (GsteMetadata * metadata)
+{
+  return metadata->n_records;
+}
+
+/**
+ * Returns the element name of the index-th record and stores its
+ * geometry in box. Records are sorted by name.
+ */
+const gchar *
+gste_metadata_get_record (GsteMetadata * metadata, guint index,
+    GsteLayoutBox * box)
+{
+  const MetadataRecord *record;
+
+  g_return_val_if_fail (index < metadata->n_records, NULL);
+
+  record = metadata->records + index;
+  if (box)
+    metadata_unpack_box (record, box);
+
+  return metadata->strings + GUINT32_FROM_LE (record->name_offset);
+}
+
+gboolean
+gste_metadata_lookup (GsteMetadata * metadata, const gchar * name,
+    GsteLayoutBox * box)
+{
+  guint low = 0, high = metadata->n_records;
+
+  while (low < high) {
+    guint mid = low + (high - low) / 2;
+    const MetadataRecord *record = metadata->records + mid;
+    gint cmp = strcmp (name,
+        metadata->strings + GUINT32_FROM_LE (record->name_offset));
+
+    if (cmp == 0) {
+      if (box)
+        metadata_unpack_box (record, box);
+      return TRUE;
+    }
+    if (cmp < 0)
+      high = mid;
+    else
+      low = mid + 1;
+  }
+
+  return FALSE;
+}
+
+void
+gste_metadata_free (GsteMetadata * metadata)
+{
+  g_mapped_file_unref (metadata->file);
+  g_free (metadata);
+}
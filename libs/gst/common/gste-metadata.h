@@ -0,0 +1,73 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GSTE_METADATA_H__
+#define __GSTE_METADATA_H__
+
+#include <glib.h>
+
+#include "gste-layout.h"
+
+/**
+ * Suffix appended to the name of a GstEditor pipeline (.gep)
+ * to get the name of its binary layout sidecar.
+ */
+#define GSTE_METADATA_SUFFIX ".layout"
+
+/**
+ * Pipelines with at least this many elements store their layout
+ * in a binary sidecar instead of one key file group per element.
+ */
+#define GSTE_METADATA_MIN_RECORDS 256
+
+#define GSTE_METADATA_ERROR (gste_metadata_error_quark ())
+
+typedef enum {
+  /** not a layout sidecar or truncated */
+  GSTE_METADATA_ERROR_CORRUPT,
+  /** written for another version of the pipeline */
+  GSTE_METADATA_ERROR_STALE
+} GsteMetadataError;
+
+/**
+ * Memory-mapped layout sidecar.
+ */
+typedef struct _GsteMetadata GsteMetadata;
+typedef struct _GsteMetadataBuilder GsteMetadataBuilder;
+
+GQuark gste_metadata_error_quark (void);
+
+guint32 gste_metadata_stamp (const gchar * pipeline);
+gchar *gste_metadata_sidecar_name (const gchar * filename);
+
+GsteMetadataBuilder *gste_metadata_builder_new (void);
+void gste_metadata_builder_add (GsteMetadataBuilder * builder,
+    const gchar * name, const GsteLayoutBox * box);
+GBytes *gste_metadata_builder_end (GsteMetadataBuilder * builder,
+    guint32 stamp);
+
+GsteMetadata *gste_metadata_open (const gchar * filename, guint32 stamp,
+    GError ** error);
+guint gste_metadata_get_n_records (GsteMetadata * metadata);
+const gchar *gste_metadata_get_record (GsteMetadata * metadata, guint index,
+    GsteLayoutBox * box);
+gboolean gste_metadata_lookup (GsteMetadata * metadata, const gchar * name,
+    GsteLayoutBox * box);
+void gste_metadata_free (GsteMetadata * metadata);
+
+#endif /* __GSTE_METADATA_H__ */
@@ -0,0 +1,1107 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Structure-only parsing of pipeline descriptions.
+ * GstParse instantiates every element, which loads every plugin
+ * referenced by the pipeline. This parser builds the same bin
+ * hierarchy out of placeholders instead, which are instantiated
+ * on demand.
+ * Only the subset of the gst-launch syntax produced by GsteSerialize
+ * is supported. Callers should fall back to GstParse if parsing fails.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <gst/gst.h>
+
+#include "gste-placeholder.h"
+
+GST_DEBUG_CATEGORY_STATIC (gste_placeholder_debug);
+#define GST_CAT_DEFAULT gste_placeholder_debug
+
+typedef struct _GstePlaceholderArgument {
+  gchar *name;
+  gchar *value;                 /* unquoted */
+} GstePlaceholderArgument;
+
+struct _GstePlaceholder {
+  GstElement element;
+
+  GstElementFactory *factory;
+  GArray *arguments;            /* GstePlaceholderArgument */
+};
+
+struct _GstePlaceholderClass {
+  GstElementClass parent_class;
+};
+
+G_DEFINE_TYPE (GstePlaceholder, gste_placeholder, GST_TYPE_ELEMENT);
+
+/* factory name -> number of placeholders named after it */
+static GHashTable *placeholder_counts = NULL;
+G_LOCK_DEFINE_STATIC (placeholder_counts);
+
+static void
+gste_placeholder_argument_clear (GstePlaceholderArgument * argument)
+{
+  g_free (argument->name);
+  g_free (argument->value);
+}
+
+static void
+gste_placeholder_finalize (GObject * object)
+{
+  GstePlaceholder *placeholder = GSTE_PLACEHOLDER (object);
+
+  if (placeholder->factory)
+    gst_object_unref (placeholder->factory);
+  g_array_unref (placeholder->arguments);
+
+  G_OBJECT_CLASS (gste_placeholder_parent_class)->finalize (object);
+}
+
+static void
+gste_placeholder_class_init (GstePlaceholderClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gste_placeholder_finalize;
+
+  gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
+      "Placeholder", "Generic",
+      "Stands in for an element that has not been instantiated yet",
+      "gst-editor");
+
+  GST_DEBUG_CATEGORY_INIT (gste_placeholder_debug, "GSTE_PLACEHOLDER", 0,
+      "GStreamer Editor Placeholders");
+}
+
+static void
+gste_placeholder_init (GstePlaceholder * placeholder)
+{
+  placeholder->arguments = g_array_new (FALSE, FALSE,
+      sizeof (GstePlaceholderArgument));
+  g_array_set_clear_func (placeholder->arguments,
+      (GDestroyNotify) gste_placeholder_argument_clear);
+}
+
+/* like the default name of the real element */
+static gchar *
+gste_placeholder_default_name (GstElementFactory * factory)
+{
+  const gchar *factory_name = GST_OBJECT_NAME (factory);
+  guint count;
+
+  G_LOCK (placeholder_counts);
+
+  if (G_UNLIKELY (!placeholder_counts))
+    placeholder_counts = g_hash_table_new_full (g_str_hash, g_str_equal,
+        g_free, NULL);
+
+  count = GPOINTER_TO_UINT (g_hash_table_lookup (placeholder_counts,
+          factory_name));
+  g_hash_table_insert (placeholder_counts, g_strdup (factory_name),
+      GUINT_TO_POINTER (count + 1));
+
+  G_UNLOCK (placeholder_counts);
+
+  return g_strdup_printf ("%s%u", factory_name, count);
+}
+
+static GstElement *
+gste_placeholder_new (const gchar * factory_name, GError ** error)
+{
+  GstElementFactory *factory;
+  GstePlaceholder *placeholder;
+  gchar *name;
+
+  /* this only consults the registry cache */
+  factory = gst_element_factory_find (factory_name);
+  if (!factory) {
+    g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_NO_SUCH_ELEMENT,
+        "no element \"%s\"", factory_name);
+    return NULL;
+  }
+
+  name = gste_placeholder_default_name (factory);
+  placeholder = g_object_new (GSTE_TYPE_PLACEHOLDER, "name", name, NULL);
+  g_free (name);
+  placeholder->factory = factory;
+
+  /* the real element will always have these pads */
+  for (const GList *l = gst_element_factory_get_static_pad_templates (factory);
+       l; l = g_list_next (l)) {
+    GstStaticPadTemplate *templ = l->data;
+
+    if (templ->presence == GST_PAD_ALWAYS)
+      gst_element_add_pad (GST_ELEMENT (placeholder),
+          gst_pad_new_from_static_template (templ, templ->name_template));
+  }
+
+  return GST_ELEMENT (placeholder);
+}
+
+static void
+gste_placeholder_set_argument (GstePlaceholder * placeholder,
+    const gchar * name, const gchar * value)
+{
+  GstePlaceholderArgument argument;
+
+  for (guint i = 0; i < placeholder->arguments->len; i++) {
+    GstePlaceholderArgument *cur = &g_array_index (placeholder->arguments,
+        GstePlaceholderArgument, i);
+
+    if (!strcmp (cur->name, name)) {
+      g_free (cur->value);
+      cur->value = g_strdup (value);
+      return;
+    }
+  }
+
+  argument.name = g_strdup (name);
+  argument.value = g_strdup (value);
+  g_array_append_val (placeholder->arguments, argument);
+}
+
+/* deserializes value like GstParse does */
+static gboolean
+gste_object_set_argument (GObject * object, const gchar * name,
+    const gchar * value, GError ** error)
+{
+  GParamSpec *pspec;
+  GValue v = G_VALUE_INIT;
+
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (object), name);
+  if (!pspec) {
+    g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_NO_SUCH_PROPERTY,
+        "no property \"%s\" in element \"%s\"", name,
+        GST_OBJECT_NAME (object));
+    return FALSE;
+  }
+
+  g_value_init (&v, pspec->value_type);
+  if (!gst_value_deserialize (&v, value)) {
+    g_set_error (error, GST_PARSE_ERROR,
+        GST_PARSE_ERROR_COULD_NOT_SET_PROPERTY,
+        "could not set property \"%s\" in element \"%s\" to \"%s\"",
+        name, GST_OBJECT_NAME (object), value);
+    g_value_unset (&v);
+    return FALSE;
+  }
+
+  g_object_set_property (object, name, &v);
+  g_value_unset (&v);
+
+  return TRUE;
+}
+
+/**********************************************************************
+ * Pads
+ **********************************************************************/
+
+/* whether name may be the name of a pad created from name_template */
+static gboolean
+pad_name_matches_template (const gchar * name, const gchar * name_template)
+{
+  const gchar *percent = strchr (name_template, '%');
+  const gchar *suffix;
+  gsize prefix_len, suffix_len, name_len;
+
+  /* links may also refer to the template itself, e.g. "src_%u" */
+  if (!strcmp (name, name_template))
+    return TRUE;
+  if (!percent || !percent[1])
+    return FALSE;
+
+  prefix_len = percent - name_template;
+  suffix = percent + 2;
+  suffix_len = strlen (suffix);
+  name_len = strlen (name);
+
+  return name_len > prefix_len + suffix_len &&
+      !strncmp (name, name_template, prefix_len) &&
+      !strcmp (name + name_len - suffix_len, suffix);
+}
+
+static gchar *
+gste_placeholder_new_pad_name (GstElement * element,
+    const gchar * name_template)
+{
+  const gchar *percent = strchr (name_template, '%');
+
+  if (!percent || !percent[1])
+    return g_strdup (name_template);
+
+  for (guint i = 0;; i++) {
+    gchar *name = g_strdup_printf ("%.*s%u%s",
+        (gint) (percent - name_template), name_template, i, percent + 2);
+    GstPad *pad = gst_element_get_static_pad (element, name);
+
+    if (!pad)
+      return name;
+    gst_object_unref (pad);
+    g_free (name);
+  }
+}
+
+/*
+ * Gets the pad a link refers to, creating request and sometimes
+ * pads as necessary. If name is NULL, this is the first unlinked
+ * pad like in gst_element_link().
+ */
+static GstPad *
+gste_placeholder_get_link_pad (GstePlaceholder * placeholder,
+    const gchar * name, GstPadDirection direction)
+{
+  GstElement *element = GST_ELEMENT (placeholder);
+  GstStaticPadTemplate *found = NULL;
+  GstPad *pad;
+  gchar *pad_name;
+
+  if (name) {
+    pad = gst_element_get_static_pad (element, name);
+    if (pad)
+      return pad;
+  } else {
+    for (GList *l = GST_ELEMENT_PADS (element); l; l = g_list_next (l)) {
+      pad = GST_PAD (l->data);
+
+      if (GST_PAD_DIRECTION (pad) == direction && !GST_PAD_PEER (pad))
+        return gst_object_ref (pad);
+    }
+  }
+
+  for (const GList *l =
+       gst_element_factory_get_static_pad_templates (placeholder->factory);
+       l; l = g_list_next (l)) {
+    GstStaticPadTemplate *templ = l->data;
+
+    if (templ->direction != direction || templ->presence == GST_PAD_ALWAYS)
+      continue;
+
+    if (!name || pad_name_matches_template (name, templ->name_template)) {
+      found = templ;
+      break;
+    }
+  }
+  if (!found)
+    return NULL;
+
+  pad_name = name && !strchr (name, '%') ? g_strdup (name) :
+      gste_placeholder_new_pad_name (element, found->name_template);
+  pad = gst_pad_new_from_static_template (found, pad_name);
+  g_free (pad_name);
+  gst_element_add_pad (element, pad);
+
+  return gst_object_ref (pad);
+}
+
+static GstPadLinkReturn
+link_pads (GstPad * pad, GstPad * peer)
+{
+  /*
+   * This restores links that existed before, so there is no
+   * need to check the caps. Negotiation will fail if they were
+   * incompatible in the first place.
+   */
+  return GST_PAD_IS_SRC (pad) ?
+      gst_pad_link_full (pad, peer, GST_PAD_LINK_CHECK_NOTHING) :
+      gst_pad_link_full (peer, pad, GST_PAD_LINK_CHECK_NOTHING);
+}
+
+/**********************************************************************
+ * Lexer
+ **********************************************************************/
+
+typedef enum {
+  TOKEN_END,
+  TOKEN_ELEMENT,                /* factory */
+  TOKEN_ASSIGNMENT,             /* property=value */
+  TOKEN_REFERENCE,              /* element.pad or element. */
+  TOKEN_PAD,                    /* .pad */
+  TOKEN_LINK,                   /* ! */
+  TOKEN_CAPS,                   /* ! caps ! */
+  TOKEN_BIN_OPEN,               /* type.( or ( */
+  TOKEN_BIN_CLOSE               /* ) */
+} TokenType;
+
+typedef struct _Token {
+  TokenType type;
+  /* factory, property, element name, caps or bin type */
+  gchar *str;
+  /* property value or pad name */
+  gchar *value;
+} Token;
+
+#define IS_WORD_CHAR(c) \
+    ((c) && !g_ascii_isspace (c) && !strchr ("!().=\"'", (c)))
+#define IS_PAD_CHAR(c) \
+    ((c) && !g_ascii_isspace (c) && !strchr ("!()", (c)))
+
+static void
+token_clear (Token * token)
+{
+  g_clear_pointer (&token->str, g_free);
+  g_clear_pointer (&token->value, g_free);
+}
+
+/* media types start caps, e.g. "video/x-raw, width=..." */
+static gboolean
+is_caps (const gchar * p)
+{
+  const gchar *start = p;
+
+  while (g_ascii_isalnum (*p) || *p == '_' || *p == '-' || *p == '+')
+    p++;
+
+  return p > start && *p == '/';
+}
+
+/* returns the next unquoted '!' */
+static const gchar *
+skip_caps (const gchar * p)
+{
+  gboolean quoted = FALSE;
+
+  for (; *p; p++) {
+    if (*p == '\\' && p[1])
+      p++;
+    else if (*p == '"')
+      quoted = !quoted;
+    else if (*p == '!' && !quoted)
+      return p;
+  }
+
+  return NULL;
+}
+
+/*
+ * Property values may be quoted. Unquoted values end at whitespace
+ * or at an unbalanced closing bracket.
+ */
+static const gchar *
+parse_value (const gchar * p, gchar ** value, GError ** error)
+{
+  GString *str = g_string_new ("");
+
+  if (*p == '"' || *p == '\'') {
+    gchar quote = *p++;
+
+    while (*p && *p != quote) {
+      if (*p == '\\' && p[1])
+        p++;
+      g_string_append_c (str, *p++);
+    }
+    if (!*p) {
+      g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_SYNTAX,
+          "unterminated quote");
+      g_string_free (str, TRUE);
+      return NULL;
+    }
+    p++;
+  } else {
+    guint depth = 0;
+
+    while (*p && !g_ascii_isspace (*p)) {
+      if (*p == '(')
+        depth++;
+      else if (*p == ')' && depth-- == 0)
+        break;
+
+      if (*p == '\\' && p[1])
+        p++;
+      g_string_append_c (str, *p++);
+    }
+  }
+
+  *value = g_string_free (str, FALSE);
+  return p;
+}
+
+static gboolean
+lex (const gchar ** pos, Token * token, GError ** error)
+{
+  const gchar *p = *pos, *start, *q;
+
+  token_clear (token);
+
+  while (g_ascii_isspace (*p))
+    p++;
+
+  switch (*p) {
+    case '\0':
+      token->type = TOKEN_END;
+      break;
+
+    case '!':
+      p++;
+      while (g_ascii_isspace (*p))
+        p++;
+
+      if (!is_caps (p)) {
+        token->type = TOKEN_LINK;
+        break;
+      }
+
+      start = p;
+      p = skip_caps (p);
+      if (!p) {
+        g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_SYNTAX,
+            "no element to link caps \"%s\" to", start);
+        return FALSE;
+      }
+      token->type = TOKEN_CAPS;
+      token->str = g_strstrip (g_strndup (start, p - start));
+      p++;
+      break;
+
+    case '(':
+      token->type = TOKEN_BIN_OPEN;
+      p++;
+      break;
+
+    case ')':
+      token->type = TOKEN_BIN_CLOSE;
+      p++;
+      break;
+
+    case '.':
+      start = ++p;
+      while (IS_PAD_CHAR (*p))
+        p++;
+      if (p == start) {
+        g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_SYNTAX,
+            "missing pad name");
+        return FALSE;
+      }
+      token->type = TOKEN_PAD;
+      token->value = g_strndup (start, p - start);
+      break;
+
+    default:
+      start = p;
+      while (IS_WORD_CHAR (*p))
+        p++;
+      if (p == start) {
+        g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_SYNTAX,
+            "unexpected character '%c'", *p);
+        return FALSE;
+      }
+      token->str = g_strndup (start, p - start);
+
+      for (q = p; g_ascii_isspace (*q); q++);
+
+      if (*q == '=') {
+        for (p = q + 1; g_ascii_isspace (*p); p++);
+        token->type = TOKEN_ASSIGNMENT;
+        p = parse_value (p, &token->value, error);
+        if (!p)
+          return FALSE;
+      } else if (*p == '.' && p[1] == '(') {
+        token->type = TOKEN_BIN_OPEN;
+        p += 2;
+      } else if (*p == '.') {
+        start = ++p;
+        while (IS_PAD_CHAR (*p))
+          p++;
+        token->type = TOKEN_REFERENCE;
+        token->value = p > start ? g_strndup (start, p - start) : NULL;
+      } else {
+        token->type = TOKEN_ELEMENT;
+      }
+      break;
+  }
+
+  *pos = p;
+  return TRUE;
+}
+
+/**********************************************************************
+ * Parser
+ **********************************************************************/
+
+typedef struct _Endpoint {
+  /* not referenced, owned by its bin */
+  GstElement *element;
+  /* name of a referenced element if element is NULL */
+  gchar *name;
+  /* NULL for any pad */
+  gchar *pad;
+} Endpoint;
+
+typedef struct _Link {
+  Endpoint src, sink;
+} Link;
+
+typedef struct _Parser {
+  const gchar *p;
+  Token token;
+
+  GstBin *top;
+  /* resolved once all elements are known */
+  GArray *links;
+} Parser;
+
+static void
+endpoint_set (Endpoint * endpoint, GstElement * element, const gchar * name,
+    const gchar * pad)
+{
+  gchar *old_name = endpoint->name, *old_pad = endpoint->pad;
+
+  endpoint->element = element;
+  endpoint->name = g_strdup (name);
+  endpoint->pad = g_strdup (pad);
+  g_free (old_name);
+  g_free (old_pad);
+}
+
+static void
+endpoint_clear (Endpoint * endpoint)
+{
+  endpoint_set (endpoint, NULL, NULL, NULL);
+}
+
+static void
+link_clear (Link * link)
+{
+  endpoint_clear (&link->src);
+  endpoint_clear (&link->sink);
+}
+
+static void
+parser_add_link (Parser * parser, const Endpoint * src,
+    GstElement * sink_element, const gchar * sink_name,
+    const gchar * sink_pad)
+{
+  Link link = { { NULL } };
+
+  endpoint_set (&link.src, src->element, src->name, src->pad);
+  endpoint_set (&link.sink, sink_element, sink_name, sink_pad);
+  g_array_append_val (parser->links, link);
+}
+
+static gboolean
+parser_add_element (GstBin * bin, GstElement * element, GError ** error)
+{
+  for (GList *l = GST_BIN_CHILDREN (bin); l; l = g_list_next (l)) {
+    if (!strcmp (GST_OBJECT_NAME (l->data), GST_OBJECT_NAME (element))) {
+      g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_SYNTAX,
+          "duplicate element name \"%s\"", GST_OBJECT_NAME (element));
+      gst_object_unref (gst_object_ref_sink (element));
+      return FALSE;
+    }
+  }
+
+  gst_bin_add (bin, element);
+  return TRUE;
+}
+
+/* parses the property assignments following an element */
+static gboolean
+parser_parse_arguments (Parser * parser, GstElement * element,
+    GError ** error)
+{
+  for (;;) {
+    const gchar *p = parser->p;
+    const gchar *name, *value;
+
+    if (!lex (&parser->p, &parser->token, error))
+      return FALSE;
+    if (parser->token.type != TOKEN_ASSIGNMENT) {
+      /* lexed again by the caller */
+      parser->p = p;
+      return TRUE;
+    }
+
+    name = parser->token.str;
+    value = parser->token.value;
+
+    if (!strcmp (name, "name"))
+      gst_object_set_name (GST_OBJECT (element), value);
+    else if (GSTE_IS_PLACEHOLDER (element))
+      gste_placeholder_set_argument (GSTE_PLACEHOLDER (element), name, value);
+    else if (!gste_object_set_argument (G_OBJECT (element), name, value,
+            error))
+      return FALSE;
+  }
+}
+
+static gboolean
+parser_parse_bin (Parser * parser, GstBin * bin, gboolean nested,
+    GError ** error)
+{
+  Token *token = &parser->token;
+  /* the element links start from */
+  Endpoint cur = { NULL }, src = { NULL };
+  gboolean have_cur = FALSE, linking = FALSE;
+  /* sink pad of the next element */
+  gchar *sink_pad = NULL;
+  GstElement *element;
+  gboolean ret = FALSE;
+
+  for (;;) {
+    if (!lex (&parser->p, token, error))
+      goto out;
+
+    switch (token->type) {
+      case TOKEN_END:
+      case TOKEN_BIN_CLOSE:
+        if ((token->type == TOKEN_END) == nested) {
+          g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_SYNTAX,
+              nested ? "unterminated bin" : "unexpected \")\"");
+          goto out;
+        }
+        if (linking) {
+          g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_LINK,
+              "link without sink element");
+          goto out;
+        }
+        ret = TRUE;
+        goto out;
+
+      case TOKEN_ELEMENT:
+        element = gste_placeholder_new (token->str, error);
+        if (!element)
+          goto out;
+        if (!parser_parse_arguments (parser, element, error)) {
+          gst_object_unref (gst_object_ref_sink (element));
+          goto out;
+        }
+        if (!parser_add_element (bin, element, error))
+          goto out;
+
+        if (linking) {
+          parser_add_link (parser, &src, element, NULL, sink_pad);
+          g_clear_pointer (&sink_pad, g_free);
+          linking = FALSE;
+        }
+        endpoint_set (&cur, element, NULL, NULL);
+        have_cur = TRUE;
+        break;
+
+      case TOKEN_BIN_OPEN:
+        if (linking) {
+          g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_LINK,
+              "links to bins are not supported");
+          goto out;
+        }
+
+        /* bins are core elements, so they are cheap to instantiate */
+        element = token->str ? gst_element_factory_make (token->str, NULL) :
+            gst_bin_new (NULL);
+        if (!element || !GST_IS_BIN (element)) {
+          g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_NO_SUCH_ELEMENT,
+              "no bin \"%s\"", token->str);
+          if (element)
+            gst_object_unref (gst_object_ref_sink (element));
+          goto out;
+        }
+        if (!parser_parse_arguments (parser, element, error)) {
+          gst_object_unref (gst_object_ref_sink (element));
+          goto out;
+        }
+        if (!parser_add_element (bin, element, error) ||
+            !parser_parse_bin (parser, GST_BIN (element), TRUE, error))
+          goto out;
+
+        endpoint_set (&cur, element, NULL, NULL);
+        have_cur = TRUE;
+        break;
+
+      case TOKEN_ASSIGNMENT:
+        g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_SYNTAX,
+            "unexpected property \"%s\"", token->str);
+        goto out;
+
+      case TOKEN_PAD:
+        if (linking) {
+          g_free (sink_pad);
+          sink_pad = g_strdup (token->value);
+        } else if (have_cur) {
+          endpoint_set (&cur, cur.element, cur.name, token->value);
+        } else {
+          g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_SYNTAX,
+              "pad \"%s\" without element", token->value);
+          goto out;
+        }
+        break;
+
+      case TOKEN_REFERENCE:
+        if (linking) {
+          parser_add_link (parser, &src, NULL, token->str, token->value);
+          linking = FALSE;
+          /* the chain continues at the referenced element */
+          endpoint_set (&cur, NULL, token->str, NULL);
+        } else {
+          endpoint_set (&cur, NULL, token->str, token->value);
+        }
+        have_cur = TRUE;
+        break;
+
+      case TOKEN_LINK:
+      case TOKEN_CAPS:
+        if (!have_cur || linking) {
+          g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_LINK,
+              "link without source element");
+          goto out;
+        }
+
+        if (token->type == TOKEN_CAPS) {
+          gchar **caps = g_strsplit (token->str, ":", -1);
+
+          /*
+           * Several capsfilters are separated by colons, which may
+           * also occur within caps features, e.g. "(memory:GLMemory)".
+           */
+          for (guint i = 0; caps[i]; i++) {
+            if (caps[i + 1] && !is_caps (g_strchug (caps[i + 1]))) {
+              gchar *joined = g_strconcat (caps[i], ":", caps[i + 1], NULL);
+
+              g_free (caps[i + 1]);
+              caps[i + 1] = joined;
+              continue;
+            }
+
+            element = gste_placeholder_new ("capsfilter", error);
+            if (!element) {
+              g_strfreev (caps);
+              goto out;
+            }
+            gste_placeholder_set_argument (GSTE_PLACEHOLDER (element),
+                "caps", g_strstrip (caps[i]));
+            gst_bin_add (bin, element);
+
+            parser_add_link (parser, &cur, element, NULL, NULL);
+            endpoint_set (&cur, element, NULL, NULL);
+          }
+          g_strfreev (caps);
+        }
+
+        endpoint_set (&src, cur.element, cur.name, cur.pad);
+        endpoint_clear (&cur);
+        have_cur = FALSE;
+        linking = TRUE;
+        break;
+    }
+  }
+
+out:
+  endpoint_clear (&cur);
+  endpoint_clear (&src);
+  g_free (sink_pad);
+  return ret;
+}
+
+static GstElement *
+parser_resolve (Parser * parser, Endpoint * endpoint, GError ** error)
+{
+  GstElement *element = endpoint->element;
+
+  if (!element) {
+    element = gst_bin_get_by_name (parser->top, endpoint->name);
+    if (!element) {
+      g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_NO_SUCH_ELEMENT,
+          "no element named \"%s\"", endpoint->name);
+      return NULL;
+    }
+    /* still owned by its bin */
+    gst_object_unref (element);
+  }
+
+  if (!GSTE_IS_PLACEHOLDER (element)) {
+    g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_LINK,
+        "links to bin \"%s\" are not supported", GST_OBJECT_NAME (element));
+    return NULL;
+  }
+
+  return element;
+}
+
+static gboolean
+parser_link (Parser * parser, Link * link, GError ** error)
+{
+  GstElement *src, *sink;
+  GstPad *src_pad = NULL, *sink_pad = NULL;
+  gboolean ret = FALSE;
+
+  src = parser_resolve (parser, &link->src, error);
+  sink = src ? parser_resolve (parser, &link->sink, error) : NULL;
+  if (!sink)
+    return FALSE;
+
+  src_pad = gste_placeholder_get_link_pad (GSTE_PLACEHOLDER (src),
+      link->src.pad, GST_PAD_SRC);
+  sink_pad = gste_placeholder_get_link_pad (GSTE_PLACEHOLDER (sink),
+      link->sink.pad, GST_PAD_SINK);
+
+  /* ghosts pads for links between bins */
+  if (src_pad && sink_pad)
+    ret = gst_element_link_pads_full (src, GST_OBJECT_NAME (src_pad),
+        sink, GST_OBJECT_NAME (sink_pad), GST_PAD_LINK_CHECK_NOTHING);
+  if (!ret)
+    g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_LINK,
+        "could not link %s to %s", GST_OBJECT_NAME (src),
+        GST_OBJECT_NAME (sink));
+
+  if (src_pad)
+    gst_object_unref (src_pad);
+  if (sink_pad)
+    gst_object_unref (sink_pad);
+
+  return ret;
+}
+
+/*
+ * Like gst_parse_launch(), but elements are replaced with placeholders,
+ * so no plugin is loaded. Bins are instantiated, though.
+ */
+GstElement *
+gste_placeholder_parse_launch (const gchar * description, GError ** error)
+{
+  Parser parser = { .p = description };
+  GstElement *pipeline = gst_pipeline_new (NULL);
+  gboolean ret;
+
+  /* also registers the debug category */
+  g_type_class_ref (GSTE_TYPE_PLACEHOLDER);
+
+  parser.top = GST_BIN (pipeline);
+  parser.links = g_array_new (FALSE, FALSE, sizeof (Link));
+  g_array_set_clear_func (parser.links, (GDestroyNotify) link_clear);
+
+  ret = parser_parse_bin (&parser, parser.top, FALSE, error);
+  for (guint i = 0; ret && i < parser.links->len; i++)
+    ret = parser_link (&parser, &g_array_index (parser.links, Link, i), error);
+
+  token_clear (&parser.token);
+  g_array_unref (parser.links);
+
+  if (ret && !GST_BIN_NUMCHILDREN (pipeline)) {
+    g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_EMPTY,
+        "empty pipeline not allowed");
+    ret = FALSE;
+  }
+  if (!ret) {
+    gst_object_unref (gst_object_ref_sink (pipeline));
+    return NULL;
+  }
+
+  /* like GstParse, single elements are not wrapped into a pipeline */
+  if (GST_BIN_NUMCHILDREN (pipeline) == 1) {
+    GstElement *child = gst_object_ref (GST_BIN_CHILDREN (pipeline)->data);
+
+    gst_bin_remove (GST_BIN (pipeline), child);
+    gst_object_unref (gst_object_ref_sink (pipeline));
+    return child;
+  }
+
+  GST_DEBUG ("parsed structure of %u elements", GST_BIN_NUMCHILDREN (pipeline));
+  return pipeline;
+}
+
+/**********************************************************************
+ * Accessors
+ **********************************************************************/
+
+GstElementFactory *
+gste_placeholder_get_factory (GstePlaceholder * placeholder)
+{
+  return placeholder->factory;
+}
+
+guint
+gste_placeholder_get_n_arguments (GstePlaceholder * placeholder)
+{
+  return placeholder->arguments->len;
+}
+
+/* returns the property name */
+const gchar *
+gste_placeholder_get_argument (GstePlaceholder * placeholder, guint index,
+    const gchar ** value)
+{
+  GstePlaceholderArgument *argument;
+
+  g_return_val_if_fail (index < placeholder->arguments->len, NULL);
+
+  argument = &g_array_index (placeholder->arguments, GstePlaceholderArgument,
+      index);
+  if (value)
+    *value = argument->value;
+  return argument->name;
+}
+
+const gchar *
+gste_placeholder_lookup_argument (GstePlaceholder * placeholder,
+    const gchar * name)
+{
+  for (guint i = 0; i < placeholder->arguments->len; i++) {
+    GstePlaceholderArgument *argument =
+        &g_array_index (placeholder->arguments, GstePlaceholderArgument, i);
+
+    if (!strcmp (argument->name, name))
+      return argument->value;
+  }
+
+  return NULL;
+}
+
+/**********************************************************************
+ * Instantiation
+ **********************************************************************/
+
+/* a link of the placeholder to restore */
+typedef struct _SavedLink {
+  gchar *pad_name;
+  GstPadPresence presence;
+  gchar *template_name;
+  GstPad *peer;
+} SavedLink;
+
+static void
+saved_link_free (SavedLink * link)
+{
+  /* delayed links are freed along with their signal handlers */
+  if (!link)
+    return;
+
+  g_free (link->pad_name);
+  g_free (link->template_name);
+  if (link->peer)
+    gst_object_unref (link->peer);
+  g_free (link);
+}
+
+/* links sometimes pads once they appear, like GstParse does */
+static void
+delayed_link_pad_added_cb (GstElement * element, GstPad * pad,
+    SavedLink * link)
+{
+  GstPadTemplate *templ = gst_pad_get_pad_template (pad);
+  gboolean matches = templ &&
+      !strcmp (GST_PAD_TEMPLATE_NAME_TEMPLATE (templ), link->template_name);
+
+  if (templ)
+    gst_object_unref (templ);
+
+  if (matches && !gst_pad_is_linked (pad) && !gst_pad_is_linked (link->peer) &&
+      GST_PAD_LINK_FAILED (link_pads (pad, link->peer)))
+    GST_WARNING_OBJECT (element, "could not link %s:%s", GST_DEBUG_PAD_NAME (pad));
+}
+
+/*
+ * Replaces placeholder with the real element in its bin and links it
+ * like the placeholder was. This loads the element's plugin.
+ * Returns the new element (transfer none) or NULL if it cannot be
+ * instantiated, in which case the placeholder is left alone.
+ */
+GstElement *
+gste_placeholder_instantiate (GstePlaceholder * placeholder, GError ** error)
+{
+  GstElement *element = GST_ELEMENT (placeholder);
+  GstBin *bin = GST_BIN (GST_OBJECT_PARENT (placeholder));
+  GstElement *real;
+  GList *links = NULL;
+  gchar *name;
+
+  g_return_val_if_fail (GSTE_IS_PLACEHOLDER (placeholder), NULL);
+  g_return_val_if_fail (bin != NULL, NULL);
+
+  real = gst_element_factory_create (placeholder->factory, NULL);
+  if (!real) {
+    g_set_error (error, GST_PARSE_ERROR, GST_PARSE_ERROR_NO_SUCH_ELEMENT,
+        "could not create element \"%s\"",
+        GST_OBJECT_NAME (placeholder->factory));
+    return NULL;
+  }
+
+  for (guint i = 0; i < placeholder->arguments->len; i++) {
+    GstePlaceholderArgument *argument =
+        &g_array_index (placeholder->arguments, GstePlaceholderArgument, i);
+
+    if (!gste_object_set_argument (G_OBJECT (real), argument->name,
+            argument->value, error)) {
+      gst_object_unref (gst_object_ref_sink (real));
+      return NULL;
+    }
+  }
+
+  /*
+   * Save and remove all links, so the placeholder can be replaced.
+   */
+  for (GList *l = GST_ELEMENT_PADS (element); l; l = g_list_next (l)) {
+    GstPad *pad = GST_PAD (l->data);
+    GstPadTemplate *templ = GST_PAD_PAD_TEMPLATE (pad);
+    SavedLink *link;
+    GstPad *peer = gst_pad_get_peer (pad);
+
+    if (!peer)
+      continue;
+
+    link = g_new0 (SavedLink, 1);
+    link->pad_name = g_strdup (GST_OBJECT_NAME (pad));
+    link->presence = templ ? GST_PAD_TEMPLATE_PRESENCE (templ) : GST_PAD_ALWAYS;
+    link->template_name =
+        g_strdup (templ ? GST_PAD_TEMPLATE_NAME_TEMPLATE (templ) : NULL);
+    link->peer = peer;
+    links = g_list_prepend (links, link);
+
+    if (GST_PAD_IS_SRC (pad))
+      gst_pad_unlink (pad, peer);
+    else
+      gst_pad_unlink (peer, pad);
+  }
+
+  name = g_strdup (GST_OBJECT_NAME (placeholder));
+  gst_bin_remove (bin, element);
+  gst_object_set_name (GST_OBJECT (real), name);
+  g_free (name);
+  gst_bin_add (bin, real);
+
+  for (GList *l = links; l; l = g_list_next (l)) {
+    SavedLink *link = l->data;
+    GstPad *pad = gst_element_get_static_pad (real, link->pad_name);
+
+    if (!pad && link->presence == GST_PAD_REQUEST) {
+      GstPadTemplate *templ = gst_element_class_get_pad_template (
+          GST_ELEMENT_GET_CLASS (real), link->template_name);
+
+      if (templ)
+        pad = gst_element_request_pad (real, templ, NULL, NULL);
+    } else if (!pad && link->presence == GST_PAD_SOMETIMES) {
+      g_signal_connect_data (real, "pad-added",
+          G_CALLBACK (delayed_link_pad_added_cb), link,
+          (GClosureNotify) saved_link_free, 0);
+      l->data = NULL;
+      continue;
+    }
+
+    if (!pad || GST_PAD_LINK_FAILED (link_pads (pad, link->peer)))
+      GST_WARNING_OBJECT (real, "could not restore link of pad %s",
+          link->pad_name);
+    if (pad)
+      gst_object_unref (pad);
+  }
+  g_list_free_full (links, (GDestroyNotify) saved_link_free);
+
+  return real;
+}
@@ -0,0 +1,61 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GSTE_PLACEHOLDER_H__
+#define __GSTE_PLACEHOLDER_H__
+
+#include <glib.h>
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GSTE_TYPE_PLACEHOLDER (gste_placeholder_get_type ())
+#define GSTE_PLACEHOLDER(obj) \
+    (G_TYPE_CHECK_INSTANCE_CAST ((obj), GSTE_TYPE_PLACEHOLDER, GstePlaceholder))
+#define GSTE_IS_PLACEHOLDER(obj) \
+    (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GSTE_TYPE_PLACEHOLDER))
+
+/**
+ * Stands in for an element that has not been instantiated yet.
+ * Placeholders are created from the registry's cached factory metadata,
+ * so no plugin has to be loaded. They have the pads of the factory's
+ * static pad templates and remember the property assignments
+ * ("arguments") of the pipeline description, which are only applied
+ * by gste_placeholder_instantiate().
+ */
+typedef struct _GstePlaceholder GstePlaceholder;
+typedef struct _GstePlaceholderClass GstePlaceholderClass;
+
+GType gste_placeholder_get_type (void);
+
+GstElement *gste_placeholder_parse_launch (const gchar * description,
+    GError ** error);
+
+GstElementFactory *gste_placeholder_get_factory (GstePlaceholder * placeholder);
+guint gste_placeholder_get_n_arguments (GstePlaceholder * placeholder);
+const gchar *gste_placeholder_get_argument (GstePlaceholder * placeholder,
+    guint index, const gchar ** value);
+const gchar *gste_placeholder_lookup_argument (GstePlaceholder * placeholder,
+    const gchar * name);
+
+GstElement *gste_placeholder_instantiate (GstePlaceholder * placeholder,
+    GError ** error);
+
+G_END_DECLS
+
+#endif /* __GSTE_PLACEHOLDER_H__ */
@@ -27,21 +27,51 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <gio/gio.h>
+
+#ifdef G_OS_WIN32
+#include <io.h>
+#define write _write
+#else
+#include <unistd.h>
+#endif
 
 #include <gst/gst.h>
 
 #include "gste-serialize.h"
+#include "gste-placeholder.h"
+
+/* size of the GsteSerializeSink buffer */
+#define GSTE_SERIALIZE_SINK_CHUNK_SIZE (64 * 1024)
+
+struct _GsteSerializeSink {
+  /* either a stream or a file descriptor */
+  GOutputStream *stream;
+  gint fd;
+
+  gchar *buffer;
+  gsize len;
+
+  /* the first write error: further output is discarded */
+  GError *error;
+};
 
 typedef struct _GsteSerializeCallbacks {
+  /* either the sink or the append callback is used */
+  GsteSerializeSink *sink;
   GsteSerializeAppendCallback append;
   GsteSerializeObjectSavedCallback object_saved;
   gpointer user_data;
 
   GsteSerializeFlags flags;
   guint recursion_depth;
+
+  /* records the output while building a cached fragment */
+  GString *fragment;
 } GsteSerializeCallbacks;
 
 static guint gst_element_count_pads (GstElement * element, GstPadDirection direction);
@@ -49,6 +79,171 @@ static guint gst_element_count_pads (GstElement * element, GstPadDirection direc
 static void gst_object_save_thyself (GstObject * object,
     GstElement * last_element, GstElement * next_element, GsteSerializeCallbacks * cb);
 
+/**********************************************************************
+ * Buffered output
+ **********************************************************************/
+
+static void
+gste_serialize_sink_write_out (GsteSerializeSink * sink,
+    const gchar * data, gsize len)
+{
+  if (sink->error)
+    return;
+
+  if (sink->stream) {
+    g_output_stream_write_all (sink->stream, data, len, NULL, NULL,
+        &sink->error);
+    return;
+  }
+
+  while (len > 0) {
+    gssize written = write (sink->fd, data, len);
+
+    if (written < 0) {
+      gint saved_errno = errno;
+
+      if (saved_errno == EINTR)
+        continue;
+
+      g_set_error (&sink->error, G_FILE_ERROR,
+          g_file_error_from_errno (saved_errno),
+          "Error writing to file descriptor %d: %s",
+          sink->fd, g_strerror (saved_errno));
+      return;
+    }
+
+    data += written;
+    len -= written;
+  }
+}
+
+static GsteSerializeSink *
+gste_serialize_sink_new_internal (void)
+{
+  GsteSerializeSink *sink = g_new0 (GsteSerializeSink, 1);
+
+  sink->fd = -1;
+  sink->buffer = g_malloc (GSTE_SERIALIZE_SINK_CHUNK_SIZE);
+
+  return sink;
+}
+
+/**
+ * Create a sink writing the serialization to stream in
+ * chunks of GSTE_SERIALIZE_SINK_CHUNK_SIZE bytes.
+ * The stream is not closed when the sink is freed.
+ */
+GsteSerializeSink *
+gste_serialize_sink_new (GOutputStream * stream)
+{
+  GsteSerializeSink *sink;
+
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), NULL);
+
+  sink = gste_serialize_sink_new_internal ();
+  sink->stream = g_object_ref (stream);
+
+  return sink;
+}
+
+/**
+ * Like gste_serialize_sink_new(), but writing to a file descriptor.
+ * The file descriptor is not closed when the sink is freed.
+ */
+GsteSerializeSink *
+gste_serialize_sink_new_for_fd (gint fd)
+{
+  GsteSerializeSink *sink;
+
+  g_return_val_if_fail (fd >= 0, NULL);
+
+  sink = gste_serialize_sink_new_internal ();
+  sink->fd = fd;
+
+  return sink;
+}
+
+/**
+ * Write len bytes of str (or all of it if len is negative) into the sink.
+ * Errors are deferred to gste_serialize_sink_flush().
+ */
+void
+gste_serialize_sink_write (GsteSerializeSink * sink, const gchar * str,
+    gssize len)
+{
+  if (len < 0)
+    len = strlen (str);
+
+  if (sink->len + len > GSTE_SERIALIZE_SINK_CHUNK_SIZE) {
+    gste_serialize_sink_write_out (sink, sink->buffer, sink->len);
+    sink->len = 0;
+
+    /* large strings (e.g. caps) need not be copied */
+    if (len >= GSTE_SERIALIZE_SINK_CHUNK_SIZE) {
+      gste_serialize_sink_write_out (sink, str, len);
+      return;
+    }
+  }
+
+  memcpy (sink->buffer + sink->len, str, len);
+  sink->len += len;
+}
+
+/**
+ * Write all buffered data.
+ * Returns FALSE if any write has failed so far.
+ */
+gboolean
+gste_serialize_sink_flush (GsteSerializeSink * sink, GError ** error)
+{
+  gste_serialize_sink_write_out (sink, sink->buffer, sink->len);
+  sink->len = 0;
+
+  if (sink->stream && !sink->error)
+    g_output_stream_flush (sink->stream, NULL, &sink->error);
+
+  if (sink->error) {
+    g_propagate_error (error, g_error_copy (sink->error));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+ * Flush and free the sink.
+ * Returns FALSE if any write has failed.
+ */
+gboolean
+gste_serialize_sink_free (GsteSerializeSink * sink, GError ** error)
+{
+  gboolean ret = gste_serialize_sink_flush (sink, error);
+
+  if (sink->stream)
+    g_object_unref (sink->stream);
+  g_clear_error (&sink->error);
+  g_free (sink->buffer);
+  g_free (sink);
+
+  return ret;
+}
+
+/**********************************************************************
+ * Serialization
+ **********************************************************************/
+
+static inline void
+serialize_append (GsteSerializeCallbacks * cb, const gchar * str)
+{
+  if (cb->fragment)
+    g_string_append (cb->fragment, str);
+
+  if (cb->sink)
+    gste_serialize_sink_write (cb->sink, str, -1);
+  else
+    cb->append (str, cb->user_data);
+}
+
 static inline void
 append_space (GsteSerializeCallbacks * cb)
 {
@@ -56,7 +251,7 @@ append_space (GsteSerializeCallbacks * cb)
    * The first space is omitted.
    */
   if (cb->flags & GSTE_SERIALIZE_NEED_SPACE)
-    cb->append (" ", cb->user_data);
+    serialize_append (cb, " ");
   cb->flags |= GSTE_SERIALIZE_NEED_SPACE;
 }
 
@@ -102,8 +297,30 @@ gst_is_capsfilter (GstObject * object, GsteSerializeCallbacks * cb)
    * GstCapsFilter has no public header, so we identify it using
    * its class name.
    */
-  return !(cb->flags & GSTE_SERIALIZE_CAPSFILTER_AS_ELEMENT) &&
-      !g_strcmp0 (G_OBJECT_TYPE_NAME (object), "GstCapsFilter");
+  if (cb->flags & GSTE_SERIALIZE_CAPSFILTER_AS_ELEMENT)
+    return FALSE;
+
+  if (GSTE_IS_PLACEHOLDER (object))
+    return !strcmp (GST_OBJECT_NAME (gste_placeholder_get_factory (
+                GSTE_PLACEHOLDER (object))), "capsfilter");
+
+  return !g_strcmp0 (G_OBJECT_TYPE_NAME (object), "GstCapsFilter");
+}
+
+static GstCaps *
+gst_capsfilter_get_caps (GstObject * capsfilter)
+{
+  GstCaps *caps = NULL;
+
+  if (GSTE_IS_PLACEHOLDER (capsfilter)) {
+    const gchar *str = gste_placeholder_lookup_argument (
+        GSTE_PLACEHOLDER (capsfilter), "caps");
+
+    return str ? gst_caps_from_string (str) : NULL;
+  }
+
+  g_object_get (capsfilter, "caps", &caps, NULL);
+  return caps;
 }
 
 static GstPad *
@@ -158,9 +375,8 @@ gst_pad_get_peer_with_caps (GstPad * pad, GList ** caps_list, GsteSerializeCallb
        * We simply ignore those capsfilters.
        */
       if (caps_list) {
-        GstCaps *caps;
+        GstCaps *caps = gst_capsfilter_get_caps (GST_OBJECT_PARENT (peer));
 
-        g_object_get (GST_OBJECT_PARENT (peer), "caps", &caps, NULL);
         if (caps) {
           /*
            * Empty and ANY caps cannot be serialized in the special
@@ -209,9 +425,9 @@ gst_pad_save_name (GstPad * pad, gboolean have_dot, GsteSerializeCallbacks * cb)
      */
     if (!have_dot) {
       append_space (cb);
-      cb->append (".", cb->user_data);
+      serialize_append (cb, ".");
     }
-    cb->append (GST_PAD_TEMPLATE_NAME_TEMPLATE (pad_template), cb->user_data);
+    serialize_append (cb, GST_PAD_TEMPLATE_NAME_TEMPLATE (pad_template));
   } else if (cb->flags & GSTE_SERIALIZE_VERBOSE ||
       !parent || gst_element_count_pads (GST_ELEMENT (parent), direction) > 1) {
     /*
@@ -220,9 +436,9 @@ gst_pad_save_name (GstPad * pad, gboolean have_dot, GsteSerializeCallbacks * cb)
      */
     if (!have_dot) {
       append_space (cb);
-      cb->append (".", cb->user_data);
+      serialize_append (cb, ".");
     }
-    cb->append (GST_OBJECT_NAME (pad), cb->user_data);
+    serialize_append (cb, GST_OBJECT_NAME (pad));
   }
 
   if (pad_template)
@@ -266,8 +482,8 @@ gst_pad_save_thyself (GstPad * pad, GstElement * last_element, GstElement * next
      * This assumes that the peer's parent already has an unique name.
      * FIXME: Guarantee that.
      */
-    cb->append (GST_OBJECT_NAME (parent), cb->user_data);
-    cb->append (".", cb->user_data);
+    serialize_append (cb, GST_OBJECT_NAME (parent));
+    serialize_append (cb, ".");
     gst_pad_save_name (pad, TRUE, cb);
   } else {
     gst_pad_save_name (pad, FALSE, cb);
@@ -289,7 +505,7 @@ gst_pad_save_thyself (GstPad * pad, GstElement * last_element, GstElement * next
      * GstCapsFilter elements only have one static "sink" and "src" pad.
      */
     append_space (cb);
-    cb->append ("!", cb->user_data);
+    serialize_append (cb, "!");
 
     append_space (cb);
     /*
@@ -298,24 +514,24 @@ gst_pad_save_thyself (GstPad * pad, GstElement * last_element, GstElement * next
      * When parsing with gst_parse_launch() is used for parsing, we do not
      * actually need the quotes and they will result in parsing errors.
      */
-    //cb->append ("'", cb->user_data);
+    //serialize_append (cb, "'");
 
     for (GList *cur = caps_list; cur != NULL; cur = g_list_next (cur)) {
       gchar *contents = gst_caps_to_string (GST_CAPS_CAST (cur->data));
-      cb->append (contents, cb->user_data);
+      serialize_append (cb, contents);
       g_free (contents);
 
       if (g_list_next (cur))
-        cb->append (":", cb->user_data);
+        serialize_append (cb, ":");
     }
 
-    //cb->append ("'", cb->user_data);
+    //serialize_append (cb, "'");
   }
 
   g_list_free_full (caps_list, (GDestroyNotify)gst_caps_unref);
 
   append_space (cb);
-  cb->append ("!", cb->user_data);
+  serialize_append (cb, "!");
 
   /*
    * For pads serialized as part of a bin, the link's sink
@@ -329,8 +545,8 @@ gst_pad_save_thyself (GstPad * pad, GstElement * last_element, GstElement * next
      * This assumes that the peer's parent already has a unique name.
      * FIXME: Guarantee that.
      */
-    cb->append (GST_OBJECT_NAME (peer_parent), cb->user_data);
-    cb->append (".", cb->user_data);
+    serialize_append (cb, GST_OBJECT_NAME (peer_parent));
+    serialize_append (cb, ".");
     gst_pad_save_name (peer, TRUE, cb);
   } else {
     gst_pad_save_name (peer, FALSE, cb);
@@ -339,10 +555,25 @@ gst_pad_save_thyself (GstPad * pad, GstElement * last_element, GstElement * next
   gst_object_unref (peer);
 }
 
-static void
-gst_object_save_properties (GstObject * object, GsteSerializeCallbacks * cb)
+/*
+ * The serializable properties of a class and their default values.
+ * Properties can only be installed when a class is initialized,
+ * so plans are cached per GType for the lifetime of the process.
+ */
+typedef struct _GsteSerializePlan {
+  guint n_specs;
+  GParamSpec **specs;
+  GValue *defaults;
+} GsteSerializePlan;
+
+/* GType -> GsteSerializePlan */
+static GHashTable *serialize_plans = NULL;
+G_LOCK_DEFINE_STATIC (serialize_plans);
+
+static GsteSerializePlan *
+gste_serialize_plan_new (GObjectClass * klass)
 {
-  GObjectClass *klass = G_OBJECT_GET_CLASS (object);
+  GsteSerializePlan *plan = g_new0 (GsteSerializePlan, 1);
   GParamSpec **specs;
   guint nspecs;
 
@@ -350,9 +581,11 @@ gst_object_save_properties (GstObject * object, GsteSerializeCallbacks * cb)
    * Iterate all properties of the object's class.
    */
   specs = g_object_class_list_properties (klass, &nspecs);
+  plan->specs = g_new (GParamSpec *, nspecs);
+  plan->defaults = g_new0 (GValue, nspecs);
+
   for (guint i = 0; i < nspecs; i++) {
     GParamSpec *spec = specs[i];
-    GValue value = G_VALUE_INIT;
 
     if (!(spec->flags & G_PARAM_READABLE))
       continue;
@@ -377,10 +610,167 @@ gst_object_save_properties (GstObject * object, GsteSerializeCallbacks * cb)
     if (!strcmp (spec->name, "parent"))
       continue;
 
+    /*
+     * This is what g_param_value_defaults() compares against,
+     * but without constructing the default value every time.
+     */
+    g_value_init (&plan->defaults[plan->n_specs], spec->value_type);
+    g_param_value_set_default (spec, &plan->defaults[plan->n_specs]);
+    plan->specs[plan->n_specs++] = g_param_spec_ref (spec);
+  }
+  g_free (specs);
+
+  return plan;
+}
+
+static const GsteSerializePlan *
+gste_serialize_get_plan (GObjectClass * klass)
+{
+  gpointer type = GSIZE_TO_POINTER (G_OBJECT_CLASS_TYPE (klass));
+  GsteSerializePlan *plan;
+
+  G_LOCK (serialize_plans);
+
+  if (G_UNLIKELY (!serialize_plans))
+    serialize_plans = g_hash_table_new (NULL, NULL);
+
+  plan = g_hash_table_lookup (serialize_plans, type);
+  if (!plan) {
+    plan = gste_serialize_plan_new (klass);
+    g_hash_table_insert (serialize_plans, type, plan);
+  }
+
+  G_UNLOCK (serialize_plans);
+
+  return plan;
+}
+
+/*
+ * Serialized properties of an object (see GSTE_SERIALIZE_CACHE).
+ * Fragments are attached to their objects, so they are freed
+ * along with them.
+ */
+typedef struct _GsteSerializeFragment {
+  /* set atomically when a property changes */
+  gint dirty;
+
+  /* state the fragment was built with */
+  gboolean verbose;
+  gchar *name;
+
+  GString *str;
+} GsteSerializeFragment;
+
+/* protects the contents of all fragments */
+G_LOCK_DEFINE_STATIC (serialize_fragments);
+
+static void
+gste_serialize_fragment_free (GsteSerializeFragment * fragment)
+{
+  g_free (fragment->name);
+  g_string_free (fragment->str, TRUE);
+  g_free (fragment);
+}
+
+/* may be invoked from any thread */
+static void
+gste_serialize_fragment_notify_cb (GObject * object, GParamSpec * pspec,
+    GsteSerializeFragment * fragment)
+{
+  g_atomic_int_set (&fragment->dirty, TRUE);
+}
+
+static GsteSerializeFragment *
+gste_serialize_get_fragment (GstObject * object)
+{
+  static GQuark fragment_quark = 0;
+  GsteSerializeFragment *fragment;
+
+  if (G_UNLIKELY (!fragment_quark))
+    fragment_quark = g_quark_from_static_string ("gste-serialize-fragment");
+
+  fragment = g_object_get_qdata (G_OBJECT (object), fragment_quark);
+  if (!fragment) {
+    fragment = g_new0 (GsteSerializeFragment, 1);
+    fragment->dirty = TRUE;
+    fragment->str = g_string_new ("");
+
+    g_object_set_qdata_full (G_OBJECT (object), fragment_quark, fragment,
+        (GDestroyNotify) gste_serialize_fragment_free);
+    g_signal_connect (object, "notify",
+        G_CALLBACK (gste_serialize_fragment_notify_cb), fragment);
+  }
+
+  return fragment;
+}
+
+static void gst_object_save_properties_uncached (GstObject * object,
+    GsteSerializeCallbacks * cb);
+
+static void
+gst_object_save_properties (GstObject * object, GsteSerializeCallbacks * cb)
+{
+  GsteSerializeFragment *fragment;
+  gboolean verbose = !!(cb->flags & GSTE_SERIALIZE_VERBOSE);
+
+  if (!(cb->flags & GSTE_SERIALIZE_CACHE)) {
+    gst_object_save_properties_uncached (object, cb);
+    return;
+  }
+
+  G_LOCK (serialize_fragments);
+
+  fragment = gste_serialize_get_fragment (object);
+
+  /*
+   * Renaming objects does not necessarily emit "notify".
+   * The fragment always starts with a space (if not empty) since
+   * it follows the factory name or bracket, so reusing it
+   * does not change the GSTE_SERIALIZE_NEED_SPACE state.
+   */
+  if (!g_atomic_int_get (&fragment->dirty) && fragment->verbose == verbose &&
+      !g_strcmp0 (fragment->name, GST_OBJECT_NAME (object))) {
+    if (fragment->str->len > 0) {
+      if (cb->sink)
+        gste_serialize_sink_write (cb->sink, fragment->str->str,
+            fragment->str->len);
+      else
+        cb->append (fragment->str->str, cb->user_data);
+    }
+    G_UNLOCK (serialize_fragments);
+    return;
+  }
+
+  /* properties changing while we serialize will invalidate it again */
+  g_atomic_int_set (&fragment->dirty, FALSE);
+  fragment->verbose = verbose;
+  g_free (fragment->name);
+  fragment->name = g_strdup (GST_OBJECT_NAME (object));
+  g_string_truncate (fragment->str, 0);
+
+  cb->fragment = fragment->str;
+  gst_object_save_properties_uncached (object, cb);
+  cb->fragment = NULL;
+
+  G_UNLOCK (serialize_fragments);
+}
+
+static void
+gst_object_save_properties_uncached (GstObject * object,
+    GsteSerializeCallbacks * cb)
+{
+  GObjectClass *klass = G_OBJECT_GET_CLASS (object);
+  const GsteSerializePlan *plan = gste_serialize_get_plan (klass);
+
+  for (guint i = 0; i < plan->n_specs; i++) {
+    GParamSpec *spec = plan->specs[i];
+    GValue value = G_VALUE_INIT;
+
     g_value_init (&value, spec->value_type);
     g_object_get_property (G_OBJECT (object), spec->name, &value);
 
-    if (!(cb->flags & GSTE_SERIALIZE_VERBOSE) && g_param_value_defaults (spec, &value)) {
+    if (!(cb->flags & GSTE_SERIALIZE_VERBOSE) &&
+        g_param_values_cmp (spec, &value, &plan->defaults[i]) == 0) {
       /*
        * To make output more readable, properties with their default values can
        * be skipped since GstParse will initialize them with the same value
@@ -397,8 +787,8 @@ gst_object_save_properties (GstObject * object, GsteSerializeCallbacks * cb)
        * gst_value_serialize() will log a critical message.
        */
       append_space (cb);
-      cb->append (spec->name, cb->user_data);
-      cb->append ("=\"\"", cb->user_data);
+      serialize_append (cb, spec->name);
+      serialize_append (cb, "=\"\"");
     } else {
       /*
        * The GstParse deserialization (see gst_parse_element_set() in grammar.y)
@@ -421,9 +811,9 @@ gst_object_save_properties (GstObject * object, GsteSerializeCallbacks * cb)
         gchar *quoted = gste_serialize_quote (contents);
 
         append_space (cb);
-        cb->append (spec->name, cb->user_data);
-        cb->append ("=", cb->user_data);
-        cb->append (quoted, cb->user_data);
+        serialize_append (cb, spec->name);
+        serialize_append (cb, "=");
+        serialize_append (cb, quoted);
 
         g_free (quoted);
       } else {
@@ -444,7 +834,6 @@ gst_object_save_properties (GstObject * object, GsteSerializeCallbacks * cb)
 
     g_value_unset (&value);
   }
-  g_free (specs);
 }
 
 static guint
@@ -544,14 +933,16 @@ static void
 gst_element_save_thyself (GstElement * element, GstElement * next_element,
     GsteSerializeCallbacks * cb)
 {
-  GstElementFactory *factory = gst_element_get_factory (element);
+  GstElementFactory *factory = GSTE_IS_PLACEHOLDER (element) ?
+      gste_placeholder_get_factory (GSTE_PLACEHOLDER (element)) :
+      gst_element_get_factory (element);
 
   /*
    * The GstParse syntax expects the name of the element's
    * factory instead of its GType name.
    */
   append_space (cb);
-  cb->append (GST_OBJECT_NAME (factory), cb->user_data);
+  serialize_append (cb, GST_OBJECT_NAME (factory));
 
   /*
    * Serialize all properties of the element.
@@ -559,6 +950,26 @@ gst_element_save_thyself (GstElement * element, GstElement * next_element,
    */
   gst_object_save_properties (GST_OBJECT (element), cb);
 
+  /*
+   * Placeholders only have a name, but remember the properties
+   * of the element they stand in for.
+   */
+  if (GSTE_IS_PLACEHOLDER (element)) {
+    GstePlaceholder *placeholder = GSTE_PLACEHOLDER (element);
+
+    for (guint i = 0; i < gste_placeholder_get_n_arguments (placeholder); i++) {
+      const gchar *value;
+      const gchar *name = gste_placeholder_get_argument (placeholder, i, &value);
+      gchar *quoted = gste_serialize_quote (value);
+
+      append_space (cb);
+      serialize_append (cb, name);
+      serialize_append (cb, "=");
+      serialize_append (cb, quoted);
+      g_free (quoted);
+    }
+  }
+
   /*
    * This outputs links following the element serialization.
    */
@@ -625,11 +1036,11 @@ gst_bin_save_thyself (GstBin * bin, GstElement * next_element,
       G_OBJECT_TYPE (bin) != GST_TYPE_BIN) {
     GstElementFactory *factory = gst_element_get_factory (GST_ELEMENT (bin));
 
-    cb->append (GST_OBJECT_NAME (factory), cb->user_data);
-    cb->append (".", cb->user_data);
+    serialize_append (cb, GST_OBJECT_NAME (factory));
+    serialize_append (cb, ".");
   }
 
-  cb->append ("(", cb->user_data);
+  serialize_append (cb, "(");
 
   /*
    * Serialize all properties and children of the bin.
@@ -649,7 +1060,7 @@ gst_bin_save_thyself (GstBin * bin, GstElement * next_element,
    * This is apparently a bug in GstParse.
    */
   append_space (cb);
-  cb->append (")", cb->user_data);
+  serialize_append (cb, ")");
 
   /*
    * Even though GstBins have pads as well we do not serialize
@@ -748,20 +1159,37 @@ gste_serialize_save (GstObject * object, GsteSerializeFlags flags,
   gst_object_save_thyself (object, NULL, NULL, &cb);
 }
 
+/**
+ * Like gste_serialize_save(), but the serialization is written
+ * into sink instead of being passed to a callback token by token.
+ * Write errors are reported by gste_serialize_sink_flush()
+ * or gste_serialize_sink_free().
+ */
+void
+gste_serialize_save_to_sink (GstObject * object, GsteSerializeFlags flags,
+    GsteSerializeSink * sink,
+    GsteSerializeObjectSavedCallback object_saved,
+    gpointer user_data)
+{
+  GsteSerializeCallbacks cb = {
+      .sink = sink,
+      .object_saved = object_saved,
+      .user_data = user_data,
+      .flags = flags,
+      .recursion_depth = 0
+  };
+
+  gst_object_save_thyself (object, NULL, NULL, &cb);
+}
+
 /*
  * Test program. Compile with:
- * gcc -g -O0 -Wall -std=c99 -o gste-serialize gste-serialize.c -DGSTE_SERIALIZE_TEST \
- *     `pkg-config --cflags --libs gstreamer-1.0`
+ * gcc -g -O0 -Wall -std=c99 -o gste-serialize gste-serialize.c gste-placeholder.c \
+ *     -DGSTE_SERIALIZE_TEST \
+ *     `pkg-config --cflags --libs gstreamer-1.0 gio-2.0`
  */
 #ifdef GSTE_SERIALIZE_TEST
 
-static void
-append_stdio_cb (const gchar * str, gpointer user_data)
-{
-  FILE *stream = user_data;
-  fputs(str, stream);
-}
-
 int
 main (int argc, char **argv)
 {
@@ -770,6 +1198,7 @@ main (int argc, char **argv)
   GsteSerializeFlags flags;
   const gchar *element_name;
   GstElement *pipeline, *element;
+  GsteSerializeSink *sink;
 
   g_log_set_always_fatal (G_LOG_LEVEL_ERROR |
       G_LOG_LEVEL_CRITICAL | G_LOG_LEVEL_WARNING);
@@ -798,8 +1227,11 @@ main (int argc, char **argv)
     g_error ("Element not found!");
 
   g_printf ("Serialized pipeline:\n\"");
-  gste_serialize_save (GST_OBJECT (element), flags,
-      append_stdio_cb, NULL, stdout);
+  fflush (stdout);
+  sink = gste_serialize_sink_new_for_fd (1);
+  gste_serialize_save_to_sink (GST_OBJECT (element), flags, sink, NULL, NULL);
+  if (!gste_serialize_sink_free (sink, &error))
+    g_error ("Output error: %s", error->message);
   g_printf ("\"\n");
 
   return 0;
@@ -21,6 +21,7 @@
 #define __GSTE_SERIALIZE_H__
 
 #include <glib.h>
+#include <gio/gio.h>
 
 #include <gst/gst.h>
 
@@ -29,6 +30,12 @@ typedef void (*GsteSerializeAppendCallback) (const gchar * str,
 typedef void (*GsteSerializeObjectSavedCallback) (GstObject * gstobject,
     gpointer user_data);
 
+/**
+ * Buffered output of serializations into a GOutputStream
+ * or file descriptor.
+ */
+typedef struct _GsteSerializeSink GsteSerializeSink;
+
 typedef enum _GsteSerializeFlags {
   /**
    * @private
@@ -60,12 +67,31 @@ typedef enum _GsteSerializeFlags {
    * On the other hand, because of GstCapsFilter elements being curiously
    * ordered in the containing GstBin, the result will be much less readable.
    */
-  GSTE_SERIALIZE_CAPSFILTER_AS_ELEMENT = (1 << 4)
+  GSTE_SERIALIZE_CAPSFILTER_AS_ELEMENT = (1 << 4),
+  /**
+   * Cache the serialized properties of every object and reuse them
+   * in later serializations until one of its properties is changed.
+   * This relies on objects emitting the "notify" signal.
+   * It does not affect the serialization itself and should not be
+   * stored along with the other flags.
+   */
+  GSTE_SERIALIZE_CACHE                 = (1 << 5)
 } GsteSerializeFlags;
 
 void gste_serialize_save (GstObject * object, GsteSerializeFlags flags,
     GsteSerializeAppendCallback append,
     GsteSerializeObjectSavedCallback object_saved,
     gpointer user_data);
+void gste_serialize_save_to_sink (GstObject * object, GsteSerializeFlags flags,
+    GsteSerializeSink * sink,
+    GsteSerializeObjectSavedCallback object_saved,
+    gpointer user_data);
+
+GsteSerializeSink *gste_serialize_sink_new (GOutputStream * stream);
+GsteSerializeSink *gste_serialize_sink_new_for_fd (gint fd);
+void gste_serialize_sink_write (GsteSerializeSink * sink, const gchar * str,
+    gssize len);
+gboolean gste_serialize_sink_flush (GsteSerializeSink * sink, GError ** error);
+gboolean gste_serialize_sink_free (GsteSerializeSink * sink, GError ** error);
 
 #endif /* __GSTE_SERIALIZE_H__ */
@@ -74,9 +74,17 @@ gsth_element_unlink_all (GstElement * element)
 void
 goo_canvas_item_simple_show (GooCanvasItemSimple * item)
 {
+  GooCanvasItemVisibility visibility;
+  gdouble threshold;
+
   g_return_if_fail (GOO_IS_CANVAS_ITEM (item));
-  if (!goo_canvas_item_is_visible (GOO_CANVAS_ITEM (item))) {
-    g_object_set (item, "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
+  g_object_get (item, "visibility", &visibility,
+      "visibility-threshold", &threshold, NULL);
+  if (visibility <= GOO_CANVAS_ITEM_INVISIBLE) {
+    /* details remain hidden when zoomed out, see gst_editor_item_set_detail() */
+    g_object_set (item, "visibility", threshold > 0. ?
+        GOO_CANVAS_ITEM_VISIBLE_ABOVE_THRESHOLD : GOO_CANVAS_ITEM_VISIBLE,
+        NULL);
     goo_canvas_request_redraw (item->canvas, &item->bounds);
   }
 }
@@ -91,8 +99,11 @@ goo_canvas_item_simple_show (GooCanvasItemSimple * item)
 void
 goo_canvas_item_simple_hide (GooCanvasItemSimple * item)
 {
+  GooCanvasItemVisibility visibility;
+
   g_return_if_fail (GOO_IS_CANVAS_ITEM (item));
-  if (goo_canvas_item_is_visible (GOO_CANVAS_ITEM (item))) {
+  g_object_get (item, "visibility", &visibility, NULL);
+  if (visibility > GOO_CANVAS_ITEM_INVISIBLE) {
     g_object_set (item, "visibility", GOO_CANVAS_ITEM_INVISIBLE,
         NULL);  // GOO_CANVAS_ITEM_HIDDEN ??
     if (item->canvas) {
@@ -23,8 +23,6 @@
 #include <stdarg.h>
 #include <sys/stat.h>
 #include <unistd.h>
-#include <sys/time.h>
-#include <pthread.h>
 
 #include <glib/gi18n-lib.h>
 #include <gtk/gtk.h>
@@ -35,6 +33,9 @@
 #include "gsteditorcanvas.h"
 #include "gsteditorelement.h"
 #include "gsteditorproperty.h"
+#include "gsteditorlayout.h"
+#include "gsteditorautosave.h"
+#include "gsteditorloader.h"
 #include "namedicons.h"
 
 #include <gst/common/gste-common.h>
@@ -73,9 +74,13 @@ static gboolean on_property_window_delete (GtkWidget * widget,
 static void on_element_tree_select (GstElementBrowserElementTree * element_tree,
     gpointer user_data);
 
+static void on_load_cancel (GtkButton * button, GstEditor * editor);
 static void gst_editor_statusbar_message (GstEditor * editor,
     const gchar * message, ...) G_GNUC_PRINTF (2, 3);
 
+static void on_saved (const gchar * filename, const GError * error,
+    gpointer user_data);
+
 #define STATUSBAR_TIMEOUT 4200
 
 enum
@@ -249,6 +254,22 @@ gst_editor_init (GstEditor * editor)
     GTK_STATUSBAR (gtk_builder_get_object (editor->builder, "status_bar"));
   editor->statusbar_timeout_id = 0;
 
+  /* shown while a pipeline is loaded, see gst_editor_load() */
+  editor->load_progress = gtk_progress_bar_new ();
+  gtk_widget_set_valign (editor->load_progress, GTK_ALIGN_CENTER);
+  gtk_box_pack_end (GTK_BOX (editor->statusbar), editor->load_progress,
+      FALSE, FALSE, 0);
+  editor->load_cancel = gtk_button_new_with_mnemonic (_("_Cancel"));
+  gtk_box_pack_end (GTK_BOX (editor->statusbar), editor->load_cancel,
+      FALSE, FALSE, 0);
+  g_signal_connect (editor->load_cancel, "clicked",
+      G_CALLBACK (on_load_cancel), editor);
+
+  editor->state_label = gtk_label_new (NULL);
+  gtk_box_pack_end (GTK_BOX (editor->statusbar), editor->state_label,
+      FALSE, FALSE, 0);
+  gtk_widget_show (editor->state_label);
+
   g_signal_connect (editor->window, "delete-event",
       G_CALLBACK (on_delete_event), editor);
 
@@ -275,7 +296,8 @@ gst_editor_init (GstEditor * editor)
   g_signal_connect (editor->property_window, "delete-event",
       G_CALLBACK (on_property_window_delete), editor);
 
-  g_mutex_init (&editor->outputmutex);
+  editor->autosave = gst_editor_autosave_new (on_saved, editor);
+
 }
 
 static void
@@ -335,6 +357,22 @@ gst_editor_dispose (GObject * object)
 {
   GstEditor *editor = GST_EDITOR (object);
 
+  if (editor->layout) {
+    gst_editor_layout_stop (editor->layout);
+    editor->layout = NULL;
+  }
+
+  if (editor->loader) {
+    gst_editor_loader_stop (editor->loader);
+    editor->loader = NULL;
+  }
+
+  if (editor->autosave) {
+    /* waits for pending saves */
+    gst_editor_autosave_free (editor->autosave);
+    editor->autosave = NULL;
+  }
+
   gtk_widget_destroy (editor->property_window);
   gtk_widget_destroy (editor->window);
 
@@ -351,10 +389,6 @@ gst_editor_dispose (GObject * object)
 static void
 gst_editor_finalize (GObject * object)
 {
-  GstEditor *editor = GST_EDITOR (object);
-
-  g_mutex_clear (&editor->outputmutex);
-
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -456,7 +490,8 @@ gst_editor_element_connect (GstEditor * editor, GstElement * pipeline)
 
   bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
   /*
-   * NOTE: The signal watch is cleaned up in gst_editor_load().
+   * NOTE: The signal watch is cleaned up in gst_editor_load()
+   * and restored by gst_editor_load_finish().
    */
   gst_bus_add_signal_watch (bus);
   g_signal_connect (bus, "message",
@@ -493,53 +528,52 @@ gst_editor_new (GstElement * element)
 {
   GtkWidget *ret = g_object_new (gst_editor_get_type (), NULL);
 
-  if (element) {
-    g_object_set (GST_EDITOR (ret)->canvas, "bin", element, NULL);
-    gst_editor_element_connect (GST_EDITOR (ret), element);
-  }
+  if (element)
+    gst_editor_set_pipeline (GST_EDITOR (ret), element);
 
   return ret;
 }
 
-static gboolean
-gst_editor_save (GstEditor * editor)
+/*
+ * Shows element in the editor. Set the canvas properties that affect
+ * how elements are realized (like "compact") before calling this.
+ */
+void
+gst_editor_set_pipeline (GstEditor * editor, GstElement * element)
 {
-  GError *error = NULL;
-  GstEditorItem *pipeline_item = GST_EDITOR_ITEM (editor->canvas->bin);
+  g_return_if_fail (GST_IS_ELEMENT (element));
 
-  if (g_str_has_suffix (editor->filename, ".gep")) {
-    /*
-     * Save as Gst-Editor Pipeline with metadata.
-     */
-    GKeyFile *key_file = g_key_file_new ();
+  gst_editor_canvas_freeze (editor->canvas);
+  g_object_set (editor->canvas, "bin", element, NULL);
+  gst_editor_canvas_thaw (editor->canvas);
+  gst_editor_element_connect (editor, element);
+}
 
-    gst_editor_item_save_with_metadata (pipeline_item, key_file,
-        editor->save_flags);
+/*
+ * Saves the pipeline in the background.
+ * The result is reported by on_saved().
+ */
+static void
+gst_editor_save (GstEditor * editor)
+{
+  gst_editor_autosave_queue (editor->autosave,
+      GST_EDITOR_ITEM (editor->canvas->bin), editor->filename,
+      editor->save_flags, g_str_has_suffix (editor->filename, ".gep"));
+}
 
-    g_key_file_save_to_file (key_file, editor->filename, &error);
-    g_key_file_unref (key_file);
-    if (error) {
-      g_warning ("%s could not be saved: %s", editor->filename, error->message);
-      g_error_free (error);
-      return FALSE;
-    }
-  } else {
-    /*
-     * Save as plain Gst-Launch pipeline.
-     */
-    gchar *pipeline = gst_editor_item_save (pipeline_item, editor->save_flags);
-
-    g_file_set_contents (editor->filename, pipeline, -1, &error);
-    g_free (pipeline);
-    if (error) {
-      g_warning ("%s could not be saved: %s", editor->filename, error->message);
-      g_error_free (error);
-      return FALSE;
-    }
+static void
+on_saved (const gchar * filename, const GError * error, gpointer user_data)
+{
+  GstEditor *editor = GST_EDITOR (user_data);
+
+  if (error) {
+    g_warning ("%s could not be saved: %s", filename, error->message);
+    gst_editor_statusbar_message (editor, "%s could not be saved: %s",
+        filename, error->message);
+    return;
   }
 
-  gst_editor_statusbar_message (editor, "Pipeline saved to %s.", editor->filename);
-  return TRUE;
+  gst_editor_statusbar_message (editor, "Pipeline saved to %s.", filename);
 }
 
 void
@@ -629,34 +663,53 @@ gst_editor_on_save (GtkWidget * widget, GstEditor * editor)
   gst_editor_save (editor);
 }
 
-void
-gst_editor_load (GstEditor * editor, const gchar * file_name)
+/*
+ * Frees the running loader and watches the messages of the canvas'
+ * pipeline again.
+ */
+static void
+gst_editor_load_finish (GstEditor * editor)
 {
-  GError *error = NULL;
-  GKeyFile *key_file = g_key_file_new ();
   GstElement *pipeline;
 
-  if (!g_key_file_load_from_file (key_file, file_name, G_KEY_FILE_NONE, &error)) {
-    g_warning ("Error parsing save file \"%s\": %s", file_name, error->message);
-    g_error_free (error);
-    goto cleanup;
-  }
+  gst_editor_loader_stop (editor->loader);
+  editor->loader = NULL;
+
+  gtk_widget_hide (editor->load_progress);
+  gtk_widget_hide (editor->load_cancel);
 
   pipeline = gst_editor_canvas_get_pipeline (editor->canvas);
   if (pipeline)
-    gst_bus_remove_signal_watch (gst_pipeline_get_bus (GST_PIPELINE (pipeline)));
+    gst_editor_element_connect (editor, pipeline);
+}
 
-  if (!gst_editor_canvas_load_with_metadata (editor->canvas, key_file, &error)) {
-    g_warning ("Error loading key file: %s", error->message);
-    g_error_free (error);
-    goto cleanup;
+static void
+on_load_progress (GstEditorLoader * loader, gdouble fraction,
+    gpointer user_data)
+{
+  GstEditor *editor = GST_EDITOR (user_data);
+
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (editor->load_progress),
+      fraction);
+}
+
+static void
+on_load_finished (GstEditorLoader * loader, const GError * error,
+    gpointer user_data)
+{
+  GstEditor *editor = GST_EDITOR (user_data);
+  const gchar *file_name = gst_editor_loader_get_filename (loader);
+  gdouble width, height;
+
+  if (error) {
+    g_warning ("Error loading \"%s\": %s", file_name, error->message);
+    gst_editor_statusbar_message (editor, "%s could not be loaded: %s",
+        file_name, error->message);
+    gst_editor_load_finish (editor);
+    return;
   }
 
-  /*
-   * Restore save flags.
-   * Errors are handled gracefully by assuming no special settings (0).
-   */
-  editor->save_flags = g_key_file_get_integer (key_file, PACKAGE_NAME, "Flags", NULL);
+  editor->save_flags = gst_editor_loader_get_flags (loader);
 
   /*
    * The canvas "autosize" property was updated.
@@ -667,7 +720,6 @@ gst_editor_load (GstEditor * editor, const gchar * file_name)
           "autosize-checkbutton")), editor->canvas->autosize);
   gtk_widget_set_sensitive (GTK_WIDGET (editor->sw), !editor->canvas->autosize);
   gtk_widget_set_sensitive (GTK_WIDGET (editor->sh), !editor->canvas->autosize);
-  gdouble width, height;
   g_object_get (editor->canvas->bin,
       "width", &width, "height", &height, NULL);
   gtk_spin_button_set_value (editor->sw, width);
@@ -677,11 +729,52 @@ gst_editor_load (GstEditor * editor, const gchar * file_name)
 
   gst_editor_statusbar_message (editor, "Pipeline loaded from %s.", editor->filename);
 
+  /* frees file_name */
+  gst_editor_load_finish (editor);
+}
+
+static void
+on_load_cancel (GtkButton * button, GstEditor * editor)
+{
+  if (!editor->loader)
+    return;
+
+  /* a partially realized pipeline is replaced with an empty one */
+  gst_editor_load_finish (editor);
+  gst_editor_statusbar_message (editor, "Loading cancelled.");
+}
+
+/*
+ * Loads file_name in the background.
+ * The editor stays responsive while the pipeline is parsed and
+ * its canvas items are created. The progress is displayed in the
+ * status bar, which also allows cancelling the load.
+ */
+void
+gst_editor_load (GstEditor * editor, const gchar * file_name)
+{
+  GstElement *pipeline;
+  GstBus *bus;
+
+  if (editor->loader)
+    gst_editor_load_finish (editor);
+
   pipeline = gst_editor_canvas_get_pipeline (editor->canvas);
-  gst_editor_element_connect (editor, pipeline);
+  if (pipeline) {
+    bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+    gst_bus_remove_signal_watch (bus);
+    g_signal_handlers_disconnect_by_func (bus,
+        gst_editor_pipeline_message, editor);
+    gst_object_unref (bus);
+  }
+
+  editor->loader = gst_editor_loader_start (editor->canvas, file_name,
+      on_load_progress, on_load_finished, editor);
 
-cleanup:
-  g_key_file_unref (key_file);
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (editor->load_progress), 0.);
+  gtk_widget_show (editor->load_progress);
+  gtk_widget_show (editor->load_cancel);
+  gst_editor_statusbar_message (editor, "Loading %s...", file_name);
 }
 
 void
@@ -922,6 +1015,26 @@ gst_editor_show_utility_palette (GtkWidget * widget, GstEditor * editor)
   g_object_set (editor->canvas, "palette-visible", b, NULL);
 }
 
+void
+gst_editor_on_zoom_in (GtkWidget * widget, GstEditor * editor)
+{
+  gst_editor_canvas_set_zoom (editor->canvas,
+      goo_canvas_get_scale (GOO_CANVAS (editor->canvas)) * 1.5);
+}
+
+void
+gst_editor_on_zoom_out (GtkWidget * widget, GstEditor * editor)
+{
+  gst_editor_canvas_set_zoom (editor->canvas,
+      goo_canvas_get_scale (GOO_CANVAS (editor->canvas)) / 1.5);
+}
+
+void
+gst_editor_on_zoom_normal (GtkWidget * widget, GstEditor * editor)
+{
+  gst_editor_canvas_set_zoom (editor->canvas, 1.0);
+}
+
 void
 gst_editor_on_help_contents (GtkWidget * widget, GstEditor * editor)
 {
@@ -973,78 +1086,33 @@ gst_editor_on_about (GtkWidget * widget, GstEditor * editor)
       NULL);
 }
 
-#if 0
-static gboolean
-sort (GstEditor * editor)
+static void
+on_layout_finished (GstEditorLayout * layout, gpointer user_data)
 {
-  gst_editor_statusbar_message (editor, "Change in bin pressure: %f",
-      gst_editor_bin_sort (editor->canvas->bin, 0.1));
-  return TRUE;
-}
-#endif
+  GstEditor *editor = GST_EDITOR (user_data);
 
-//callback that generates an output message to stderr
-static GstPadProbeReturn
-cb_output (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
-{
-  GstBuffer * buffer = GST_PAD_PROBE_INFO_BUFFER (info);
-  GstEditor * editor = GST_EDITOR (user_data);
-  guint64 time;
-  //fprintf(stderr,"Buffer:)");
-  struct timeval now;
-
-  gettimeofday (&now, NULL);
-  time = ((now.tv_sec*1000000000ULL)+(now.tv_usec*1000ULL));
-
-  g_mutex_lock (&editor->outputmutex);
-  if (GST_STATE (GST_OBJECT (pad)->parent) == GST_STATE_PLAYING) {
-    fprintf (stderr, "%s %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " "
-                     "%" G_GSIZE_FORMAT " "
-                     "%" G_GUINT64_FORMAT " %ld %d %lu %s\n",
-        GST_OBJECT (pad)->parent->name, GST_BUFFER_PTS (buffer), time,
-        gst_buffer_get_size (buffer), GST_BUFFER_OFFSET (buffer), clock (),
-        getpid (), pthread_self (), GST_OBJECT (pad->peer)->parent->name);
-    // Element Name, timestamp, timenow, jiffies now,Prozessnr, threadnr,Peer
-    // Element Name
-  }
-  g_mutex_unlock (&editor->outputmutex);
+  gst_editor_layout_stop (editor->layout);
+  editor->layout = NULL;
 
-  return GST_PAD_PROBE_OK;
+  /* this will not restart the layout since it is already stopped */
+  gtk_toggle_tool_button_set_active (GTK_TOGGLE_TOOL_BUTTON (
+      gtk_builder_get_object (editor->builder, "togglebutton1")), FALSE);
+  gst_editor_statusbar_message (editor, "Finished sorting.");
 }
 
-
 void
-gst_editor_on_sort_toggled (GtkToggleButton * toggle, GstEditor * editor)
+gst_editor_on_sort_toggled (GtkToggleToolButton * toggle, GstEditor * editor)
 {
-  GList *elements, *srcpads;
-    
-    //gst_editor_statusbar_message (editor, "Doing debug output...");
-    //gst_editor_bin_debug_output(editor->canvas->selection);
-
-  gst_editor_statusbar_message (editor, "Doing debug output...");
-  GstBin *top = GST_BIN (GST_EDITOR_ITEM(editor->canvas->bin)->object);
-  elements = g_list_last (GST_BIN_CHILDREN (top));
-  g_print("Getting Gstreamer Children, Total %d\n",
-      g_list_length (GST_BIN_CHILDREN (top)));
-
-  while (elements) {
-    if (GST_IS_ELEMENT (elements->data)) {
-      g_print ("Found Gstreamer Element:%s\n",
-          GST_OBJECT_NAME (elements->data));
-      for (srcpads = g_list_last (GST_ELEMENT (elements->data)->srcpads);
-           srcpads != NULL;
-           srcpads = g_list_previous (srcpads)) {
-        /*
-         * FIXME: This leaks buffer probes.
-         * Use gst_pad_remove_probe().
-         */
-        gst_pad_add_probe (GST_PAD (srcpads->data),
-            GST_PAD_PROBE_TYPE_BUFFER, cb_output, editor, NULL);
-      }
-    } else {
-      g_print ("unknown child type \n");
-    }
-    elements = g_list_previous (elements);
+  gboolean active = gtk_toggle_tool_button_get_active (toggle);
+
+  if (active && !editor->layout && editor->canvas->bin) {
+    gst_editor_statusbar_message (editor, "Sorting bin...");
+    editor->layout = gst_editor_layout_start (editor->canvas->bin,
+        on_layout_finished, editor);
+  } else if (!active && editor->layout) {
+    gst_editor_layout_stop (editor->layout);
+    editor->layout = NULL;
+    gst_editor_statusbar_message (editor, "Stopped sorting.");
   }
 }
 
@@ -1104,20 +1172,6 @@ on_canvas_size_allocate (GtkWidget * widget,
   gst_editor_on_spinbutton (editor->sh, editor);
 }
 
-/*  gboolean active;
-
-  active = gtk_toggle_button_get_active (toggle);
-
-  if (active) {
-    gst_editor_statusbar_message (editor, "Sorting bin...");
-
-    g_timeout_add (200, (GSourceFunc) sort, editor);
-  } else {
-    gst_editor_statusbar_message (editor, "Finished sorting.");
-    g_source_remove_by_user_data (editor);
-  }*/
-
-
 static gint
 on_delete_event (GtkWidget * widget, GdkEvent * event, GstEditor * editor)
 {
@@ -1142,6 +1196,10 @@ on_canvas_notify (GObject * object, GParamSpec * param, GstEditor * editor)
     g_object_get (object, "status", &status, NULL);
     gst_editor_statusbar_message (editor, "%s", status);
     g_free (status);
+  } else if (g_ascii_strcasecmp (param->name, "state-summary") == 0) {
+    g_object_get (object, "state-summary", &status, NULL);
+    gtk_label_set_text (GTK_LABEL (editor->state_label), status);
+    g_free (status);
   }
 }
 
@@ -52,7 +52,18 @@ typedef struct _GstEditor
 
   GstEditorCanvas *canvas;
 
-  GMutex outputmutex;//only used for time measurement outputs
+  /* running auto-layout (see gsteditorlayout.h) */
+  struct _GstEditorLayout *layout;
+
+  /* background saving (see gsteditorautosave.h) */
+  struct _GstEditorAutosave *autosave;
+
+  /* loading in progress (see gsteditorloader.h) */
+  struct _GstEditorLoader *loader;
+  GtkWidget *load_progress, *load_cancel;
+
+  /* the canvas' "state-summary" */
+  GtkWidget *state_label;
 } GstEditor;
 
 typedef struct _GstEditorClass
@@ -62,6 +73,7 @@ typedef struct _GstEditorClass
 
 GType gst_editor_get_type (void);
 GtkWidget *gst_editor_new (GstElement * element);
+void gst_editor_set_pipeline (GstEditor * editor, GstElement * element);
 void gst_editor_load (GstEditor * editor, const gchar * file_name);
 
 #endif /* __GST_EDITOR_H__ */
@@ -0,0 +1,765 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Saving pipelines in the background.
+ *
+ * Saving must not stall the main loop, however large the pipeline is.
+ * So the main thread only takes an immutable snapshot: the pipeline
+ * description (cheap to build from the fragments cached by
+ * GSTE_SERIALIZE_CACHE), the names of the serialized elements and
+ * the layout of the elements that have been moved, resized or renamed
+ * since the last snapshot (see gst_editor_canvas_mark_dirty()).
+ * The worker keeps the layout of all other elements and streams the
+ * snapshot into a temporary file, which is synced and renamed over
+ * the target.
+ * Snapshots queued for the same file before the worker gets to
+ * them are coalesced.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+
+#ifdef G_OS_WIN32
+#include <io.h>
+#define fsync _commit
+#else
+#include <unistd.h>
+#endif
+
+#include <gst/common/gste-serialize.h>
+#include <gst/common/gste-metadata.h>
+
+#include "gsteditoritem.h"
+#include "gsteditorelement.h"
+#include "gsteditorcanvas.h"
+#include "gsteditorautosave.h"
+
+GST_DEBUG_CATEGORY_STATIC (gste_autosave_debug);
+#define GST_CAT_DEFAULT gste_autosave_debug
+
+/* immutable once queued */
+typedef struct _AutosaveSnapshot
+{
+  gchar *filename;
+  gboolean metadata;
+  GsteSerializeFlags flags;
+  gboolean autosize;
+
+  /* the pipeline description */
+  GString *description;
+  /* names of the serialized elements, in order (only with metadata) */
+  GPtrArray *names;
+} AutosaveSnapshot;
+
+typedef struct _AutosaveResult
+{
+  gchar *filename;
+  GError *error;
+} AutosaveResult;
+
+/* state of building a snapshot (main thread) */
+typedef struct _AutosaveBuilder
+{
+  AutosaveSnapshot *snapshot;
+  GHashTable *seen;
+} AutosaveBuilder;
+
+struct _GstEditorAutosave
+{
+  GThread *thread;
+
+  GMutex lock;
+  GCond cond;
+  gboolean quit;
+  /* file name -> AutosaveSnapshot */
+  GHashTable *pending;
+  /* element name -> GsteLayoutBox, recorded since the last batch */
+  GHashTable *records;
+
+  /* worker only: element name -> GsteLayoutBox of all known elements */
+  GHashTable *layout;
+
+  /* AutosaveResult to be dispatched in the main thread */
+  GQueue results;
+  guint dispatch_id;
+
+  GstEditorAutosaveCallback saved_cb;
+  gpointer user_data;
+};
+
+static void
+autosave_snapshot_free (AutosaveSnapshot * snapshot)
+{
+  g_free (snapshot->filename);
+  g_string_free (snapshot->description, TRUE);
+  if (snapshot->names)
+    g_ptr_array_unref (snapshot->names);
+  g_free (snapshot);
+}
+
+static void
+autosave_result_free (AutosaveResult * result)
+{
+  g_free (result->filename);
+  g_clear_error (&result->error);
+  g_free (result);
+}
+
+static GHashTable *
+autosave_pending_new (void)
+{
+  return g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+      (GDestroyNotify) autosave_snapshot_free);
+}
+
+static GHashTable *
+autosave_layout_new (void)
+{
+  return g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+}
+
+/* moves the boxes of records into layout, and frees records */
+static void
+autosave_layout_merge (GHashTable * layout, GHashTable * records)
+{
+  GHashTableIter iter;
+  gpointer name, box;
+
+  g_hash_table_iter_init (&iter, records);
+  while (g_hash_table_iter_next (&iter, &name, &box)) {
+    g_hash_table_iter_steal (&iter);
+    g_hash_table_replace (layout, name, box);
+  }
+  g_hash_table_unref (records);
+}
+
+/**********************************************************************
+ * Snapshots (main thread)
+ **********************************************************************/
+
+static void
+autosave_append_cb (const gchar * str, gpointer user_data)
+{
+  AutosaveBuilder *builder = user_data;
+
+  g_string_append (builder->snapshot->description, str);
+}
+
+/* see serialize_object_saved_cb() in gsteditoritem.c */
+static void
+autosave_object_saved_cb (GstObject * object, gpointer user_data)
+{
+  AutosaveBuilder *builder = user_data;
+  gchar *name;
+
+  if (!GST_IS_ELEMENT (object))
+    return;
+
+  name = g_strdup (GST_OBJECT_NAME (object));
+  if (!name || g_hash_table_contains (builder->seen, name)) {
+    g_free (name);
+    return;
+  }
+
+  g_hash_table_add (builder->seen, name);
+  g_ptr_array_add (builder->snapshot->names, name);
+}
+
+static AutosaveSnapshot *
+autosave_snapshot_new (GstEditorItem * item, const gchar * filename,
+    GsteSerializeFlags flags, gboolean metadata)
+{
+  AutosaveSnapshot *snapshot = g_new0 (AutosaveSnapshot, 1);
+  AutosaveBuilder builder = { snapshot, NULL };
+
+  snapshot->filename = g_strdup (filename);
+  snapshot->metadata = metadata;
+  snapshot->description = g_string_new (NULL);
+
+  if (metadata) {
+    GstEditorCanvas *canvas =
+        GST_EDITOR_CANVAS (goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (item)));
+
+    /* see gst_editor_item_save_with_metadata() */
+    flags |= GSTE_SERIALIZE_PIPELINES_AS_BINS |
+        GSTE_SERIALIZE_CAPSFILTER_AS_ELEMENT;
+    snapshot->autosize = canvas->autosize;
+
+    /* the names are owned by snapshot->names */
+    snapshot->names = g_ptr_array_new_with_free_func (g_free);
+    builder.seen = g_hash_table_new (g_str_hash, g_str_equal);
+  }
+  /* must not be saved */
+  snapshot->flags = flags & ~GSTE_SERIALIZE_CACHE;
+
+  gste_serialize_save (item->object, snapshot->flags | GSTE_SERIALIZE_CACHE,
+      autosave_append_cb, metadata ? autosave_object_saved_cb : NULL,
+      &builder);
+
+  if (builder.seen)
+    g_hash_table_unref (builder.seen);
+
+  return snapshot;
+}
+
+/*
+ * Records the layout of the elements on the canvas of item that
+ * have changed since the last snapshot.
+ */
+static GHashTable *
+autosave_take_records (GstEditorItem * item)
+{
+  GooCanvas *canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (item));
+  GHashTable *records = autosave_layout_new ();
+  GHashTable *dirty;
+  GHashTableIter iter;
+  gpointer key;
+
+  if (!GST_IS_EDITOR_CANVAS (canvas))
+    return records;
+
+  dirty = gst_editor_canvas_steal_dirty (GST_EDITOR_CANVAS (canvas));
+
+  g_hash_table_iter_init (&iter, dirty);
+  while (g_hash_table_iter_next (&iter, &key, NULL)) {
+    GstEditorItem *element = GST_EDITOR_ITEM (key);
+    GsteLayoutBox *box;
+    cairo_matrix_t matrix;
+
+    element->dirty = FALSE;
+
+    /* removed in the meantime */
+    if (!element->object ||
+        !goo_canvas_item_get_parent (GOO_CANVAS_ITEM (element)))
+      continue;
+
+    cairo_matrix_init_identity (&matrix);
+    goo_canvas_item_get_transform (GOO_CANVAS_ITEM (element), &matrix);
+
+    box = g_new (GsteLayoutBox, 1);
+    box->x = matrix.x0;
+    box->y = matrix.y0;
+    box->width = element->width;
+    box->height = element->height;
+    g_hash_table_replace (records,
+        g_strdup (GST_OBJECT_NAME (element->object)), box);
+  }
+
+  g_hash_table_unref (dirty);
+
+  return records;
+}
+
+/**********************************************************************
+ * Worker thread
+ **********************************************************************/
+
+static void
+autosave_set_error (GError ** error, const gchar * filename,
+    const gchar * format)
+{
+  gint saved_errno = errno;
+  gchar *display_name = g_filename_display_name (filename);
+
+  g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+      format, display_name, g_strerror (saved_errno));
+  g_free (display_name);
+}
+
+/*
+ * Files are written atomically: the data is written and synced to
+ * a temporary file which then replaces the file.
+ * The directory is not synced (see autosave_sync_dir()).
+ */
+static gint
+autosave_tmp_open (const gchar * filename, gchar ** tmp_name, GError ** error)
+{
+  gint fd;
+
+  *tmp_name = g_strdup_printf ("%s.XXXXXX", filename);
+
+  fd = g_mkstemp_full (*tmp_name, O_RDWR, 0666);
+  if (fd < 0) {
+    autosave_set_error (error, *tmp_name, "Failed to create file '%s': %s");
+    g_free (*tmp_name);
+    *tmp_name = NULL;
+  }
+
+  return fd;
+}
+
+static void
+autosave_tmp_abort (gint fd, gchar * tmp_name)
+{
+  if (fd >= 0)
+    close (fd);
+  g_unlink (tmp_name);
+  g_free (tmp_name);
+}
+
+/* frees tmp_name */
+static gboolean
+autosave_tmp_commit (gint fd, gchar * tmp_name, const gchar * filename,
+    GError ** error)
+{
+  if (fsync (fd) != 0) {
+    autosave_set_error (error, tmp_name, "Failed to sync file '%s': %s");
+    autosave_tmp_abort (fd, tmp_name);
+    return FALSE;
+  }
+
+  if (close (fd) != 0) {
+    autosave_set_error (error, tmp_name, "Failed to close file '%s': %s");
+    autosave_tmp_abort (-1, tmp_name);
+    return FALSE;
+  }
+
+#ifdef G_OS_WIN32
+  /* rename() does not replace existing files on Windows */
+  g_unlink (filename);
+#endif
+  if (g_rename (tmp_name, filename) != 0) {
+    autosave_set_error (error, filename, "Failed to rename file to '%s': %s");
+    autosave_tmp_abort (-1, tmp_name);
+    return FALSE;
+  }
+
+  g_free (tmp_name);
+  return TRUE;
+}
+
+static gboolean
+autosave_write_file (const gchar * filename, GBytes * bytes, GError ** error)
+{
+  GsteSerializeSink *sink;
+  gchar *tmp_name;
+  gsize length;
+  const gchar *data = g_bytes_get_data (bytes, &length);
+  gint fd = autosave_tmp_open (filename, &tmp_name, error);
+
+  if (fd < 0)
+    return FALSE;
+
+  sink = gste_serialize_sink_new_for_fd (fd);
+  gste_serialize_sink_write (sink, data, length);
+  if (!gste_serialize_sink_free (sink, error)) {
+    autosave_tmp_abort (fd, tmp_name);
+    return FALSE;
+  }
+
+  return autosave_tmp_commit (fd, tmp_name, filename, error);
+}
+
+/* writes a key file value, escaped like g_key_file_set_string() does */
+static void
+autosave_write_escaped (GsteSerializeSink * sink, const gchar * str)
+{
+  const gchar *p, *run = str;
+  gboolean leading = TRUE;
+
+  for (p = str; *p; p++) {
+    const gchar *escape = NULL;
+
+    if (*p != ' ' && *p != '\t')
+      leading = FALSE;
+
+    switch (*p) {
+      case ' ':
+        if (leading)
+          escape = "\\s";
+        break;
+      case '\t':
+        if (leading)
+          escape = "\\t";
+        break;
+      case '\n':
+        escape = "\\n";
+        break;
+      case '\r':
+        escape = "\\r";
+        break;
+      case '\\':
+        escape = "\\\\";
+        break;
+      default:
+        break;
+    }
+    if (!escape)
+      continue;
+
+    gste_serialize_sink_write (sink, run, p - run);
+    gste_serialize_sink_write (sink, escape, 2);
+    run = p + 1;
+  }
+
+  gste_serialize_sink_write (sink, run, p - run);
+}
+
+static gboolean
+autosave_layout_is_gone (gpointer key, gpointer value, gpointer user_data)
+{
+  GHashTable *seen = user_data;
+
+  return !g_hash_table_contains (seen, key);
+}
+
+/*
+ * Must produce the format of gst_editor_item_save_with_metadata().
+ * The metadata of large pipelines is written to a sidecar instead
+ * (see gste-metadata.h), *sidecar tells whether it was.
+ */
+static gboolean
+autosave_write_gep (GstEditorAutosave * autosave,
+    AutosaveSnapshot * snapshot, GsteSerializeSink * sink,
+    gboolean * sidecar, GError ** error)
+{
+  GPtrArray *names = snapshot->names;
+  GHashTable *seen;
+  gboolean ret = TRUE;
+  guint n_records = 0;
+  gchar *header;
+
+  header = g_strdup_printf ("[%s]\nVersion=%s\nFlags=%d\nAutosize=%s\n"
+      "Pipeline=", PACKAGE_NAME, PACKAGE_VERSION, snapshot->flags,
+      snapshot->autosize ? "true" : "false");
+  gste_serialize_sink_write (sink, header, -1);
+  g_free (header);
+
+  autosave_write_escaped (sink, snapshot->description->str);
+  gste_serialize_sink_write (sink, "\n", 1);
+
+  /* forget elements that have been removed or renamed */
+  seen = g_hash_table_new (g_str_hash, g_str_equal);
+  for (guint i = 0; i < names->len; i++)
+    g_hash_table_add (seen, g_ptr_array_index (names, i));
+  g_hash_table_foreach_remove (autosave->layout, autosave_layout_is_gone,
+      seen);
+  g_hash_table_unref (seen);
+
+  for (guint i = 0; i < names->len; i++)
+    if (g_hash_table_contains (autosave->layout,
+            g_ptr_array_index (names, i)))
+      n_records++;
+
+  *sidecar = n_records >= GSTE_METADATA_MIN_RECORDS;
+
+  if (*sidecar) {
+    GsteMetadataBuilder *builder = gste_metadata_builder_new ();
+    gchar *sidecar_name = gste_metadata_sidecar_name (snapshot->filename);
+    gchar *basename = g_path_get_basename (sidecar_name);
+    GBytes *bytes;
+
+    for (guint i = 0; i < names->len; i++) {
+      const gchar *name = g_ptr_array_index (names, i);
+      GsteLayoutBox *box = g_hash_table_lookup (autosave->layout, name);
+
+      if (box)
+        gste_metadata_builder_add (builder, name, box);
+    }
+    bytes = gste_metadata_builder_end (builder,
+        gste_metadata_stamp (snapshot->description->str));
+
+    /*
+     * The sidecar replaces the old one before the pipeline file is
+     * renamed, so the pipeline file never refers to a missing sidecar.
+     * An outdated sidecar is detected by its stamp.
+     */
+    ret = autosave_write_file (sidecar_name, bytes, error);
+    g_bytes_unref (bytes);
+
+    /* relative to the pipeline file */
+    gste_serialize_sink_write (sink, "Layout=", -1);
+    autosave_write_escaped (sink, basename);
+    gste_serialize_sink_write (sink, "\n", 1);
+
+    g_free (basename);
+    g_free (sidecar_name);
+  } else {
+    GKeyFile *key_file = g_key_file_new ();
+    gchar *data;
+    gsize length;
+
+    for (guint i = 0; i < names->len; i++) {
+      const gchar *name = g_ptr_array_index (names, i);
+      GsteLayoutBox *box = g_hash_table_lookup (autosave->layout, name);
+      gchar *group_name;
+
+      if (!box)
+        continue;
+
+      group_name = g_strconcat ("Element:", name, NULL);
+      g_key_file_set_double (key_file, group_name, "X", box->x);
+      g_key_file_set_double (key_file, group_name, "Y", box->y);
+      g_key_file_set_double (key_file, group_name, "Width", box->width);
+      g_key_file_set_double (key_file, group_name, "Height", box->height);
+      g_free (group_name);
+    }
+
+    data = g_key_file_to_data (key_file, &length, NULL);
+    gste_serialize_sink_write (sink, "\n", 1);
+    gste_serialize_sink_write (sink, data, length);
+    g_free (data);
+    g_key_file_unref (key_file);
+  }
+
+  GST_DEBUG ("%s: %u elements, %u with layout", snapshot->filename,
+      names->len, n_records);
+
+  return ret;
+}
+
+static gboolean
+autosave_write_snapshot (GstEditorAutosave * autosave,
+    AutosaveSnapshot * snapshot, GError ** error)
+{
+  GsteSerializeSink *sink;
+  gboolean ret = TRUE, sidecar = FALSE;
+  gchar *tmp_name;
+  gint fd;
+
+  fd = autosave_tmp_open (snapshot->filename, &tmp_name, error);
+  if (fd < 0)
+    return FALSE;
+
+  sink = gste_serialize_sink_new_for_fd (fd);
+  if (snapshot->metadata)
+    ret = autosave_write_gep (autosave, snapshot, sink, &sidecar, error);
+  else
+    gste_serialize_sink_write (sink, snapshot->description->str,
+        snapshot->description->len);
+
+  /* reports write errors, unless there has been an error already */
+  if (!gste_serialize_sink_free (sink, ret ? error : NULL) || !ret) {
+    autosave_tmp_abort (fd, tmp_name);
+    return FALSE;
+  }
+
+  if (!autosave_tmp_commit (fd, tmp_name, snapshot->filename, error))
+    return FALSE;
+
+  /* the metadata is in the pipeline file again */
+  if (snapshot->metadata && !sidecar) {
+    gchar *sidecar_name = gste_metadata_sidecar_name (snapshot->filename);
+
+    g_unlink (sidecar_name);
+    g_free (sidecar_name);
+  }
+
+  return TRUE;
+}
+
+/* makes the renames of a batch durable */
+static void
+autosave_sync_dir (const gchar * dirname)
+{
+#ifndef G_OS_WIN32
+  gint fd = g_open (dirname, O_RDONLY, 0);
+
+  if (fd < 0)
+    return;
+  fsync (fd);
+  close (fd);
+#endif
+}
+
+static gboolean
+autosave_dispatch_cb (gpointer user_data)
+{
+  GstEditorAutosave *autosave = user_data;
+  GQueue results;
+  AutosaveResult *result;
+
+  g_mutex_lock (&autosave->lock);
+  results = autosave->results;
+  g_queue_init (&autosave->results);
+  autosave->dispatch_id = 0;
+  g_mutex_unlock (&autosave->lock);
+
+  while ((result = g_queue_pop_head (&results))) {
+    if (autosave->saved_cb)
+      autosave->saved_cb (result->filename, result->error,
+          autosave->user_data);
+    autosave_result_free (result);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+autosave_write_batch (GstEditorAutosave * autosave, GHashTable * batch)
+{
+  GHashTable *dirs = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, NULL);
+  GQueue results = G_QUEUE_INIT;
+  GHashTableIter iter;
+  AutosaveSnapshot *snapshot;
+  gchar *dirname;
+
+  g_hash_table_iter_init (&iter, batch);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & snapshot)) {
+    AutosaveResult *result = g_new0 (AutosaveResult, 1);
+
+    result->filename = g_strdup (snapshot->filename);
+
+    if (autosave_write_snapshot (autosave, snapshot, &result->error))
+      g_hash_table_add (dirs, g_path_get_dirname (snapshot->filename));
+
+    GST_DEBUG ("wrote %s: %s", snapshot->filename,
+        result->error ? result->error->message : "OK");
+    g_queue_push_tail (&results, result);
+  }
+
+  g_hash_table_iter_init (&iter, dirs);
+  while (g_hash_table_iter_next (&iter, (gpointer *) & dirname, NULL))
+    autosave_sync_dir (dirname);
+  g_hash_table_unref (dirs);
+
+  g_mutex_lock (&autosave->lock);
+  while (!g_queue_is_empty (&results))
+    g_queue_push_tail (&autosave->results, g_queue_pop_head (&results));
+  if (!autosave->dispatch_id)
+    autosave->dispatch_id = g_idle_add (autosave_dispatch_cb, autosave);
+  g_mutex_unlock (&autosave->lock);
+}
+
+static gpointer
+autosave_thread_func (gpointer user_data)
+{
+  GstEditorAutosave *autosave = user_data;
+
+  g_mutex_lock (&autosave->lock);
+
+  for (;;) {
+    GHashTable *batch, *records;
+
+    while (!g_hash_table_size (autosave->pending) && !autosave->quit)
+      g_cond_wait (&autosave->cond, &autosave->lock);
+    if (!g_hash_table_size (autosave->pending))
+      break;
+
+    batch = autosave->pending;
+    autosave->pending = autosave_pending_new ();
+    records = autosave->records;
+    autosave->records = autosave_layout_new ();
+    g_mutex_unlock (&autosave->lock);
+
+    autosave_layout_merge (autosave->layout, records);
+
+    autosave_write_batch (autosave, batch);
+    g_hash_table_unref (batch);
+
+    g_mutex_lock (&autosave->lock);
+  }
+
+  g_mutex_unlock (&autosave->lock);
+
+  return NULL;
+}
+
+/**********************************************************************
+ * Public functions
+ **********************************************************************/
+
+GstEditorAutosave *
+gst_editor_autosave_new (GstEditorAutosaveCallback saved, gpointer user_data)
+{
+  GstEditorAutosave *autosave = g_new0 (GstEditorAutosave, 1);
+
+  if (G_UNLIKELY (!gste_autosave_debug))
+    GST_DEBUG_CATEGORY_INIT (gste_autosave_debug, "GSTE_AUTOSAVE", 0,
+        "GStreamer Editor Autosave");
+
+  g_mutex_init (&autosave->lock);
+  g_cond_init (&autosave->cond);
+  autosave->pending = autosave_pending_new ();
+  autosave->records = autosave_layout_new ();
+  autosave->layout = autosave_layout_new ();
+  g_queue_init (&autosave->results);
+  autosave->saved_cb = saved;
+  autosave->user_data = user_data;
+
+  autosave->thread = g_thread_new ("gste-autosave", autosave_thread_func,
+      autosave);
+
+  return autosave;
+}
+
+/*
+ * Writes all pending snapshots and frees the autosave.
+ * The callback is not invoked anymore.
+ */
+void
+gst_editor_autosave_free (GstEditorAutosave * autosave)
+{
+  g_mutex_lock (&autosave->lock);
+  autosave->quit = TRUE;
+  g_cond_signal (&autosave->cond);
+  g_mutex_unlock (&autosave->lock);
+
+  g_thread_join (autosave->thread);
+
+  if (autosave->dispatch_id)
+    g_source_remove (autosave->dispatch_id);
+  g_queue_foreach (&autosave->results, (GFunc) autosave_result_free, NULL);
+  g_queue_clear (&autosave->results);
+  g_hash_table_unref (autosave->pending);
+  g_hash_table_unref (autosave->records);
+  g_hash_table_unref (autosave->layout);
+
+  g_mutex_clear (&autosave->lock);
+  g_cond_clear (&autosave->cond);
+
+  g_free (autosave);
+}
+
+/*
+ * Takes a snapshot of item (the canvas' top-level bin) and
+ * writes it to filename in the background.
+ * If metadata is set, the snapshot is saved as a Gst-Editor pipeline
+ * (see gst_editor_item_save_with_metadata()), otherwise as a
+ * plain Gst-Launch pipeline.
+ * Must be called from the main thread.
+ */
+void
+gst_editor_autosave_queue (GstEditorAutosave * autosave, GstEditorItem * item,
+    const gchar * filename, GsteSerializeFlags flags, gboolean metadata)
+{
+  AutosaveSnapshot *snapshot;
+  GHashTable *records;
+
+  g_return_if_fail (GST_IS_EDITOR_ITEM (item));
+
+  snapshot = autosave_snapshot_new (item, filename, flags, metadata);
+  records = autosave_take_records (item);
+  GST_DEBUG ("%s: %u elements changed", filename, g_hash_table_size (records));
+
+  g_mutex_lock (&autosave->lock);
+  /* replaces (frees) any older snapshot for the same file */
+  g_hash_table_replace (autosave->pending, snapshot->filename, snapshot);
+  /* the records of replaced snapshots are kept */
+  autosave_layout_merge (autosave->records, records);
+  g_cond_signal (&autosave->cond);
+  g_mutex_unlock (&autosave->lock);
+}
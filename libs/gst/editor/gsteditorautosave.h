@@ -0,0 +1,48 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef __GST_EDITOR_AUTOSAVE_H__
+#define __GST_EDITOR_AUTOSAVE_H__
+
+#include <glib.h>
+
+#include <gst/common/gste-serialize.h>
+
+#include "gsteditoritem.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GstEditorAutosave GstEditorAutosave;
+
+/*
+ * Invoked in the main thread once filename has been written
+ * (error is NULL) or could not be written.
+ */
+typedef void (*GstEditorAutosaveCallback) (const gchar * filename,
+    const GError * error, gpointer user_data);
+
+GstEditorAutosave *gst_editor_autosave_new (GstEditorAutosaveCallback saved,
+    gpointer user_data);
+void gst_editor_autosave_free (GstEditorAutosave * autosave);
+
+void gst_editor_autosave_queue (GstEditorAutosave * autosave,
+    GstEditorItem * item, const gchar * filename, GsteSerializeFlags flags,
+    gboolean metadata);
+
+G_END_DECLS
+
+#endif /* __GST_EDITOR_AUTOSAVE_H__ */
@@ -32,10 +32,13 @@
 
 #include "gst-helper.h"
 #include "gsteditorlink.h"
+#include "gsteditorlinklayer.h"
 #include "gsteditorcanvas.h"
 #include "gsteditorelement.h"
 #include "gsteditoritem.h"
 #include "gsteditorbin.h"
+#include "gsteditorlayout.h"
+#include "gsteditordispatch.h"
 
 GST_DEBUG_CATEGORY (gste_bin_debug);
 #define GST_CAT_DEFAULT gste_bin_debug
@@ -50,6 +53,7 @@ static gboolean gst_editor_bin_button_press_event (GooCanvasItem * citem,
 static void gst_editor_bin_base_init (GstEditorBinClass * klass);
 static void gst_editor_bin_class_init (GstEditorBinClass * klass);
 static void gst_editor_bin_init (GstEditorBin * bin);
+static void gst_editor_bin_finalize (GObject * object);
 static void gst_editor_bin_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_editor_bin_get_property (GObject * object, guint prop_id,
@@ -62,14 +66,29 @@ static void gst_editor_bin_object_changed (GstEditorItem * bin,
 
 static void gst_editor_bin_element_added (GstObject * bin, GstObject * child,
     GstEditorBin * editorbin);
+static void gst_editor_bin_add_children (GstEditorBin * editorbin,
+    GstBin * bin);
 
 /* callback on the gstbin */
 static void gst_editor_bin_element_added_cb (GstBin * bin, GstElement * child,
     gpointer user_data);
 static void gst_editor_bin_element_removed_cb (GstBin * bin, GstElement * child,
     gpointer user_data);
+static void gst_editor_bin_child_added (GstEditorBin * editorbin,
+    GstObject * bin, GstObject * child);
+static void gst_editor_bin_child_removed (GstEditorBin * editorbin,
+    GstObject * bin, GstObject * child);
 
 static gboolean gst_editor_bin_child_as_bin (GstEditorBin * editorbin, GstObject * child);
+static gboolean gst_editor_bin_is_frozen (GstEditorBin * bin);
+
+/* layout state */
+static void gst_editor_bin_sort_add (GstEditorBin * bin,
+    GstEditorElement * child);
+static void gst_editor_bin_sort_remove (GstEditorBin * bin,
+    GstEditorElement * child);
+static void gst_editor_bin_sort_clear (GstEditorBin * bin);
+static void gst_editor_bin_sort_unsettle (GstEditorBin * bin);
 
 /* popup callbacks */
 static void on_add_element (GSimpleAction * action,
@@ -168,6 +187,7 @@ gst_editor_bin_class_init (GstEditorBinClass * klass)
 
   object_class->set_property = gst_editor_bin_set_property;
   object_class->get_property = gst_editor_bin_get_property;
+  object_class->finalize = gst_editor_bin_finalize;
 
   g_object_class_install_property (object_class, ARG_ATTRIBUTES,
       g_param_spec_pointer ("attributes", "attributes", "attributes",
@@ -201,9 +221,33 @@ gst_editor_bin_init (GstEditorBin * bin)
   bin->element_x = -1;
   bin->element_y = -1;
 
+  bin->links = g_hash_table_new (NULL, NULL);
+
+  gst_editor_layout_heat (&bin->sort);
+
   g_object_set (bin, "resizeable", TRUE, NULL);
 }
 
+static void
+gst_editor_bin_finalize (GObject * object)
+{
+  GstEditorBin *bin = GST_EDITOR_BIN (object);
+
+  g_hash_table_unref (bin->links);
+  if (bin->attributes)
+    g_hash_table_unref (bin->attributes);
+
+  g_free (bin->sort.elements);
+  g_free (bin->sort.x);
+  g_free (bin->sort.y);
+  g_free (bin->sort.w);
+  g_free (bin->sort.h);
+  g_free (bin->sort.fx);
+  g_free (bin->sort.fy);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 #if 0
 static void
 canvas_item_interface_init (GooCanvasItemIface * iface)
@@ -220,7 +264,11 @@ gst_editor_bin_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case ARG_ATTRIBUTES:
+      if (bin->attributes)
+        g_hash_table_unref (bin->attributes);
       bin->attributes = g_value_get_pointer (value);
+      if (bin->attributes)
+        g_hash_table_ref (bin->attributes);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -245,13 +293,10 @@ gst_editor_bin_realize (GooCanvasItem * citem)
 {
   GstEditorItem *item;
   GstEditorBin *bin;
-  const GList *children;
 
   item = GST_EDITOR_ITEM (citem);
   bin = GST_EDITOR_BIN (citem);
 
-  children = bin->elements;
-
   g_return_if_fail (item->object != NULL);
 
   EDITOR_DEBUG ("editor_bin: realize start");
@@ -263,20 +308,18 @@ gst_editor_bin_realize (GooCanvasItem * citem)
     GNOME_CANVAS_ITEM_CLASS (parent_class)->realize (citem);
 #endif
 
+  /* before the children, so links are painted below them */
+  if (!bin->link_layer)
+    bin->link_layer =
+        GST_EDITOR_LINK_LAYER (gst_editor_link_layer_new (citem));
+
   //children = gst_bin_get_list (GST_BIN (item->object));
   g_signal_connect (item->object, "element-added",
       G_CALLBACK (gst_editor_bin_element_added_cb), bin);
   g_signal_connect (item->object, "element-removed",
       G_CALLBACK (gst_editor_bin_element_removed_cb), bin);
 
-  children = g_list_last(GST_BIN_CHILDREN (GST_BIN (item->object)));
-
-  while (children) {
-    gst_editor_bin_element_added (item->object, GST_OBJECT (children->data),
-        bin);
-
-    children = g_list_previous (children);
-  }
+  gst_editor_bin_add_children (bin, GST_BIN (item->object));
 
 
 
@@ -360,22 +403,30 @@ gst_editor_bin_object_changed (GstEditorItem * item, GstObject * object)
 {
   GstEditorBin *bin = GST_EDITOR_BIN (item);
   GList *l = NULL;
+  GHashTableIter iter;
+  gpointer link;
   GstBin *gstbin = GST_BIN (object), *oldbin = GST_BIN (item->object);
   gdouble width, height, minwidth, minheight;
 
   if (oldbin&&gstbin) {
-    g_print("gst_editor_bin_object_changed called with old object, fix this ******** code!!! Delete instead of simple hide\n ");
+    EDITOR_DEBUG ("bin: replacing the object of %s, hiding its children",
+        item->title_text);
     //sleep(10);
     /* the proper solution would be to unref the child canvas items, but that
      * doesn't work right now (see bug 90259) -- just hide the children, then */
 
-    for (l = bin->elements; l; l = l->next)
-      goo_canvas_item_simple_hide (l->data);
-    for (l = bin->links; l; l = l->next)
-      goo_canvas_item_simple_hide (l->data);
+    for (guint i = 0; i < bin->sort.len; i++)
+      goo_canvas_item_simple_hide (GOO_CANVAS_ITEM_SIMPLE (bin->sort.elements[i]));
+    g_hash_table_iter_init (&iter, bin->links);
+    while (g_hash_table_iter_next (&iter, &link, NULL)) {
+      goo_canvas_item_simple_hide (link);
+      if (GST_EDITOR_LINK (link)->layer)
+        gst_editor_link_layer_remove (GST_EDITOR_LINK (link)->layer,
+            GST_EDITOR_LINK (link));
+    }
 
-    bin->elements = NULL;
-    bin->links = NULL;
+    g_hash_table_remove_all (bin->links);
+    gst_editor_bin_sort_clear (bin);
     //g_object_unref(G_OBJECT(oldbin));
 
     //normally done within realize, but otherwise it wont work:)
@@ -385,7 +436,7 @@ gst_editor_bin_object_changed (GstEditorItem * item, GstObject * object)
         G_CALLBACK (gst_editor_bin_element_removed_cb), bin);
   }
   if (oldbin&&!gstbin) {//we are getting deleted
-    g_print ("Disconnecting signals for old bin %s with pointer %p.\n",
+    EDITOR_DEBUG ("bin: disconnecting signals for old bin %s (%p)",
         item->title_text, item);
     if (GST_IS_BIN (oldbin)) {
       g_signal_handlers_disconnect_by_func (oldbin,
@@ -393,7 +444,7 @@ gst_editor_bin_object_changed (GstEditorItem * item, GstObject * object)
       g_signal_handlers_disconnect_by_func (oldbin,
           G_CALLBACK (gst_editor_bin_element_removed_cb), bin);
     } else {
-      g_print ("But GstBin seems to have disappeared\n");
+      EDITOR_DEBUG ("bin: the GstBin of %s has disappeared", item->title_text);
     }
   }
   if (gstbin) {
@@ -408,17 +459,171 @@ gst_editor_bin_object_changed (GstEditorItem * item, GstObject * object)
         g_object_set (item, "width", minwidth, "height", minheight, NULL);
     }
 
-    while (l) {
-      gst_editor_bin_element_added (GST_OBJECT (gstbin), GST_OBJECT (l->data),
-          bin);
-      l = g_list_previous (l);
-    }
+    gst_editor_bin_add_children (bin, gstbin);
   }
 
   if (GST_EDITOR_ITEM_CLASS (parent_class)->object_changed)
     (GST_EDITOR_ITEM_CLASS (parent_class)->object_changed) (item, object);
 }
 
+/**********************************************************************
+ * Layout state of the children
+ **********************************************************************/
+
+static void
+gst_editor_bin_sort_add (GstEditorBin * bin, GstEditorElement * child)
+{
+  GstEditorBinSortState *s = &bin->sort;
+  gint i;
+
+  if (s->len == s->allocated) {
+    s->allocated = MAX (s->allocated * 2, 16);
+    s->elements = g_renew (GstEditorElement *, s->elements, s->allocated);
+    s->x = g_renew (gdouble, s->x, s->allocated);
+    s->y = g_renew (gdouble, s->y, s->allocated);
+    s->w = g_renew (gdouble, s->w, s->allocated);
+    s->h = g_renew (gdouble, s->h, s->allocated);
+    s->fx = g_renew (gdouble, s->fx, s->allocated);
+    s->fy = g_renew (gdouble, s->fy, s->allocated);
+  }
+
+  i = child->sort_index = s->len++;
+  s->elements[i] = child;
+  s->fx[i] = s->fy[i] = 0;
+  gst_editor_bin_sort_update (bin, child);
+  gst_editor_bin_sort_unsettle (bin);
+}
+
+static void
+gst_editor_bin_sort_remove (GstEditorBin * bin, GstEditorElement * child)
+{
+  GstEditorBinSortState *s = &bin->sort;
+  gint i = child->sort_index;
+
+  if (i < 0 || (guint) i >= s->len || s->elements[i] != child)
+    return;
+
+  /* fill the gap with the last entry */
+  s->len--;
+  if ((guint) i != s->len) {
+    s->elements[i] = s->elements[s->len];
+    s->x[i] = s->x[s->len];
+    s->y[i] = s->y[s->len];
+    s->w[i] = s->w[s->len];
+    s->h[i] = s->h[s->len];
+    s->fx[i] = s->fx[s->len];
+    s->fy[i] = s->fy[s->len];
+    s->elements[i]->sort_index = i;
+  }
+
+  child->sort_index = -1;
+  gst_editor_bin_sort_unsettle (bin);
+}
+
+static void
+gst_editor_bin_sort_clear (GstEditorBin * bin)
+{
+  GstEditorBinSortState *s = &bin->sort;
+
+  for (guint i = 0; i < s->len; i++)
+    s->elements[i]->sort_index = -1;
+  s->len = 0;
+  gst_editor_bin_sort_unsettle (bin);
+}
+
+/*
+ * Resume sorting the children with a fresh step size.
+ * The parent bins can no longer skip this subtree either.
+ */
+static void
+gst_editor_bin_sort_unsettle (GstEditorBin * bin)
+{
+  GooCanvasItem *item;
+
+  gst_editor_layout_heat (&bin->sort);
+
+  for (item = goo_canvas_item_get_parent (GOO_CANVAS_ITEM (bin));
+      GST_IS_EDITOR_BIN (item) && GST_EDITOR_BIN (item)->sort.subtree_settled;
+      item = goo_canvas_item_get_parent (item))
+    GST_EDITOR_BIN (item)->sort.subtree_settled = FALSE;
+}
+
+/**********************************************************************
+ * Batch updates
+ **********************************************************************/
+
+/*
+ * Whether bin, one of its parent bins or the canvas is frozen,
+ * so repacking bin has to wait until the batch ends.
+ */
+static gboolean
+gst_editor_bin_is_frozen (GstEditorBin * bin)
+{
+  GooCanvas *canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (bin));
+  GooCanvasItem *item;
+
+  if (GST_IS_EDITOR_CANVAS (canvas) && GST_EDITOR_CANVAS (canvas)->freeze_count)
+    return TRUE;
+
+  for (item = GOO_CANVAS_ITEM (bin); GST_IS_EDITOR_BIN (item);
+      item = goo_canvas_item_get_parent (item))
+    if (GST_EDITOR_BIN (item)->freeze_count)
+      return TRUE;
+
+  return FALSE;
+}
+
+/*
+ * Repacks and syncs the bins that got new children during
+ * a batch. Nested bins are handled first since their size
+ * may affect their parents.
+ */
+void
+gst_editor_bin_flush (GstEditorBin * bin)
+{
+  g_return_if_fail (GST_IS_EDITOR_BIN (bin));
+
+  /* still part of a batch of its own */
+  if (bin->freeze_count)
+    return;
+
+  for (guint i = 0; i < bin->sort.len; i++)
+    if (GST_IS_EDITOR_BIN (bin->sort.elements[i]))
+      gst_editor_bin_flush (GST_EDITOR_BIN (bin->sort.elements[i]));
+
+  if (!bin->batch_pending)
+    return;
+  bin->batch_pending = FALSE;
+
+  gst_editor_bin_repack (GST_EDITOR_ITEM (bin));
+  g_idle_add ((GSourceFunc) gst_editor_element_sync_state, bin);
+}
+
+/*
+ * Begins a batch of updates on bin and its nested bins, e.g. while
+ * adding many elements. Instead of once per added element, the bins
+ * are repacked and their states are synced only once when the batch
+ * ends (see gst_editor_bin_thaw()).
+ * Batches may be nested.
+ */
+void
+gst_editor_bin_freeze (GstEditorBin * bin)
+{
+  g_return_if_fail (GST_IS_EDITOR_BIN (bin));
+
+  bin->freeze_count++;
+}
+
+void
+gst_editor_bin_thaw (GstEditorBin * bin)
+{
+  g_return_if_fail (GST_IS_EDITOR_BIN (bin));
+  g_return_if_fail (bin->freeze_count > 0);
+
+  if (--bin->freeze_count == 0 && !gst_editor_bin_is_frozen (bin))
+    gst_editor_bin_flush (bin);
+}
+
 /**********************************************************************
  * Callbacks from the gstbin (must be threadsafe)
  **********************************************************************/
@@ -427,8 +632,6 @@ static void
 gst_editor_bin_element_added (GstObject * bin, GstObject * child,
     GstEditorBin * editorbin)
 {
-  g_print("Element %s with pointer %p Added to bin %s with pointer %p and editorbin pointer %p getting mutex...\n",GST_OBJECT_NAME(child),(void*)child,GST_OBJECT_NAME(bin),bin,editorbin);
-  g_rw_lock_writer_lock (&(GST_EDITOR_ELEMENT(editorbin)->rwlock));
   GooCanvasItem *childitem;
   GstEditorItemAttr *attr = NULL;
   gdouble x, y, width, height;
@@ -440,22 +643,23 @@ gst_editor_bin_element_added (GstObject * bin, GstObject * child,
 
   if (gst_editor_item_get (child)) {
     GST_DEBUG_OBJECT (bin, "child %s already rendered, ignoring", child_name);
-    g_print("child %s already rendered, ignoring", child_name);
     GstEditorItem * realive=gst_editor_item_get (child);
-    if (GOO_IS_CANVAS_ITEM(realive)) {g_print("seems to bee still alive, parent %p", goo_canvas_item_get_parent(GOO_CANVAS_ITEM(realive)));
+    if (GOO_IS_CANVAS_ITEM(realive)) {
+       EDITOR_LOG ("bin: item of %s still alive, parent %p", child_name,
+           goo_canvas_item_get_parent (GOO_CANVAS_ITEM (realive)));
        //if (!goo_canvas_item_get_parent(GOO_CANVAS_ITEM(realive))) goo_canvas_item_set_parent(GOO_CANVAS_ITEM(realive),GOO_CANVAS_ITEM (editorbin));
        //goo_canvas_item_raise(realive,GOO_CANVAS_ITEM (editorbin));
      }  
-    g_rw_lock_writer_unlock (&(GST_EDITOR_ELEMENT(editorbin)->rwlock));
     return;
   }
 
   /* first check if we have previously stored position and size */
-  if ((editorbin->attributes)&&(*editorbin->attributes)){
-    GST_DEBUG_OBJECT (bin, "Trying to get attributes for %s, Attributes-Pointer %p, Attributes-Pointer-Pointer %p", child_name,*editorbin->attributes,editorbin->attributes);
-    /* see if the datalist has coordinates for this element,
+  if (editorbin->attributes) {
+    GST_DEBUG_OBJECT (bin, "Trying to get attributes for %s, Attributes-Pointer %p",
+        child_name, editorbin->attributes);
+    /* see if the table has coordinates for this element,
        and override if we do */
-    attr = g_datalist_get_data (editorbin->attributes, child_name);
+    attr = g_hash_table_lookup (editorbin->attributes, child_name);
   }
 
   /* now decide */
@@ -471,7 +675,8 @@ gst_editor_bin_element_added (GstObject * bin, GstObject * child,
     //}
     width = attr->w;
     height = attr->h;
-    g_datalist_remove_data (editorbin->attributes, child_name);
+    /* frees attr */
+    g_hash_table_remove (editorbin->attributes, child_name);
     GST_DEBUG_OBJECT (bin, "Got loaded attributes for %s", child_name);
   } else if (editorbin->element_x > 0) {
     /* first element to auto position */
@@ -482,7 +687,7 @@ gst_editor_bin_element_added (GstObject * bin, GstObject * child,
     GST_DEBUG_OBJECT (bin, "got x/y based on element_x/_y %s", child_name);
   } else {
     /* autoposition element */
-    gint len = g_list_length (editorbin->elements);
+    gint len = editorbin->sort.len;
 
     g_object_get (editorbin, "width", &width, "height", &height, NULL);
 
@@ -540,42 +745,96 @@ goo_canvas_item_get_simple_transform(GOO_CANVAS_ITEM (childitem),
 g_print("In editorbin, gotten Transformation x: %f y:%f Scale %f Rotation %f and X: %f Y:%f\n",getx,gety,getscale,getrotation,x,y);*/
 #endif
 
-  editorbin->elements = g_list_prepend (editorbin->elements, childitem);
+  gst_editor_bin_sort_add (editorbin, GST_EDITOR_ELEMENT (childitem));
   GST_DEBUG_OBJECT (bin, "done adding new object %s", child_name);
   g_object_ref (childitem);
 
-  gst_editor_bin_repack (GST_EDITOR_ITEM (editorbin));
-  //gst_editor_element_move (GST_EDITOR_ELEMENT (childitem), 0.0, 0.0);
-  g_idle_add ((GSourceFunc) gst_editor_element_sync_state, editorbin);
-  g_print("Finished adding element %s with pointer %p Added to bin %s with pointer %p getting mutex...List of parent has now %d entries\n",GST_OBJECT_NAME(child),(void*)child,GST_OBJECT_NAME(bin),bin,g_list_length(editorbin->elements));
-  g_rw_lock_writer_unlock (&(GST_EDITOR_ELEMENT(editorbin)->rwlock));
+  if (gst_editor_bin_is_frozen (editorbin)) {
+    /* see gst_editor_bin_flush() */
+    editorbin->batch_pending = TRUE;
+  } else {
+    gst_editor_bin_repack (GST_EDITOR_ITEM (editorbin));
+    //gst_editor_element_move (GST_EDITOR_ELEMENT (childitem), 0.0, 0.0);
+    g_idle_add ((GSourceFunc) gst_editor_element_sync_state, editorbin);
+  }
+}
+
+/*
+ * Adds the canvas items for all existing children of bin.
+ * While the canvas is progressive, they are only queued
+ * (see gst_editor_canvas_realize_step()).
+ */
+static void
+gst_editor_bin_add_children (GstEditorBin * editorbin, GstBin * bin)
+{
+  GooCanvas *canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (editorbin));
+  gboolean progressive =
+      GST_IS_EDITOR_CANVAS (canvas) && GST_EDITOR_CANVAS (canvas)->progressive;
+  GList *l;
+
+  for (l = g_list_last (bin->children); l; l = g_list_previous (l)) {
+    if (progressive)
+      gst_editor_canvas_defer_child (GST_EDITOR_CANVAS (canvas), editorbin,
+          GST_OBJECT (l->data));
+    else
+      gst_editor_bin_element_added (GST_OBJECT (bin), GST_OBJECT (l->data),
+          editorbin);
+  }
+}
+
+/*
+ * Adds the canvas item of a child deferred by
+ * gst_editor_bin_add_children().
+ * Returns FALSE if child has been added or removed in the meantime.
+ */
+gboolean
+gst_editor_bin_realize_child (GstEditorBin * editorbin, GstObject * child)
+{
+  GstObject *bin = GST_EDITOR_ITEM (editorbin)->object;
+
+  if (!bin || GST_OBJECT_PARENT (child) != bin || gst_editor_item_get (child))
+    return FALSE;
+
+  gst_editor_bin_element_added (bin, child, editorbin);
+
+  return TRUE;
 }
 
 /*
  * Can be called from another thread.
  * At least this seemed to be the case in GStreamer 0.10.
+ * The child is added in the main thread, see gsteditordispatch.c.
  */
 static void
 gst_editor_bin_element_added_cb (GstBin * bin, GstElement * child, gpointer user_data)
 {
-  GstEditorBin *editorbin = GST_EDITOR_BIN (user_data);
-
   g_debug ("gst_editor_bin_element_added_cb: %s with pointer %p Added to bin %s "
-      "with pointer %p getting global mutex...",
+      "with pointer %p",
       GST_OBJECT_NAME (child), (void *)child, GST_OBJECT_NAME (bin), bin);
 
-  g_rw_lock_writer_lock (GST_EDITOR_ITEM (editorbin)->globallock);
-  gst_editor_bin_element_added (GST_OBJECT (bin), GST_OBJECT (child), editorbin);
-  g_rw_lock_writer_unlock (GST_EDITOR_ITEM (editorbin)->globallock);
+  gst_editor_dispatch ((GstEditorDispatchFunc) gst_editor_bin_child_added,
+      user_data, bin, child);
+}
+
+static void
+gst_editor_bin_child_added (GstEditorBin * editorbin, GstObject * bin,
+    GstObject * child)
+{
+  /* removed again by the time the record is run */
+  if (GST_EDITOR_ITEM (editorbin)->object != bin ||
+      GST_OBJECT_PARENT (child) != bin)
+    return;
+
+  gst_editor_bin_element_added (bin, child, editorbin);
 }
 
 static void
 unset_deepdelete_editor_pads (GstEditorElement * element)
 {
-  int numc = g_list_length (element->srcpads);
+  int numc = element->srcpads.length;
   g_debug ("removing %d srcpads from element %p", numc, element);
   GList * l;
-  l = element->srcpads;
+  l = element->srcpads.head;
   while (l) {
     if (GST_IS_EDITOR_ITEM (l->data)) {
       gst_editor_item_hash_remove (GST_EDITOR_ITEM (l->data)->object);
@@ -586,9 +845,9 @@ unset_deepdelete_editor_pads (GstEditorElement * element)
       goo_canvas_item_remove (l->data);
     l = g_list_next (l);
   }
-  numc = g_list_length (element->sinkpads);
+  numc = element->sinkpads.length;
   g_debug ("removing %d sinkpads", numc);
-  l = element->sinkpads;
+  l = element->sinkpads.head;
   while (l) {
     if (GST_IS_EDITOR_ITEM (l->data)) {
       g_debug ("Processing sinkpad %p, object %p", l->data,
@@ -608,28 +867,32 @@ unset_deepdelete_editor_pads (GstEditorElement * element)
 static void
 unset_deepdelete_editor (GstEditorBin * bin)
 {
-  int numc = g_list_length (bin->elements);
+  int numc = bin->sort.len;
   g_debug ("removing %d children", numc);
-  GList * l;
-  l = bin->elements;
-  while (l) {
-    if (GST_IS_EDITOR_BIN (l->data))
-      unset_deepdelete_editor (l->data);
-    if (GST_IS_EDITOR_ELEMENT (l->data))
-      unset_deepdelete_editor_pads (GST_EDITOR_ELEMENT (l->data));
-    if (GST_IS_EDITOR_ITEM (l->data)) {
-      gst_editor_item_hash_remove (GST_EDITOR_ITEM (l->data)->object);
-      gst_editor_item_disconnect (GST_EDITOR_ITEM (bin), l->data);
+  GList * l, * links;
+  for (guint i = 0; i < bin->sort.len; i++) {
+    GstEditorElement *child = bin->sort.elements[i];
+
+    if (GST_IS_EDITOR_BIN (child))
+      unset_deepdelete_editor (GST_EDITOR_BIN (child));
+    if (GST_IS_EDITOR_ELEMENT (child))
+      unset_deepdelete_editor_pads (child);
+    if (GST_IS_EDITOR_ITEM (child)) {
+      gst_editor_item_hash_remove (GST_EDITOR_ITEM (child)->object);
+      gst_editor_item_disconnect (GST_EDITOR_ITEM (bin), GST_EDITOR_ITEM (child));
       // should free all the callbacks
-      g_object_set (GST_EDITOR_ITEM (l->data), "object", NULL, NULL);
+      g_object_set (GST_EDITOR_ITEM (child), "object", NULL, NULL);
     }
-    if (GOO_IS_CANVAS_ITEM (l->data))
-      goo_canvas_item_remove (GOO_CANVAS_ITEM (l->data));
-    l = g_list_next (l);
+    if (GOO_IS_CANVAS_ITEM (child))
+      goo_canvas_item_remove (GOO_CANVAS_ITEM (child));
   }
-  l = bin->links;
+  /* the links may remove themselves from the set when unreffed */
+  links = l = g_hash_table_get_keys (bin->links);
   while (l) {
     if ((l->data) && (GST_IS_EDITOR_LINK (l->data))) {
+      if (GST_EDITOR_LINK (l->data)->layer)
+        gst_editor_link_layer_remove (GST_EDITOR_LINK (l->data)->layer,
+            GST_EDITOR_LINK (l->data));
       if (GOO_IS_CANVAS_ITEM (GST_EDITOR_LINK (l->data)->canvas))
         goo_canvas_item_remove (
             GOO_CANVAS_ITEM (GST_EDITOR_LINK (l->data)->canvas));
@@ -640,33 +903,41 @@ unset_deepdelete_editor (GstEditorBin * bin)
       g_debug ("failed to remove GstEditorlink %p", l->data);
     l = g_list_next (l);
   }
+  g_list_free (links);
   g_debug ("unset_deepdelete finished");
 }
 
 static void
 gst_editor_bin_element_removed_cb (GstBin * bin, GstElement * child, gpointer user_data)
 {
-  GstEditorBin *editorbin = GST_EDITOR_BIN (user_data);
-  GstEditorElement *child_element;
-
   g_debug ("gst_editor_bin_element_removed_cb: %s with pointer %p removed from bin %s "
-      "with pointer %p; getting global mutex...",
+      "with pointer %p",
       GST_OBJECT_NAME (child), (void *)child, GST_OBJECT_NAME (bin), bin);
 
-  g_rw_lock_writer_lock (GST_EDITOR_ITEM (editorbin)->globallock);
-  child_element = GST_EDITOR_ELEMENT (gst_editor_item_get (GST_OBJECT (child)));
-  g_assert (child_element != NULL);
-  g_rw_lock_writer_lock (&child_element->rwlock);
+  gst_editor_dispatch ((GstEditorDispatchFunc) gst_editor_bin_child_removed,
+      user_data, bin, child);
+}
+
+static void
+gst_editor_bin_child_removed (GstEditorBin * editorbin, GstObject * bin,
+    GstObject * child)
+{
+  GstEditorElement *child_element;
+
+  /* never added, e.g. removed again before its record was run */
+  child_element = GST_EDITOR_ELEMENT (gst_editor_item_get (child));
+  if (!child_element)
+    return;
 
   gst_editor_item_disconnect (GST_EDITOR_ITEM (editorbin),
       GST_EDITOR_ITEM (child_element));
-  editorbin->elements = g_list_remove (editorbin->elements, child_element);
+  gst_editor_bin_sort_remove (editorbin, child_element);
 
   if (child_element->active)
     g_object_set (goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (child_element)),
         "selection", NULL, NULL);
 
-  gst_editor_item_hash_remove (GST_OBJECT (child));
+  gst_editor_item_hash_remove (child);
 
   if (GST_EDITOR_ITEM (child_element)->object)
     g_object_set (child_element, "object", NULL, NULL);
@@ -685,9 +956,6 @@ gst_editor_bin_element_removed_cb (GstBin * bin, GstElement * child, gpointer us
 
   goo_canvas_item_remove (GOO_CANVAS_ITEM (child_element));
 
-  g_rw_lock_writer_unlock (&child_element->rwlock);
-  g_rw_lock_writer_unlock (GST_EDITOR_ITEM(editorbin)->globallock);
-
   g_object_unref (child_element);
 
   g_debug ("Survived removing this item:%s %p Pointer of GstEditorElement %p",
@@ -746,33 +1014,22 @@ on_paste (GSimpleAction * action,
  * Public functions
  **********************************************************************/
 
-/* a convenience structure */
-typedef struct _element element;
-
-struct _element
-{
-  GstEditorElement *element;
-  gdouble x;
-  gdouble y;
-  gdouble w;
-  gdouble h;
-  gdouble fx;
-  gdouble fy;
-};
-
 /* links are ideally 20 pixels long and horizontal. The force is directly
    proportional to the 'stretching' of the links. */
 static void
-calculate_link_forces (GList * links)
+calculate_link_forces (GstEditorBin * bin)
 {
-  GList *l;
+  GstEditorBinSortState *s = &bin->sort;
+  GHashTableIter iter;
+  gpointer l;
   GstEditorElement *src, *sink;
   GstEditorLink *c;
-  element *srce, *sinke;
+  gint srci, sinki;
   gdouble x1, x2, y1, y2, fx, fy;
 
-  for (l = links; l; l = l->next) {
-    c = GST_EDITOR_LINK (l->data);
+  g_hash_table_iter_init (&iter, bin->links);
+  while (g_hash_table_iter_next (&iter, &l, NULL)) {
+    c = GST_EDITOR_LINK (l);
     src =
         GST_EDITOR_ELEMENT (goo_canvas_item_get_parent (GOO_CANVAS_ITEM (c->
                 srcpad)));
@@ -780,9 +1037,11 @@ calculate_link_forces (GList * links)
         GST_EDITOR_ELEMENT (goo_canvas_item_get_parent (GOO_CANVAS_ITEM (c->
                 sinkpad)));
 
-
-    srce = g_object_get_data (G_OBJECT (src), "sort-data");
-    sinke = g_object_get_data (G_OBJECT (sink), "sort-data");
+    /* links may lead to elements outside of this bin (ghost pads) */
+    srci = goo_canvas_item_get_parent (GOO_CANVAS_ITEM (src)) ==
+        GOO_CANVAS_ITEM (bin) ? src->sort_index : -1;
+    sinki = goo_canvas_item_get_parent (GOO_CANVAS_ITEM (sink)) ==
+        GOO_CANVAS_ITEM (bin) ? sink->sort_index : -1;
 
     g_object_get (c, "x1", &x1, "y1", &y1, "x2", &x2, "y2", &y2, NULL);
 
@@ -797,96 +1056,104 @@ calculate_link_forces (GList * links)
     }
 */
 
-    if (srce) {
-      srce->fx += fx;
-      srce->fy += fy;
+    if (srci >= 0) {
+      s->fx[srci] += fx;
+      s->fy[srci] += fy;
     }
-    if (sinke) {
-      sinke->fx -= fx;
-      sinke->fy -= fy;
-    }
-  }
-}
-
-/* elements repel each other in direct proportion to the degree that they
-   overlap in the x and y directions. This repulsion starts when elements get
-   closer than 15 pixels away in the x direction, and 5 in the y direction. */
-static void
-calculate_element_repulsion_forces (element * e, gint num_children)
-{
-  gint i, j;
-  gdouble fx, fy;
-  gdouble x1, y1, x2, y2;
-
-  /* discourage element overlap */
-  for (i = 0; i < num_children; i++) {
-    for (j = i + 1; j < num_children; j++) {
-      /* we want the coordinates of the centers of the elements */
-      x1 = e[i].x + e[i].w * 0.5;
-      x2 = e[j].x + e[j].w * 0.5;
-      y1 = e[i].y + e[i].h * 0.5;
-      y2 = e[j].y + e[j].h * 0.5;
-
-      /* x distance more important than y distance */
-      fx = (0.5 * (e[i].w + e[j].w) + 15 - ABS (x2 - x1)) * 1.5;
-      fy = (0.5 * (e[i].h + e[j].h) + 5 - ABS (y2 - y1)) * 1.5;
-
-      if (fx > 0 && fy > 0) {
-        e[i].fx += fx * ((x1 > x2) ? 1.0 : -1.0);
-        e[j].fx += fx * ((x1 > x2) ? -1.0 : 1.0);
-        e[i].fy += fy * ((y1 > y2) ? 1.0 : -1.0);
-        e[j].fy += fy * ((y1 > y2) ? -1.0 : 1.0);
-      }
+    if (sinki >= 0) {
+      s->fx[sinki] -= fx;
+      s->fy[sinki] -= fy;
     }
   }
 }
 
+/*
+ * Performs one sort iteration on bin and its child bins using their
+ * adaptive step sizes. Bins whose children have converged are skipped,
+ * as are entire subtrees that have converged.
+ * Returns the distance the children have been moved, which is 0
+ * once everything has settled.
+ */
 gdouble
-gst_editor_bin_sort (GstEditorBin * bin, gdouble step)
+gst_editor_bin_sort (GstEditorBin * bin)
 {
+  GstEditorBinSortState *s;
   gdouble ret = 0;
-  gint i, num_children;
-  GstEditorElement *gstelement;
-  element *e;
-  GList *l;
+  gboolean subtree_settled;
+  guint i;
 
   g_return_val_if_fail (GST_IS_EDITOR_BIN (bin), 0);
 
-  num_children = g_list_length (bin->elements);
-  if (num_children == 0)
+  s = &bin->sort;
+  if (s->subtree_settled)
     return 0;
 
-  /* set up the element* structs */
-  e = g_new0 (element, num_children);
-  for (l = bin->elements, i = 0; l; l = l->next, i++) {
-    gstelement = GST_EDITOR_ELEMENT (l->data);
-    g_object_get (gstelement, "x", &e[i].x, "y", &e[i].y, "width", &e[i].w,
-        "height", &e[i].h, NULL);
+  if (s->len == 0) {
+    s->settled = TRUE;
+  } else if (!s->settled) {
+    gdouble energy = 0;
+
+    /* calculate the forces */
+    memset (s->fx, 0, s->len * sizeof (gdouble));
+    memset (s->fy, 0, s->len * sizeof (gdouble));
+    calculate_link_forces (bin);
+    gst_editor_layout_repulsion_forces (s);
+
+    /* do the moving: this updates the positions in the sort state */
+    for (i = 0; i < s->len; i++) {
+      gdouble x = s->x[i], y = s->y[i];
+
+      energy += ABS (s->fx[i]) + ABS (s->fy[i]);
+      gst_editor_element_move (s->elements[i],
+          s->fx[i] * s->step, s->fy[i] * s->step);
+      ret += ABS (s->x[i] - x) + ABS (s->y[i] - y);
+    }
 
+    gst_editor_layout_cool (s, energy, ret);
+  }
 
+  /* child bins are sorted independently of their position */
+  subtree_settled = s->settled;
+  for (i = 0; i < s->len; i++) {
+    if (GST_IS_EDITOR_BIN (s->elements[i])) {
+      GstEditorBin *child = GST_EDITOR_BIN (s->elements[i]);
 
-    e[i].element = gstelement;
-    g_object_set_data (G_OBJECT (gstelement), "sort-data", &e[i]);
+      ret += gst_editor_bin_sort (child);
+      subtree_settled &= child->sort.subtree_settled;
+    }
   }
+  s->subtree_settled = subtree_settled;
 
-  /* calculate the forces */
-  calculate_link_forces (bin->links);
-  calculate_element_repulsion_forces (e, num_children);
+  return ret;
+}
 
-  /* do the moving */
-  for (i = 0; i < num_children; i++) {
-    gst_editor_element_move (e[i].element, e[i].fx * step, e[i].fy * step);
-    g_object_set_data (G_OBJECT (e[i].element), "sort-data", NULL);
+/*
+ * Refresh the layout state of a child from its canvas item.
+ * This must be called whenever the child has been moved or resized.
+ */
+void
+gst_editor_bin_sort_update (GstEditorBin * bin, GstEditorElement * child)
+{
+  GstEditorBinSortState *s;
+  gdouble scale, rotation;
+  gint i;
 
-    ret += ABS (e[i].fx) * step + ABS (e[i].fy) * step;
+  g_return_if_fail (GST_IS_EDITOR_BIN (bin));
 
-    if (GST_IS_EDITOR_BIN (e[i].element))
-      ret += gst_editor_bin_sort ((GstEditorBin *) e[i].element, step);
-  }
+  s = &bin->sort;
+  i = child->sort_index;
+  /* not (yet) added to this bin */
+  if (i < 0 || (guint) i >= s->len || s->elements[i] != child)
+    return;
 
-  g_free (e);
+  goo_canvas_item_get_simple_transform (GOO_CANVAS_ITEM (child),
+      &s->x[i], &s->y[i], &scale, &rotation);
+  s->w[i] = GST_EDITOR_ITEM (child)->width;
+  s->h[i] = GST_EDITOR_ITEM (child)->height;
 
-  return ret;
+  /* moved or resized from the outside */
+  if (s->settled)
+    gst_editor_bin_sort_unsettle (bin);
 }
 
 gboolean
@@ -918,7 +1185,9 @@ gst_editor_bin_paste_from_string (GstEditorBin * bin, const gchar * str,
   }
 
   /* `element` has a floating reference */
+  gst_editor_bin_freeze (bin);
   gst_bin_add (GST_BIN (GST_EDITOR_ITEM (bin)->object), element);
+  gst_editor_bin_thaw (bin);
   return TRUE;
 }
 
@@ -971,18 +1240,15 @@ gst_editor_bin_debug_output (GstEditorBin * bin){
   g_print("GstEditorItem: Titletext %s    \n",item->title_text);
   g_print("GstEditorElement: sinks: %d sources: %d \n",element->sinks,element->srcs);
   if (!GST_IS_EDITOR_BIN(bin)) return;
-  g_print("GstEditorBin: elements: %d links: %d. Getting children from EditorBin.\n",g_list_length(bin->elements),g_list_length(bin->links));
+  g_print("GstEditorBin: elements: %d links: %d. Getting children from EditorBin.\n",bin->sort.len,g_hash_table_size(bin->links));
   //iterate children of editorbin
-  const GList *elements;
-  elements=bin->elements;
-  while (elements) {
-  if (GST_IS_EDITOR_BIN(elements->data)){
-    gst_editor_bin_debug_output(GST_EDITOR_BIN(elements->data));
+  for (guint i = 0; i < bin->sort.len; i++) {
+  if (GST_IS_EDITOR_BIN(bin->sort.elements[i])){
+    gst_editor_bin_debug_output(GST_EDITOR_BIN(bin->sort.elements[i]));
     }
-  else if (GST_IS_EDITOR_ELEMENT(elements->data)){
-    g_print("Child Element of gstbin is called %s",GST_EDITOR_ITEM(elements->data)->title_text);
+  else if (GST_IS_EDITOR_ELEMENT(bin->sort.elements[i])){
+    g_print("Child Element of gstbin is called %s",GST_EDITOR_ITEM(bin->sort.elements[i])->title_text);
     }
-  elements = g_list_next (elements);
   }
   //iterare children of goo_canvas_item
   g_print("canvas Item has children: %d\n",goo_canvas_item_get_n_children(canvas));
@@ -33,18 +33,52 @@
 #define GST_IS_EDITOR_BIN_CLASS(obj) (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_EDITOR_BIN))
 #define GST_EDITOR_BIN_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_TYPE_EDITOR_BIN, GstEditorBinClass))
 
+/*
+ * Layout state of a bin's children as used by gst_editor_bin_sort().
+ * It is kept up to date when children are added, removed, moved
+ * or resized, so sorting does not have to query the canvas items.
+ * The arrays are indexed by GstEditorElement::sort_index.
+ * elements also serves as the list of the bin's children.
+ */
+typedef struct _GstEditorBinSortState
+{
+  guint len, allocated;
+
+  GstEditorElement **elements;
+  gdouble *x, *y, *w, *h;	/* position relative to the bin and size */
+  gdouble *fx, *fy;		/* forces of the current sort step */
+
+  /* adaptive step size and convergence, see gst_editor_layout_cool() */
+  gdouble step, max_step, energy;
+  guint progress, calm;
+  gboolean settled;		/* the children have converged */
+  gboolean subtree_settled;	/* ...and so have the children of all child bins */
+} GstEditorBinSortState;
+
 typedef struct _GstEditorBin
 {
   GstEditorElement element;
 
-  /* lists of GUI elements and links */
-  GList *elements, *links;
+  /* set of the GstEditorLinks of children (see also GstEditorBinSortState) */
+  GHashTable *links;
+  /* paints the links between children, see gsteditorlinklayer.h */
+  struct _GstEditorLinkLayer *link_layer;
 
   /* where to make the next new element */
   gdouble element_x, element_y;
 
-  /* datalist of GstElement names -> GstEditorItemAttr structs */
-  GData **attributes;
+  /*
+   * GstElement names -> GstEditorItemAttr structs,
+   * shared with the canvas and all nested bins
+   */
+  GHashTable *attributes;
+
+  /* children layout, see gst_editor_bin_sort() */
+  GstEditorBinSortState sort;
+
+  /* batch updates, see gst_editor_bin_freeze() */
+  guint freeze_count;
+  gboolean batch_pending;	/* children were added while frozen */
 } GstEditorBin;
 
 typedef struct _GstEditorBinClass
@@ -53,10 +87,14 @@ typedef struct _GstEditorBinClass
 } GstEditorBinClass;
 
 GType gst_editor_bin_get_type (void);
-gdouble gst_editor_bin_sort (GstEditorBin * bin, gdouble step);
+gdouble gst_editor_bin_sort (GstEditorBin * bin);
+void gst_editor_bin_sort_update (GstEditorBin * bin,
+    GstEditorElement * child);
 gboolean gst_editor_bin_paste_from_string (GstEditorBin * bin,
     const gchar * str, GError ** error);
 void gst_editor_bin_paste (GstEditorBin * bin, GdkAtom selection);
+void gst_editor_bin_freeze (GstEditorBin * bin);
+void gst_editor_bin_thaw (GstEditorBin * bin);
 void gst_editor_bin_debug_output (GstEditorBin * bin);
 
 /*
@@ -64,5 +102,9 @@ void gst_editor_bin_debug_output (GstEditorBin * bin);
  * a flawed understanding of widget realization.
  */
 void gst_editor_bin_realize (GooCanvasItem * citem);
+/* used by gst_editor_canvas_thaw() */
+void gst_editor_bin_flush (GstEditorBin * bin);
+/* used by gst_editor_canvas_realize_step() */
+gboolean gst_editor_bin_realize_child (GstEditorBin * bin, GstObject * child);
 
 #endif /* __GST_EDITOR_BIN_H__ */
@@ -0,0 +1,400 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Compact rendering of GstEditorElements.
+ *
+ * A GstEditorElement normally consists of a border rectangle, a title
+ * text, a state box, four state icons and a resize box, each a canvas
+ * item of its own that has to be traversed on every redraw and hit test.
+ * GstEditorBody paints all of them in one item and hit-tests them
+ * analytically (see gst_editor_body_get_part()). Its geometry matches
+ * gst_editor_element_repack().
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gtk/gtk.h>
+#include <goocanvas.h>
+
+#include "../../../pixmaps/pixmaps.h"
+
+#include "gsteditorcanvas.h"
+#include "gsteditorbody.h"
+
+/* position of the title, see GstEditorItem::textx */
+#define TITLE_OFFSET 1.0
+/* the resize box is 4x4 */
+#define RESIZE_SIZE 4.0
+
+enum
+{
+  PROP_0,
+  PROP_X,
+  PROP_Y,
+  PROP_WIDTH,
+  PROP_HEIGHT,
+  PROP_TITLE,
+  PROP_SHOW_STATES,
+  PROP_STATE,
+  PROP_RESIZEABLE,
+  PROP_RESIZE_HIGHLIGHT
+};
+
+G_DEFINE_TYPE (GstEditorBody, gst_editor_body, GOO_TYPE_CANVAS_ITEM_SIMPLE);
+
+static void
+gst_editor_body_finalize (GObject * object)
+{
+  GstEditorBody *body = GST_EDITOR_BODY (object);
+
+  g_free (body->title);
+
+  G_OBJECT_CLASS (gst_editor_body_parent_class)->finalize (object);
+}
+
+static void
+gst_editor_body_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstEditorBody *body = GST_EDITOR_BODY (object);
+  gboolean recompute_bounds = FALSE;
+
+  switch (prop_id) {
+    case PROP_X:
+      body->x = g_value_get_double (value);
+      recompute_bounds = TRUE;
+      break;
+    case PROP_Y:
+      body->y = g_value_get_double (value);
+      recompute_bounds = TRUE;
+      break;
+    case PROP_WIDTH:
+      body->width = g_value_get_double (value);
+      recompute_bounds = TRUE;
+      break;
+    case PROP_HEIGHT:
+      body->height = g_value_get_double (value);
+      recompute_bounds = TRUE;
+      break;
+    case PROP_TITLE:
+      g_free (body->title);
+      body->title = g_value_dup_string (value);
+      break;
+    case PROP_SHOW_STATES:
+      body->show_states = g_value_get_boolean (value);
+      break;
+    case PROP_STATE:
+      body->state = g_value_get_int (value);
+      break;
+    case PROP_RESIZEABLE:
+      body->resizeable = g_value_get_boolean (value);
+      break;
+    case PROP_RESIZE_HIGHLIGHT:
+      body->resize_highlight = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      return;
+  }
+
+  goo_canvas_item_simple_changed (GOO_CANVAS_ITEM_SIMPLE (body),
+      recompute_bounds);
+}
+
+static void
+gst_editor_body_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstEditorBody *body = GST_EDITOR_BODY (object);
+
+  switch (prop_id) {
+    case PROP_X:
+      g_value_set_double (value, body->x);
+      break;
+    case PROP_Y:
+      g_value_set_double (value, body->y);
+      break;
+    case PROP_WIDTH:
+      g_value_set_double (value, body->width);
+      break;
+    case PROP_HEIGHT:
+      g_value_set_double (value, body->height);
+      break;
+    case PROP_TITLE:
+      g_value_set_string (value, body->title);
+      break;
+    case PROP_SHOW_STATES:
+      g_value_set_boolean (value, body->show_states);
+      break;
+    case PROP_STATE:
+      g_value_set_int (value, body->state);
+      break;
+    case PROP_RESIZEABLE:
+      g_value_set_boolean (value, body->resizeable);
+      break;
+    case PROP_RESIZE_HIGHLIGHT:
+      g_value_set_boolean (value, body->resize_highlight);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* zoomed out, only the box is painted (see GST_EDITOR_CANVAS_DETAIL_SCALE) */
+static gboolean
+gst_editor_body_is_detailed (GstEditorBody * body)
+{
+  GooCanvas *canvas = GOO_CANVAS_ITEM_SIMPLE (body)->canvas;
+
+  return !canvas ||
+      goo_canvas_get_scale (canvas) >= GST_EDITOR_CANVAS_DETAIL_SCALE;
+}
+
+static PangoLayout *
+gst_editor_body_create_layout (GstEditorBody * body, cairo_t * cr)
+{
+  PangoLayout *layout = pango_cairo_create_layout (cr);
+
+  pango_layout_set_font_description (layout,
+      GST_EDITOR_BODY_GET_CLASS (body)->font);
+  pango_layout_set_text (layout, body->title ? body->title : "", -1);
+
+  return layout;
+}
+
+static void
+gst_editor_body_update (GooCanvasItemSimple * simple, cairo_t * cr)
+{
+  GstEditorBody *body = GST_EDITOR_BODY (simple);
+  gdouble half_line_width = goo_canvas_item_simple_get_line_width (simple) / 2;
+
+  /* in user space, converted to device space by GooCanvasItemSimple */
+  simple->bounds.x1 = body->x - half_line_width;
+  simple->bounds.y1 = body->y - half_line_width;
+  simple->bounds.x2 = body->x + body->width + half_line_width;
+  simple->bounds.y2 = body->y + body->height + half_line_width;
+}
+
+static void
+gst_editor_body_paint (GooCanvasItemSimple * simple, cairo_t * cr,
+    const GooCanvasBounds * bounds)
+{
+  GstEditorBody *body = GST_EDITOR_BODY (simple);
+  GstEditorBodyClass *klass = GST_EDITOR_BODY_GET_CLASS (body);
+  gdouble line_width = goo_canvas_item_simple_get_line_width (simple);
+  gdouble x, y;
+  PangoLayout *layout;
+
+  /* the border */
+  cairo_rectangle (cr, body->x, body->y, body->width, body->height);
+  goo_canvas_item_simple_paint_path (simple, cr);
+
+  if (!gst_editor_body_is_detailed (body))
+    return;
+
+  /* the title */
+  layout = gst_editor_body_create_layout (body, cr);
+  cairo_set_source_rgb (cr, 0., 0., 0.);
+  cairo_move_to (cr, body->x + TITLE_OFFSET, body->y + TITLE_OFFSET);
+  pango_cairo_show_layout (cr, layout);
+  g_object_unref (layout);
+
+  /* the state box and icons */
+  y = body->y + body->height - body->state_height;
+  if (body->show_states && body->state >= 0) {
+    cairo_rectangle (cr, body->x + body->state_width * body->state, y,
+        body->state_width, body->state_height);
+    cairo_set_source_rgb (cr, 1., 1., 1.);
+    cairo_fill_preserve (cr);
+    cairo_set_source_rgb (cr, 0., 0., 0.);
+    cairo_set_line_width (cr, line_width);
+    cairo_stroke (cr);
+  }
+  for (gint i = 0; body->show_states && i < 4; i++) {
+    x = body->x + body->state_width * i + 1.0;
+    cairo_set_source_surface (cr, klass->state_icons[i], x, y + 1.0);
+    cairo_rectangle (cr, x, y + 1.0,
+        cairo_image_surface_get_width (klass->state_icons[i]),
+        cairo_image_surface_get_height (klass->state_icons[i]));
+    cairo_fill (cr);
+  }
+
+  /* the resize box */
+  if (body->resizeable) {
+    cairo_rectangle (cr, body->x + body->width - RESIZE_SIZE,
+        body->y + body->height - RESIZE_SIZE, RESIZE_SIZE, RESIZE_SIZE);
+    if (body->resize_highlight)
+      cairo_set_source_rgb (cr, 1., 0., 0.);
+    else
+      cairo_set_source_rgb (cr, 1., 1., 1.);
+    cairo_fill_preserve (cr);
+    cairo_set_source_rgb (cr, 0., 0., 0.);
+    cairo_set_line_width (cr, 1.);
+    cairo_stroke (cr);
+  }
+}
+
+static gboolean
+gst_editor_body_is_item_at (GooCanvasItemSimple * simple, gdouble x,
+    gdouble y, cairo_t * cr, gboolean is_pointer_event)
+{
+  GstEditorBody *body = GST_EDITOR_BODY (simple);
+
+  return x >= body->x && x <= body->x + body->width &&
+      y >= body->y && y <= body->y + body->height;
+}
+
+static void
+gst_editor_body_class_init (GstEditorBodyClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GooCanvasItemSimpleClass *simple_class = GOO_CANVAS_ITEM_SIMPLE_CLASS (klass);
+  static const guint8 *state_icons[] = {
+    off_stock_image,
+    on_stock_image,
+    pause_stock_image,
+    play_stock_image
+  };
+
+  object_class->finalize = gst_editor_body_finalize;
+  object_class->set_property = gst_editor_body_set_property;
+  object_class->get_property = gst_editor_body_get_property;
+
+  simple_class->simple_update = gst_editor_body_update;
+  simple_class->simple_paint = gst_editor_body_paint;
+  simple_class->simple_is_item_at = gst_editor_body_is_item_at;
+
+  /* the same properties as GooCanvasRect, see gst_editor_item_repack() */
+  g_object_class_install_property (object_class, PROP_X,
+      g_param_spec_double ("x", "x", "x",
+          -G_MAXDOUBLE, G_MAXDOUBLE, 0., G_PARAM_READWRITE));
+  g_object_class_install_property (object_class, PROP_Y,
+      g_param_spec_double ("y", "y", "y",
+          -G_MAXDOUBLE, G_MAXDOUBLE, 0., G_PARAM_READWRITE));
+  g_object_class_install_property (object_class, PROP_WIDTH,
+      g_param_spec_double ("width", "width", "width",
+          0., G_MAXDOUBLE, 0., G_PARAM_READWRITE));
+  g_object_class_install_property (object_class, PROP_HEIGHT,
+      g_param_spec_double ("height", "height", "height",
+          0., G_MAXDOUBLE, 0., G_PARAM_READWRITE));
+  g_object_class_install_property (object_class, PROP_TITLE,
+      g_param_spec_string ("title", "title", "title",
+          NULL, G_PARAM_READWRITE));
+  g_object_class_install_property (object_class, PROP_SHOW_STATES,
+      g_param_spec_boolean ("show-states", "show-states",
+          "Whether to show the state icons", FALSE, G_PARAM_READWRITE));
+  g_object_class_install_property (object_class, PROP_STATE,
+      g_param_spec_int ("state", "state",
+          "Index of the current state's icon or -1", -1, 3, -1,
+          G_PARAM_READWRITE));
+  g_object_class_install_property (object_class, PROP_RESIZEABLE,
+      g_param_spec_boolean ("resizeable", "resizeable",
+          "Whether to show the resize box", FALSE, G_PARAM_READWRITE));
+  g_object_class_install_property (object_class, PROP_RESIZE_HIGHLIGHT,
+      g_param_spec_boolean ("resize-highlight", "resize-highlight",
+          "Whether the resize box is highlighted", FALSE, G_PARAM_READWRITE));
+
+  for (gint i = 0; i < 4; i++) {
+    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_inline (-1, state_icons[i],
+        FALSE, NULL);
+
+    klass->state_icons[i] = gdk_cairo_surface_create_from_pixbuf (pixbuf, 1,
+        NULL);
+    g_object_unref (pixbuf);
+  }
+  klass->font = pango_font_description_from_string ("Sans");
+}
+
+static void
+gst_editor_body_init (GstEditorBody * body)
+{
+  /* state boxes are 16.0 x 16.0 + 2 px for the border */
+  body->state_width = 18.0;
+  body->state_height = 18.0;
+  body->state = -1;
+}
+
+GooCanvasItem *
+gst_editor_body_new (GooCanvasItem * parent)
+{
+  GooCanvasItem *body = g_object_new (GST_TYPE_EDITOR_BODY, NULL);
+
+  if (parent) {
+    goo_canvas_item_add_child (parent, body, -1);
+    g_object_unref (body);
+  }
+
+  return body;
+}
+
+/*
+ * Gets the size of the title in user space, see
+ * gst_editor_item_resize().
+ */
+void
+gst_editor_body_get_title_size (GstEditorBody * body,
+    gdouble * width, gdouble * height)
+{
+  GooCanvas *canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (body));
+  PangoRectangle logical;
+  PangoLayout *layout;
+  cairo_t *cr;
+
+  *width = *height = 0.;
+  if (!canvas)
+    return;
+
+  cr = goo_canvas_create_cairo_context (canvas);
+  layout = gst_editor_body_create_layout (body, cr);
+  pango_layout_get_extents (layout, NULL, &logical);
+  *width = (gdouble) logical.width / PANGO_SCALE;
+  *height = (gdouble) logical.height / PANGO_SCALE;
+  g_object_unref (layout);
+  cairo_destroy (cr);
+}
+
+/*
+ * Finds the part of body at x, y (in body's coordinates).
+ * Only the parts that are currently painted are returned.
+ */
+GstEditorBodyPart
+gst_editor_body_get_part (GstEditorBody * body, gdouble x, gdouble y)
+{
+  gint i;
+
+  g_return_val_if_fail (GST_IS_EDITOR_BODY (body), GST_EDITOR_BODY_PART_BOX);
+
+  if (!gst_editor_body_is_detailed (body))
+    return GST_EDITOR_BODY_PART_BOX;
+
+  x -= body->x;
+  y -= body->y;
+
+  if (body->resizeable &&
+      x >= body->width - RESIZE_SIZE && y >= body->height - RESIZE_SIZE)
+    return GST_EDITOR_BODY_PART_RESIZE;
+
+  if (body->show_states && x >= 0. && y >= body->height - body->state_height) {
+    i = (gint) (x / body->state_width);
+    if (i < 4)
+      return GST_EDITOR_BODY_PART_STATE + i;
+  }
+
+  return GST_EDITOR_BODY_PART_BOX;
+}
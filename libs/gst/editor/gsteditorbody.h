@@ -0,0 +1,83 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef __GST_EDITOR_BODY_H__
+#define __GST_EDITOR_BODY_H__
+
+#include <gtk/gtk.h>
+#include <goocanvas.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_EDITOR_BODY (gst_editor_body_get_type())
+#define GST_EDITOR_BODY(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_EDITOR_BODY, GstEditorBody))
+#define GST_IS_EDITOR_BODY(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_EDITOR_BODY))
+#define GST_EDITOR_BODY_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), GST_TYPE_EDITOR_BODY, GstEditorBodyClass))
+
+/*
+ * Parts of a GstEditorBody as returned by gst_editor_body_get_part().
+ * The state icons are GST_EDITOR_BODY_PART_STATE + 0..3.
+ */
+typedef enum
+{
+  GST_EDITOR_BODY_PART_BOX,
+  GST_EDITOR_BODY_PART_RESIZE,
+  GST_EDITOR_BODY_PART_STATE
+} GstEditorBodyPart;
+
+/*
+ * The compact rendering of a GstEditorElement (see the "compact"
+ * property of GstEditorCanvas): a single canvas item painting the
+ * border, title, state icons and resize box that otherwise are
+ * separate canvas items. The fill, stroke and line width are the
+ * GooCanvasItemSimple style properties.
+ */
+typedef struct _GstEditorBody
+{
+  GooCanvasItemSimple simple;
+
+  gdouble x, y, width, height;
+  gchar *title;
+
+  gdouble state_width, state_height;	/* size of a state icon's box */
+  gboolean show_states;
+  gint state;			/* the current state's icon or -1 */
+
+  gboolean resizeable;
+  gboolean resize_highlight;
+} GstEditorBody;
+
+typedef struct _GstEditorBodyClass
+{
+  GooCanvasItemSimpleClass parent_class;
+
+  /* shared by all instances */
+  cairo_surface_t *state_icons[4];
+  PangoFontDescription *font;
+} GstEditorBodyClass;
+
+GType gst_editor_body_get_type (void);
+GooCanvasItem *gst_editor_body_new (GooCanvasItem * parent);
+
+void gst_editor_body_get_title_size (GstEditorBody * body,
+    gdouble * width, gdouble * height);
+GstEditorBodyPart gst_editor_body_get_part (GstEditorBody * body,
+    gdouble x, gdouble y);
+
+G_END_DECLS
+
+#endif /* __GST_EDITOR_BODY_H__ */
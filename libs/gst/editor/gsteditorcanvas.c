@@ -20,10 +20,14 @@
 #include "config.h"
 #endif
 
+#include <math.h>
+
 #include <gst/gst.h>
 #include <gtk/gtk.h>
 
 #include <gst/common/gste-debug.h>
+#include <gst/common/gste-metadata.h>
+#include <gst/common/gste-placeholder.h>
 
 #include "gst-helper.h"
 #include "gsteditorproperty.h"
@@ -31,7 +35,16 @@
 #include "gsteditorelement.h"
 #include "gsteditorbin.h"
 #include "gsteditoritem.h"
+#include "gsteditorlink.h"
 #include "gsteditorcanvas.h"
+#include "gsteditorpadindex.h"
+#include "gsteditorcapscache.h"
+#include "gsteditordispatch.h"
+
+/* zoom limits and the zoom factor of one mouse wheel step */
+#define MIN_SCALE 0.05
+#define MAX_SCALE 4.0
+#define SCROLL_ZOOM_STEP 1.25
 
 /* signals and args */
 enum
@@ -49,7 +62,10 @@ enum
   PROP_STATUS,
   PROP_LIVE,
   PROP_SHOW_ALL_BINS,
-  PROP_AUTOSIZE
+  PROP_AUTOSIZE,
+  PROP_STRUCTURE_ONLY,
+  PROP_COMPACT,
+  PROP_STATE_SUMMARY
 };
 
 static void gst_editor_canvas_class_init (GstEditorCanvasClass * klass);
@@ -64,9 +80,15 @@ static void gst_editor_canvas_dispose (GObject * object);
 static void gst_editor_canvas_size_allocate (GtkWidget * widget,
     GtkAllocation * allocation);
 static void gst_editor_canvas_grab_notify (GtkWidget * widget, gboolean was_grabbed);
+static gboolean gst_editor_canvas_scroll_event (GtkWidget * widget,
+    GdkEventScroll * event);
 
 static void on_palette_destroyed (GstEditorCanvas * canvas,
     gpointer stale_pointer);
+static gboolean gst_editor_canvas_instantiate_cb (gpointer user_data);
+static void gst_editor_canvas_counted_element_gone (gpointer data,
+    GObject * element);
+static void gst_editor_canvas_queue_flush_states (GstEditorCanvas * canvas);
 
 static void gst_editor_canvas_element_connect (GstEditorCanvas * canvas,
     GstElement * pipeline);
@@ -111,6 +133,9 @@ gst_editor_canvas_class_init (GstEditorCanvasClass * klass)
   object_class->get_property = gst_editor_canvas_get_property;
   object_class->dispose = gst_editor_canvas_dispose;
 
+  /* canvases are created in the main thread */
+  gst_editor_dispatch_init ();
+
   g_object_class_install_property (object_class, PROP_ATTRIBUTES,
       g_param_spec_pointer ("attributes", "attributes", "attributes",
           G_PARAM_READWRITE));
@@ -152,17 +177,38 @@ gst_editor_canvas_class_init (GstEditorCanvasClass * klass)
       g_param_spec_boolean ("autosize", "autosize",
           "Whether to autosize the canvas", TRUE,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
+  g_object_class_install_property (object_class, PROP_STRUCTURE_ONLY,
+      g_param_spec_boolean ("structure-only", "structure-only",
+          "Whether loaded elements are only instantiated when needed",
+          FALSE, G_PARAM_READWRITE));
+  g_object_class_install_property (object_class, PROP_COMPACT,
+      g_param_spec_boolean ("compact", "compact",
+          "Whether new elements are painted by a single canvas item",
+          FALSE, G_PARAM_READWRITE));
+  g_object_class_install_property (object_class, PROP_STATE_SUMMARY,
+      g_param_spec_string ("state-summary", "state-summary",
+          "How many elements are in which state", "", G_PARAM_READABLE));
 
   widget_class->size_allocate = gst_editor_canvas_size_allocate;
   widget_class->grab_notify = gst_editor_canvas_grab_notify;
+  widget_class->scroll_event = gst_editor_canvas_scroll_event;
 }
 
 static void
 gst_editor_canvas_init (GstEditorCanvas * editorcanvas)
 {
   g_rw_lock_init (&editorcanvas->globallock);
-
-  g_datalist_init (&editorcanvas->attributes);
+  editorcanvas->detailed = TRUE;
+
+  editorcanvas->attributes = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, g_free);
+  editorcanvas->moved = g_hash_table_new_full (NULL, NULL, g_object_unref,
+      NULL);
+  editorcanvas->stale_states = g_hash_table_new_full (NULL, NULL,
+      g_object_unref, NULL);
+  editorcanvas->counted = g_hash_table_new (NULL, NULL);
+  editorcanvas->state_summary = g_strdup ("");
+  editorcanvas->dirty = g_hash_table_new (NULL, NULL);
 
   editorcanvas->property =
       GST_EDITOR_PROPERTY (g_object_new (GST_TYPE_EDITOR_PROPERTY, NULL));
@@ -179,8 +225,9 @@ gst_editor_canvas_size_allocate (GtkWidget * widget, GtkAllocation * allocation)
   GstEditorCanvas *canvas = GST_EDITOR_CANVAS (widget);
 
   if (canvas->bin) {
-    width = allocation->width;
-    height = allocation->height;
+    /* in canvas units */
+    width = allocation->width / goo_canvas_get_scale (GOO_CANVAS (canvas));
+    height = allocation->height / goo_canvas_get_scale (GOO_CANVAS (canvas));
     if (canvas->autosize) {
       g_object_set (
           canvas->bin, "width", width - 8, "height", height - 8, NULL);
@@ -231,6 +278,36 @@ gst_editor_canvas_grab_notify (GtkWidget * widget, gboolean was_grabbed)
     GTK_WIDGET_CLASS (parent_class)->grab_notify (widget, was_grabbed);
 }
 
+static gboolean
+gst_editor_canvas_scroll_event (GtkWidget * widget, GdkEventScroll * event)
+{
+  GstEditorCanvas *canvas = GST_EDITOR_CANVAS (widget);
+  gdouble scale = goo_canvas_get_scale (GOO_CANVAS (canvas));
+  gdouble dx, dy;
+
+  /* Ctrl+wheel zooms, everything else scrolls */
+  if (!(event->state & GDK_CONTROL_MASK))
+    return GTK_WIDGET_CLASS (parent_class)->scroll_event (widget, event);
+
+  switch (event->direction) {
+    case GDK_SCROLL_UP:
+      scale *= SCROLL_ZOOM_STEP;
+      break;
+    case GDK_SCROLL_DOWN:
+      scale /= SCROLL_ZOOM_STEP;
+      break;
+    case GDK_SCROLL_SMOOTH:
+      gdk_event_get_scroll_deltas ((GdkEvent *) event, &dx, &dy);
+      scale *= pow (SCROLL_ZOOM_STEP, -dy);
+      break;
+    default:
+      return FALSE;
+  }
+
+  gst_editor_canvas_set_zoom (canvas, scale);
+  return TRUE;
+}
+
 static void
 gst_editor_canvas_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -246,9 +323,17 @@ gst_editor_canvas_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_ATTRIBUTES:
-      g_datalist_clear (&canvas->attributes);
-      canvas->attributes = (GData *) g_value_get_pointer (value);
+      g_hash_table_unref (canvas->attributes);
+      /* an unset property stands for no attributes */
+      if (g_value_get_pointer (value))
+        canvas->attributes = g_hash_table_ref (g_value_get_pointer (value));
+      else
+        canvas->attributes = g_hash_table_new_full (g_str_hash, g_str_equal,
+            g_free, g_free);
       EDITOR_DEBUG ("canvas_set_prop: attributesp: %p", canvas->attributes);
+      if (canvas->bin)
+        g_object_set (G_OBJECT (canvas->bin), "attributes", canvas->attributes,
+            NULL);
       break;
     case PROP_BIN:
       gtk_widget_get_allocation (GTK_WIDGET (object), &allocation);
@@ -258,7 +343,7 @@ gst_editor_canvas_set_property (GObject * object, guint prop_id,
             GOO_CANVAS_ITEM (goo_canvas_get_root_item (GOO_CANVAS (canvas))),
             gst_editor_bin_get_type (),
             "globallock", &canvas->globallock,
-            "attributes", &canvas->attributes,
+            "attributes", canvas->attributes,
             "width", (gdouble)allocation.width,
             "height", (gdouble)allocation.height,
             "object", g_value_get_object (value),
@@ -275,7 +360,7 @@ gst_editor_canvas_set_property (GObject * object, guint prop_id,
          */
         gst_bus_remove_signal_watch (gst_pipeline_get_bus (GST_PIPELINE (pipeline)));
 
-        g_object_set (G_OBJECT (canvas->bin), "attributes", &canvas->attributes,
+        g_object_set (G_OBJECT (canvas->bin), "attributes", canvas->attributes,
             "object", g_value_get_object (value), NULL);
         EDITOR_DEBUG (
             "replaced object on existing bin canvas and updated attributes");
@@ -321,6 +406,12 @@ gst_editor_canvas_set_property (GObject * object, guint prop_id,
         g_object_set (canvas->property, "element",
             GST_EDITOR_ITEM (canvas->selection)->object, NULL);
 
+        /* editing the properties requires the real element */
+        if (GSTE_IS_PLACEHOLDER (GST_EDITOR_ITEM (canvas->selection)->object) &&
+            !canvas->instantiate_id)
+          canvas->instantiate_id =
+              g_idle_add (gst_editor_canvas_instantiate_cb, canvas);
+
         /*
          * Update the PRIMARY selection clipboard.
          * TODO: Instead of always serializing the selected element, it is
@@ -411,6 +502,14 @@ gst_editor_canvas_set_property (GObject * object, guint prop_id,
       }
       break;
 
+    case PROP_STRUCTURE_ONLY:
+      canvas->structure_only = g_value_get_boolean (value);
+      break;
+
+    case PROP_COMPACT:
+      canvas->compact = g_value_get_boolean (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -453,6 +552,18 @@ gst_editor_canvas_get_property (GObject * object, guint prop_id, GValue * value,
       g_value_set_boolean (value, canvas->autosize);
       break;
 
+    case PROP_STRUCTURE_ONLY:
+      g_value_set_boolean (value, canvas->structure_only);
+      break;
+
+    case PROP_COMPACT:
+      g_value_set_boolean (value, canvas->compact);
+      break;
+
+    case PROP_STATE_SUMMARY:
+      g_value_set_string (value, canvas->state_summary);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -468,9 +579,88 @@ gst_editor_canvas_dispose (GObject * object)
   if (canvas->palette)
     g_object_unref (G_OBJECT (canvas->palette));
 
+  if (canvas->instantiate_id) {
+    g_source_remove (canvas->instantiate_id);
+    canvas->instantiate_id = 0;
+  }
+
+  /* the deferred children reference their bins */
+  gst_editor_canvas_set_progressive (canvas, FALSE);
+  g_clear_pointer (&canvas->attributes, g_hash_table_unref);
+
+  if (canvas->moved_tick_id) {
+    gtk_widget_remove_tick_callback (GTK_WIDGET (canvas),
+        canvas->moved_tick_id);
+    canvas->moved_tick_id = 0;
+  }
+  g_clear_pointer (&canvas->moved, g_hash_table_unref);
+
+  if (canvas->stale_states_tick_id) {
+    gtk_widget_remove_tick_callback (GTK_WIDGET (canvas),
+        canvas->stale_states_tick_id);
+    canvas->stale_states_tick_id = 0;
+  }
+  g_clear_pointer (&canvas->stale_states, g_hash_table_unref);
+  if (canvas->counted) {
+    GHashTableIter iter;
+    gpointer element;
+
+    g_hash_table_iter_init (&iter, canvas->counted);
+    while (g_hash_table_iter_next (&iter, &element, NULL))
+      g_object_weak_unref (G_OBJECT (element),
+          gst_editor_canvas_counted_element_gone, canvas);
+    g_clear_pointer (&canvas->counted, g_hash_table_unref);
+  }
+  g_clear_pointer (&canvas->state_summary, g_free);
+  if (canvas->dirty)
+    g_hash_table_unref (gst_editor_canvas_steal_dirty (canvas));
+  g_clear_pointer (&canvas->dirty, g_hash_table_unref);
+  g_clear_pointer (&canvas->pad_index, gst_editor_pad_index_free);
+  /* running jobs keep the cache until they are done */
+  gst_editor_caps_cache_invalidate (canvas);
+  g_clear_pointer (&canvas->caps_cache, gst_editor_caps_cache_unref);
+
   g_rw_lock_clear (&canvas->globallock);
 }
 
+/*
+ * Instantiates the selected placeholder, so its properties can be
+ * edited. This cannot be done while selecting it, since the
+ * selected item is replaced.
+ */
+static gboolean
+gst_editor_canvas_instantiate_cb (gpointer user_data)
+{
+  GstEditorCanvas *canvas = GST_EDITOR_CANVAS (user_data);
+  GstEditorElement *selection = canvas->selection;
+  GstElement *element;
+  GError *error = NULL;
+
+  canvas->instantiate_id = 0;
+
+  if (!selection ||
+      !GSTE_IS_PLACEHOLDER (GST_EDITOR_ITEM (selection)->object))
+    return G_SOURCE_REMOVE;
+
+  g_object_set (canvas, "selection", NULL, NULL);
+
+  element = gst_editor_element_instantiate (selection, &error);
+  if (!element) {
+    gchar *status = g_strdup_printf ("Could not instantiate %s: %s",
+        GST_OBJECT_NAME (GST_EDITOR_ITEM (selection)->object), error->message);
+
+    g_object_set (canvas, "status", status, NULL);
+    g_free (status);
+    g_error_free (error);
+    /* selecting it again would retry */
+    return G_SOURCE_REMOVE;
+  }
+
+  g_object_set (canvas, "selection",
+      gst_editor_item_get (GST_OBJECT (element)), NULL);
+  return G_SOURCE_REMOVE;
+}
+
 static void
 on_palette_destroyed (GstEditorCanvas * canvas, gpointer stale_pointer)
 {
@@ -484,6 +674,8 @@ on_palette_destroyed (GstEditorCanvas * canvas, gpointer stale_pointer)
 static void
 gst_editor_canvas_pipeline_message (GstBus * bus, GstMessage * message, gpointer data)
 {
+  GstEditorCanvas *canvas = GST_EDITOR_CANVAS (data);
+
   switch (GST_MESSAGE_TYPE (message)) {
     case GST_MESSAGE_STATE_CHANGED:
     {
@@ -491,9 +683,10 @@ gst_editor_canvas_pipeline_message (GstBus * bus, GstMessage * message, gpointer
 
       if (GST_IS_ELEMENT (obj)) {
         GstEditorItem *item = gst_editor_item_get (obj);
-        //g_print("adding idle function in main bus watcher");
-        g_idle_add ((GSourceFunc) gst_editor_element_sync_state,
-            item /*editor_element */ );
+
+        if (GST_IS_EDITOR_ELEMENT (item))
+          gst_editor_canvas_queue_sync_state (canvas,
+              GST_EDITOR_ELEMENT (item));
       }
       break;
     }
@@ -505,10 +698,11 @@ gst_editor_canvas_pipeline_message (GstBus * bus, GstMessage * message, gpointer
       if (GST_IS_ELEMENT (obj)) {
         gst_element_set_state (GST_ELEMENT_CAST (obj), GST_STATE_NULL);
         GstEditorItem * item = gst_editor_item_get (obj);
-        // g_print("adding idle function in main bus watcher");
-        gst_editor_element_stop_child (GST_EDITOR_ELEMENT (item));
-        g_idle_add ((GSourceFunc)gst_editor_element_sync_state,
-            item /*editor_element */);
+
+        if (GST_IS_EDITOR_ELEMENT (item)) {
+          /* also queues the state of item */
+          gst_editor_element_stop_child (GST_EDITOR_ELEMENT (item));
+        }
       }
     }
     default:
@@ -535,7 +729,8 @@ gst_editor_canvas_element_connect (GstEditorCanvas * canvas, GstElement * pipeli
 }
 
 static gboolean
-parse_key_file_metadata (GKeyFile * key_file, GData ** datalistp, GError ** parent_error)
+parse_key_file_metadata (GKeyFile * key_file, GHashTable * attributes,
+    GError ** parent_error)
 {
   GError *error = NULL;
   gchar **group_names = g_key_file_get_groups (key_file, NULL);
@@ -574,8 +769,8 @@ parse_key_file_metadata (GKeyFile * key_file, GData ** datalistp, GError ** pare
     g_debug ("loaded %s with x: %f, y: %f, w: %f, h: %f",
         element_name, attr->x, attr->y, attr->w, attr->h);
 
-    /* save this in the datalist with the object's name as key */
-    g_datalist_set_data_full (datalistp, element_name, attr, g_free);
+    /* save this in the table with the object's name as key */
+    g_hash_table_insert (attributes, g_strdup (element_name), attr);
   }
 
   g_strfreev (group_names);
@@ -587,13 +782,68 @@ propagate_error:
   return FALSE;
 }
 
-gboolean
-gst_editor_canvas_load_with_metadata (GstEditorCanvas * canvas,
-    GKeyFile * key_file, GError ** error)
+/*
+ * Loads the metadata of large pipelines from their binary sidecar
+ * (see gste-metadata.h). The records are not parsed, so this is
+ * considerably faster than parse_key_file_metadata().
+ */
+static gboolean
+parse_sidecar_metadata (const gchar * filename, guint32 stamp,
+    GHashTable * attributes, GError ** error)
 {
-  gchar *str;
-  GstElement *pipeline;
-  GstEditorItemAttr *attr;
+  GsteMetadata *metadata = gste_metadata_open (filename, stamp, error);
+  guint n_records;
+
+  if (!metadata)
+    return FALSE;
+
+  n_records = gste_metadata_get_n_records (metadata);
+  for (guint i = 0; i < n_records; i++) {
+    GstEditorItemAttr *attr = g_new (GstEditorItemAttr, 1);
+    GsteLayoutBox box;
+    const gchar *element_name = gste_metadata_get_record (metadata, i, &box);
+
+    attr->x = box.x;
+    attr->y = box.y;
+    attr->w = box.width;
+    attr->h = box.height;
+    g_hash_table_insert (attributes, g_strdup (element_name), attr);
+  }
+
+  gste_metadata_free (metadata);
+  return TRUE;
+}
+
+static guint
+count_elements (GstBin * bin)
+{
+  guint n = 0;
+
+  for (GList *l = bin->children; l; l = g_list_next (l)) {
+    n++;
+    if (GST_IS_BIN (l->data))
+      n += count_elements (GST_BIN (l->data));
+  }
+
+  return n;
+}
+
+/*
+ * Parses a save file without touching any canvas, so it can be
+ * called from any thread.
+ * If structure_only is set, elements are loaded as placeholders
+ * (see gste-placeholder.h) that are instantiated when needed.
+ * filename is the name key_file was loaded from and is used to find
+ * the layout sidecar of large pipelines. It may be NULL.
+ */
+GstEditorCanvasLoad *
+gst_editor_canvas_load_parse (GKeyFile * key_file, const gchar * filename,
+    gboolean structure_only, GError ** error)
+{
+  GstEditorCanvasLoad *load;
+  gchar *str, *layout;
+  guint32 stamp;
+  GstElement *pipeline = NULL;
 
   /*
    * Check the save file version.
@@ -605,7 +855,7 @@ gst_editor_canvas_load_with_metadata (GstEditorCanvas * canvas,
     g_set_error (error, GST_EDITOR_CANVAS_ERROR, GST_EDITOR_CANVAS_ERROR_FAILED,
         "Unsupported save file version %s", str);
     g_free (str);
-    return FALSE;
+    return NULL;
   }
   g_free (str);
 
@@ -616,7 +866,7 @@ gst_editor_canvas_load_with_metadata (GstEditorCanvas * canvas,
   if (!str) {
     g_set_error (error, GST_EDITOR_CANVAS_ERROR, GST_EDITOR_CANVAS_ERROR_FAILED,
         "Missing %s/Pipeline in save file", PACKAGE_NAME);
-    return FALSE;
+    return NULL;
   }
   /*
    * We use strict parsing here, since the pipeline
@@ -624,37 +874,88 @@ gst_editor_canvas_load_with_metadata (GstEditorCanvas * canvas,
    * GsteSerialize should never produce faulty pipelines.
    * Otherwise GsteSerialize should be fixed instead.
    */
-  pipeline = gst_parse_launch_full (str, NULL, GST_PARSE_FLAG_FATAL_ERRORS, error);
+  if (structure_only) {
+    GError *structure_error = NULL;
+
+    pipeline = gste_placeholder_parse_launch (str, &structure_error);
+    if (!pipeline) {
+      EDITOR_DEBUG ("instantiating all elements: %s", structure_error->message);
+      g_error_free (structure_error);
+    }
+  }
+  if (!pipeline)
+    pipeline = gst_parse_launch_full (str, NULL, GST_PARSE_FLAG_FATAL_ERRORS,
+        error);
+  stamp = gste_metadata_stamp (str);
   g_free (str);
   if (!pipeline)
     /* forward error */
-    return FALSE;
+    return NULL;
 
-  /*
-   * This properly frees all the elements.
-   */
-  g_datalist_clear (&canvas->attributes);
+  load = g_new0 (GstEditorCanvasLoad, 1);
+  load->pipeline = pipeline;
+  load->attributes = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, g_free);
+  if (GST_IS_BIN (pipeline))
+    load->n_elements = count_elements (GST_BIN (pipeline));
 
   /*
-   * Parse the meta data into a GDatalist.
-   * FIXME: It would be nice to avoid this.
-   * At least it should be possible to use the data list that
-   * GObjects include anyway.
+   * Parse the meta data into the attributes table.
+   * It is shared with all GstEditorBins, which look up (and remove)
+   * the attributes of every element added to them.
    */
-  if (!parse_key_file_metadata (key_file, &canvas->attributes, error)) {
+  layout = g_key_file_get_string (key_file, PACKAGE_NAME, "Layout", NULL);
+  if (layout && filename) {
+    GError *sidecar_error = NULL;
+    gchar *dirname = g_path_get_dirname (filename);
+    gchar *sidecar_name = g_build_filename (dirname, layout, NULL);
+
+    /* the pipeline is still usable with default positions */
+    if (!parse_sidecar_metadata (sidecar_name, stamp, load->attributes,
+            &sidecar_error)) {
+      g_warning ("Error loading layout: %s", sidecar_error->message);
+      g_error_free (sidecar_error);
+    }
+    g_free (sidecar_name);
+    g_free (dirname);
+  } else if (!parse_key_file_metadata (key_file, load->attributes, error)) {
+    g_free (layout);
+    gst_editor_canvas_load_free (load);
     g_prefix_error (error, "Error parsing save file's metadata: ");
-    return FALSE;
+    return NULL;
   }
+  g_free (layout);
+
+  load->autosize = g_key_file_get_boolean (key_file, PACKAGE_NAME,
+      "Autosize", NULL);
+
+  return load;
+}
+
+/*
+ * Replaces the canvas' pipeline with the one of load.
+ * Takes over load->pipeline.
+ */
+void
+gst_editor_canvas_load_apply (GstEditorCanvas * canvas,
+    GstEditorCanvasLoad * load)
+{
+  GstElement *pipeline = load->pipeline;
+  GstEditorItemAttr *attr;
+
+  g_return_if_fail (pipeline != NULL);
+  load->pipeline = NULL;
 
   //first unref all the old stuff
   if (gst_editor_canvas_get_pipeline (canvas))
     g_object_unref (gst_editor_canvas_get_pipeline (canvas));
 
+  g_object_set (canvas, "attributes", load->attributes, NULL);
   EDITOR_DEBUG ("loaded: attributes: %p", canvas->attributes);
 
   g_object_set (canvas, "bin", pipeline, NULL);
 
-  attr = g_datalist_get_data (&canvas->attributes, GST_ELEMENT_NAME (pipeline));
+  attr = g_hash_table_lookup (canvas->attributes, GST_ELEMENT_NAME (pipeline));
   /* now decide */
   if (attr) {
     canvas->widthbackup = attr->w;
@@ -663,8 +964,35 @@ gst_editor_canvas_load_with_metadata (GstEditorCanvas * canvas,
     g_warning ("Element attributes for %s not found!", GST_ELEMENT_NAME (pipeline));
   }
 
-  g_object_set (canvas, "autosize",
-      g_key_file_get_boolean (key_file, PACKAGE_NAME, "Autosize", NULL), NULL);
+  g_object_set (canvas, "autosize", load->autosize, NULL);
+}
+
+void
+gst_editor_canvas_load_free (GstEditorCanvasLoad * load)
+{
+  if (load->pipeline)
+    gst_object_unref (load->pipeline);
+  g_hash_table_unref (load->attributes);
+  g_free (load);
+}
+
+/*
+ * filename is the name key_file was loaded from and is used to find
+ * the layout sidecar of large pipelines. It may be NULL.
+ */
+gboolean
+gst_editor_canvas_load_with_metadata (GstEditorCanvas * canvas,
+    GKeyFile * key_file, const gchar * filename, GError ** error)
+{
+  GstEditorCanvasLoad *load;
+
+  load = gst_editor_canvas_load_parse (key_file, filename,
+      canvas->structure_only, error);
+  if (!load)
+    return FALSE;
+
+  gst_editor_canvas_load_apply (canvas, load);
+  gst_editor_canvas_load_free (load);
 
   return TRUE;
 }
@@ -698,3 +1026,505 @@ gst_editor_canvas_get_selected_bin (GstEditorCanvas * canvas, GError ** error)
 
   return selected_bin;
 }
+
+/*
+ * Like gst_editor_bin_freeze(), but for all bins of the canvas,
+ * including bins created while the canvas is frozen, e.g. when
+ * setting a new pipeline.
+ */
+void
+gst_editor_canvas_freeze (GstEditorCanvas * canvas)
+{
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+
+  canvas->freeze_count++;
+}
+
+void
+gst_editor_canvas_thaw (GstEditorCanvas * canvas)
+{
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+  g_return_if_fail (canvas->freeze_count > 0);
+
+  if (--canvas->freeze_count == 0 && canvas->bin)
+    gst_editor_bin_flush (canvas->bin);
+}
+
+/**********************************************************************
+ * Zoom
+ **********************************************************************/
+
+static void
+gst_editor_canvas_set_links_detailed (GstEditorBin * bin, gboolean detailed)
+{
+  GHashTableIter iter;
+  gpointer link;
+
+  g_hash_table_iter_init (&iter, bin->links);
+  while (g_hash_table_iter_next (&iter, &link, NULL))
+    gst_editor_link_set_detailed (GST_EDITOR_LINK (link), detailed);
+
+  for (guint i = 0; i < bin->sort.len; i++)
+    if (GST_IS_EDITOR_BIN (bin->sort.elements[i]))
+      gst_editor_canvas_set_links_detailed (
+          GST_EDITOR_BIN (bin->sort.elements[i]), detailed);
+}
+
+/*
+ * Sets the zoom factor of canvas.
+ * Crossing GST_EDITOR_CANVAS_DETAIL_SCALE switches the level of detail.
+ * GooCanvas itself skips painting and picking the element and pad
+ * details (see gst_editor_item_set_detail()), but the links have to be
+ * restyled.
+ */
+void
+gst_editor_canvas_set_zoom (GstEditorCanvas * canvas, gdouble scale)
+{
+  gboolean detailed;
+
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+
+  scale = CLAMP (scale, MIN_SCALE, MAX_SCALE);
+  goo_canvas_set_scale (GOO_CANVAS (canvas), scale);
+
+  detailed = scale >= GST_EDITOR_CANVAS_DETAIL_SCALE;
+  if (detailed != canvas->detailed) {
+    EDITOR_DEBUG ("canvas: switching to %s drawing at scale %f",
+        detailed ? "detailed" : "simplified", scale);
+    canvas->detailed = detailed;
+    if (canvas->bin)
+      gst_editor_canvas_set_links_detailed (canvas->bin, detailed);
+  }
+
+  /* the bin fills the visible area */
+  if (canvas->autosize)
+    gtk_widget_queue_resize (GTK_WIDGET (canvas));
+}
+
+/**********************************************************************
+ * Position updates
+ **********************************************************************/
+
+/*
+ * Emits position-changed on a moved item and on its pads, whose links
+ * follow them. The links between the children of a bin are painted in
+ * the bin's coordinate space (see gsteditorlinklayer.c), so they need
+ * not be updated when the bin moves, and neither do the children.
+ * The pads of the item and its children are moved in the pad index.
+ */
+static void
+gst_editor_canvas_item_moved (GstEditorCanvas * canvas, GstEditorItem * item)
+{
+  static guint position_changed = 0;
+  GQueue *pads[2];
+
+  if (!position_changed)
+    position_changed = g_signal_lookup ("position-changed",
+        GST_TYPE_EDITOR_ITEM);
+
+  g_signal_emit (item, position_changed, 0);
+  if (!GST_IS_EDITOR_ELEMENT (item))
+    return;
+
+  gst_editor_pad_index_update (canvas, GST_EDITOR_ELEMENT (item));
+
+  pads[0] = &GST_EDITOR_ELEMENT (item)->srcpads;
+  pads[1] = &GST_EDITOR_ELEMENT (item)->sinkpads;
+  for (guint i = 0; i < G_N_ELEMENTS (pads); i++)
+    for (GList * l = pads[i]->head; l; l = l->next)
+      g_signal_emit (l->data, position_changed, 0);
+}
+
+static gboolean
+gst_editor_canvas_moved_tick_cb (GtkWidget * widget,
+    GdkFrameClock * frame_clock, gpointer user_data)
+{
+  GstEditorCanvas *canvas = GST_EDITOR_CANVAS (widget);
+
+  canvas->moved_tick_id = 0;
+  gst_editor_canvas_flush_moves (canvas);
+
+  return G_SOURCE_REMOVE;
+}
+
+/*
+ * Notes that item has been moved. Dragging or laying out elements moves
+ * them many times per frame, but their links are only updated once,
+ * before the next frame is painted.
+ */
+void
+gst_editor_canvas_queue_move (GstEditorCanvas * canvas, GstEditorItem * item)
+{
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+  g_return_if_fail (GST_IS_EDITOR_ITEM (item));
+
+  /* there are no frames yet */
+  if (!gtk_widget_get_realized (GTK_WIDGET (canvas))) {
+    gst_editor_canvas_item_moved (canvas, item);
+    return;
+  }
+
+  if (g_hash_table_contains (canvas->moved, item))
+    return;
+
+  g_hash_table_add (canvas->moved, g_object_ref (item));
+  if (!canvas->moved_tick_id)
+    canvas->moved_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (canvas),
+        gst_editor_canvas_moved_tick_cb, NULL, NULL);
+}
+
+/* Updates the links of all moved items now. */
+void
+gst_editor_canvas_flush_moves (GstEditorCanvas * canvas)
+{
+  GHashTable *moved;
+  GHashTableIter iter;
+  gpointer item;
+
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+
+  if (canvas->moved_tick_id) {
+    gtk_widget_remove_tick_callback (GTK_WIDGET (canvas),
+        canvas->moved_tick_id);
+    canvas->moved_tick_id = 0;
+  }
+
+  /* items moved by the handlers are queued for the next frame */
+  moved = canvas->moved;
+  canvas->moved = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+
+  g_hash_table_iter_init (&iter, moved);
+  while (g_hash_table_iter_next (&iter, &item, NULL)) {
+    /* removed in the meantime */
+    if (!goo_canvas_item_get_parent (GOO_CANVAS_ITEM (item)) ||
+        !GST_EDITOR_ITEM (item)->object)
+      continue;
+
+    gst_editor_canvas_item_moved (canvas, GST_EDITOR_ITEM (item));
+  }
+  g_hash_table_unref (moved);
+}
+
+/**********************************************************************
+ * State updates
+ **********************************************************************/
+
+/*
+ * The counted state of an element is kept packed into a pointer,
+ * state + 1 (so it is never NULL) with COUNTED_PENDING or'ed in while
+ * the element is changing state.
+ */
+#define COUNTED_PENDING 0x100
+
+static void
+gst_editor_canvas_uncount (GstEditorCanvas * canvas, guint counted)
+{
+  guint state = (counted & ~COUNTED_PENDING) - 1;
+
+  if (state <= GST_STATE_PLAYING)
+    canvas->n_states[state]--;
+  if (counted & COUNTED_PENDING)
+    canvas->n_pending--;
+  canvas->counts_changed = TRUE;
+}
+
+static void
+gst_editor_canvas_counted_element_gone (gpointer data, GObject * element)
+{
+  GstEditorCanvas *canvas = GST_EDITOR_CANVAS (data);
+  gpointer counted;
+
+  if (!g_hash_table_steal_extended (canvas->counted, element, NULL, &counted))
+    return;
+
+  gst_editor_canvas_uncount (canvas, GPOINTER_TO_UINT (counted));
+  gst_editor_canvas_queue_flush_states (canvas);
+}
+
+/*
+ * Updates the number of elements in each state for the current state
+ * of element. Only the elements inside the bins are counted, not the
+ * pipeline itself, and an element is counted until it is destroyed,
+ * so the summary never has to walk the element tree.
+ */
+void
+gst_editor_canvas_count_state (GstEditorCanvas * canvas,
+    GstEditorElement * element)
+{
+  GstObject *object;
+  GooCanvasItem *parent;
+  GstState state, pending;
+  gpointer old;
+  guint counted;
+
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+  g_return_if_fail (GST_IS_EDITOR_ELEMENT (element));
+
+  object = GST_EDITOR_ITEM (element)->object;
+  parent = goo_canvas_item_get_parent (GOO_CANVAS_ITEM (element));
+  if (!GST_IS_ELEMENT (object) || !GST_IS_EDITOR_BIN (parent))
+    return;
+
+  GST_OBJECT_LOCK (object);
+  state = GST_STATE (object);
+  pending = GST_STATE_PENDING (object);
+  GST_OBJECT_UNLOCK (object);
+
+  counted = state + 1;
+  if (pending != GST_STATE_VOID_PENDING)
+    counted |= COUNTED_PENDING;
+
+  if (g_hash_table_lookup_extended (canvas->counted, element, NULL, &old)) {
+    if (GPOINTER_TO_UINT (old) == counted)
+      return;
+    gst_editor_canvas_uncount (canvas, GPOINTER_TO_UINT (old));
+  } else {
+    g_object_weak_ref (G_OBJECT (element),
+        gst_editor_canvas_counted_element_gone, canvas);
+  }
+
+  g_hash_table_insert (canvas->counted, element, GUINT_TO_POINTER (counted));
+  if (state <= GST_STATE_PLAYING)
+    canvas->n_states[state]++;
+  if (counted & COUNTED_PENDING)
+    canvas->n_pending++;
+  canvas->counts_changed = TRUE;
+  gst_editor_canvas_queue_flush_states (canvas);
+}
+
+static gboolean
+gst_editor_canvas_stale_states_tick_cb (GtkWidget * widget,
+    GdkFrameClock * frame_clock, gpointer user_data)
+{
+  GstEditorCanvas *canvas = GST_EDITOR_CANVAS (widget);
+
+  canvas->stale_states_tick_id = 0;
+  gst_editor_canvas_flush_states (canvas);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gst_editor_canvas_queue_flush_states (GstEditorCanvas * canvas)
+{
+  if (!canvas->stale_states_tick_id &&
+      gtk_widget_get_realized (GTK_WIDGET (canvas)))
+    canvas->stale_states_tick_id =
+        gtk_widget_add_tick_callback (GTK_WIDGET (canvas),
+        gst_editor_canvas_stale_states_tick_cb, NULL, NULL);
+}
+
+/*
+ * Notes that the state of element has changed. A state change of the
+ * pipeline posts a message for every element, but the state boxes are
+ * only updated once, before the next frame is painted.
+ */
+void
+gst_editor_canvas_queue_sync_state (GstEditorCanvas * canvas,
+    GstEditorElement * element)
+{
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+  g_return_if_fail (GST_IS_EDITOR_ELEMENT (element));
+
+  /* there are no frames yet */
+  if (!gtk_widget_get_realized (GTK_WIDGET (canvas))) {
+    gst_editor_element_sync_state (element);
+    gst_editor_canvas_count_state (canvas, element);
+    return;
+  }
+
+  if (g_hash_table_contains (canvas->stale_states, element))
+    return;
+
+  g_hash_table_add (canvas->stale_states, g_object_ref (element));
+  gst_editor_canvas_queue_flush_states (canvas);
+}
+
+/*
+ * Updates the state boxes of all queued elements now, and the
+ * "state-summary" if any element changed its state.
+ */
+void
+gst_editor_canvas_flush_states (GstEditorCanvas * canvas)
+{
+  GHashTable *stale;
+  GHashTableIter iter;
+  gpointer element;
+
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+
+  if (g_hash_table_size (canvas->stale_states)) {
+    stale = canvas->stale_states;
+    canvas->stale_states = g_hash_table_new_full (NULL, NULL, g_object_unref,
+        NULL);
+
+    g_hash_table_iter_init (&iter, stale);
+    while (g_hash_table_iter_next (&iter, &element, NULL)) {
+      /* removed in the meantime */
+      if (!goo_canvas_item_get_parent (GOO_CANVAS_ITEM (element)) ||
+          !GST_EDITOR_ITEM (element)->object)
+        continue;
+
+      gst_editor_element_sync_state (GST_EDITOR_ELEMENT (element));
+      gst_editor_canvas_count_state (canvas, GST_EDITOR_ELEMENT (element));
+    }
+    EDITOR_LOG ("canvas: synced the states of %u elements",
+        g_hash_table_size (stale));
+    g_hash_table_unref (stale);
+  }
+
+  /* including the one counting the states above has queued */
+  if (canvas->stale_states_tick_id) {
+    gtk_widget_remove_tick_callback (GTK_WIDGET (canvas),
+        canvas->stale_states_tick_id);
+    canvas->stale_states_tick_id = 0;
+  }
+
+  if (!canvas->counts_changed)
+    return;
+
+  canvas->counts_changed = FALSE;
+  g_free (canvas->state_summary);
+  canvas->state_summary = g_strdup_printf ("%u elements: %u playing, "
+      "%u paused, %u ready, %u stopped, %u changing state",
+      g_hash_table_size (canvas->counted),
+      canvas->n_states[GST_STATE_PLAYING], canvas->n_states[GST_STATE_PAUSED],
+      canvas->n_states[GST_STATE_READY], canvas->n_states[GST_STATE_NULL],
+      canvas->n_pending);
+  g_object_notify (G_OBJECT (canvas), "state-summary");
+}
+
+/**********************************************************************
+ * Unsaved layout changes
+ **********************************************************************/
+
+static void
+gst_editor_canvas_dirty_item_gone (gpointer data, GObject * item)
+{
+  GstEditorCanvas *canvas = GST_EDITOR_CANVAS (data);
+
+  g_hash_table_remove (canvas->dirty, item);
+}
+
+/*
+ * Notes that item has been moved, resized or renamed since its
+ * metadata was last saved, so saving does not have to look at the
+ * other elements (see gsteditorautosave.c).
+ */
+void
+gst_editor_canvas_mark_dirty (GstEditorCanvas * canvas, GstEditorItem * item)
+{
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+  g_return_if_fail (GST_IS_EDITOR_ITEM (item));
+
+  /* only elements have metadata */
+  if (!canvas->dirty || !GST_IS_EDITOR_ELEMENT (item) ||
+      g_hash_table_contains (canvas->dirty, item))
+    return;
+
+  g_hash_table_add (canvas->dirty, item);
+  g_object_weak_ref (G_OBJECT (item), gst_editor_canvas_dirty_item_gone,
+      canvas);
+}
+
+/*
+ * Returns the set of elements marked dirty since the last call. The
+ * set does not hold references, so it must be used right away.
+ */
+GHashTable *
+gst_editor_canvas_steal_dirty (GstEditorCanvas * canvas)
+{
+  GHashTable *dirty;
+  GHashTableIter iter;
+  gpointer item;
+
+  g_return_val_if_fail (GST_IS_EDITOR_CANVAS (canvas), NULL);
+
+  dirty = canvas->dirty;
+  canvas->dirty = g_hash_table_new (NULL, NULL);
+
+  g_hash_table_iter_init (&iter, dirty);
+  while (g_hash_table_iter_next (&iter, &item, NULL))
+    g_object_weak_unref (G_OBJECT (item), gst_editor_canvas_dirty_item_gone,
+        canvas);
+
+  return dirty;
+}
+
+/**********************************************************************
+ * Progressive realization
+ **********************************************************************/
+
+typedef struct _DeferredChild
+{
+  GstEditorBin *bin;
+  GstObject *child;
+} DeferredChild;
+
+static void
+deferred_child_free (DeferredChild * deferred)
+{
+  g_object_unref (deferred->bin);
+  gst_object_unref (deferred->child);
+  g_free (deferred);
+}
+
+/*
+ * While the canvas is progressive, GstEditorBins do not add the
+ * canvas items of their existing children right away but defer them
+ * to gst_editor_canvas_realize_step(), so large pipelines can be
+ * realized in the main loop without blocking it.
+ * Turning it off drops all children that have not been added yet.
+ */
+void
+gst_editor_canvas_set_progressive (GstEditorCanvas * canvas,
+    gboolean progressive)
+{
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+
+  canvas->progressive = progressive;
+  if (!progressive) {
+    g_queue_foreach (&canvas->deferred, (GFunc) deferred_child_free, NULL);
+    g_queue_clear (&canvas->deferred);
+  }
+}
+
+void
+gst_editor_canvas_defer_child (GstEditorCanvas * canvas, GstEditorBin * bin,
+    GstObject * child)
+{
+  DeferredChild *deferred = g_new (DeferredChild, 1);
+
+  deferred->bin = g_object_ref (bin);
+  deferred->child = gst_object_ref (child);
+  g_queue_push_tail (&canvas->deferred, deferred);
+}
+
+/*
+ * Adds deferred children until deadline (monotonic time) has passed,
+ * but at least one. The children of nested bins are appended to the
+ * queue, so the pipeline is realized breadth-first.
+ * Returns whether there are children left.
+ */
+gboolean
+gst_editor_canvas_realize_step (GstEditorCanvas * canvas, gint64 deadline,
+    guint * n_realized)
+{
+  DeferredChild *deferred;
+  guint n = 0;
+
+  g_return_val_if_fail (GST_IS_EDITOR_CANVAS (canvas), FALSE);
+
+  while ((deferred = g_queue_pop_head (&canvas->deferred))) {
+    if (gst_editor_bin_realize_child (deferred->bin, deferred->child))
+      n++;
+    deferred_child_free (deferred);
+
+    if (g_get_monotonic_time () >= deadline)
+      break;
+  }
+
+  if (n_realized)
+    *n_realized = n;
+  return !g_queue_is_empty (&canvas->deferred);
+}
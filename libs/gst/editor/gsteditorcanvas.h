@@ -38,6 +38,12 @@
 #define GST_EDITOR_CANVAS_ERROR \
     g_quark_from_static_string("gst-editor-canvas-error-quark")
 
+/*
+ * Below this zoom factor, elements are drawn as plain boxes without
+ * titles, state icons or pads and links as plain lines.
+ */
+#define GST_EDITOR_CANVAS_DETAIL_SCALE 0.5
+
 enum GstEditorCanvasError {
   GST_EDITOR_CANVAS_ERROR_FAILED
 };
@@ -50,14 +56,55 @@ typedef struct _GstEditorCanvas
   GstEditorProperty *property;
   GtkWidget *palette;
   gchar *status;
-  GData *attributes;    /* list of name -> GstEditorItemAttr mappings */
+  GHashTable *attributes;       /* element name -> GstEditorItemAttr */
   GRWLock globallock;
   gboolean autosize;
   gboolean live;
   gboolean show_all_bins;
+  gboolean structure_only;      /* load placeholders, see gste-placeholder.h */
+  gboolean compact;             /* paint elements with a GstEditorBody */
+  guint instantiate_id;
   gdouble widthbackup, heightbackup;
+  guint freeze_count;           /* see gst_editor_canvas_freeze() */
+  gboolean detailed;            /* zoomed in, see gst_editor_canvas_set_zoom() */
+
+  /* see gst_editor_canvas_realize_step() */
+  gboolean progressive;
+  GQueue deferred;              /* bins and children to add */
+
+  /* see gst_editor_canvas_queue_move() */
+  GHashTable *moved;            /* set of GstEditorItems */
+  guint moved_tick_id;
+
+  /* see gst_editor_canvas_queue_sync_state() */
+  GHashTable *stale_states;     /* set of GstEditorElements */
+  guint stale_states_tick_id;
+
+  /* see gst_editor_canvas_count_state() */
+  GHashTable *counted;          /* GstEditorElement -> counted state */
+  guint n_states[GST_STATE_PLAYING + 1];
+  guint n_pending;
+  gboolean counts_changed;
+  gchar *state_summary;
+
+  /* see gst_editor_canvas_mark_dirty() */
+  GHashTable *dirty;            /* set of GstEditorElements, not referenced */
+
+  struct _GstEditorPadIndex *pad_index; /* see gsteditorpadindex.h */
+  struct _GstEditorCapsCache *caps_cache; /* see gsteditorcapscache.h */
 } GstEditorCanvas;
 
+/*
+ * A parsed save file, see gst_editor_canvas_load_parse().
+ */
+typedef struct _GstEditorCanvasLoad
+{
+  GstElement *pipeline;
+  GHashTable *attributes;       /* element name -> GstEditorItemAttr */
+  gboolean autosize;
+  guint n_elements;             /* including those of nested bins */
+} GstEditorCanvasLoad;
+
 typedef struct _GstEditorCanvasClass
 {
    GooCanvasClass parent_class;
@@ -73,8 +120,39 @@ gst_editor_canvas_get_pipeline (GstEditorCanvas * canvas)
 }
 
 gboolean gst_editor_canvas_load_with_metadata (GstEditorCanvas * canvas,
-    GKeyFile * key_file, GError ** error);
+    GKeyFile * key_file, const gchar * filename, GError ** error);
+GstEditorCanvasLoad *gst_editor_canvas_load_parse (GKeyFile * key_file,
+    const gchar * filename, gboolean structure_only, GError ** error);
+void gst_editor_canvas_load_apply (GstEditorCanvas * canvas,
+    GstEditorCanvasLoad * load);
+void gst_editor_canvas_load_free (GstEditorCanvasLoad * load);
+
+void gst_editor_canvas_set_progressive (GstEditorCanvas * canvas,
+    gboolean progressive);
+void gst_editor_canvas_defer_child (GstEditorCanvas * canvas,
+    GstEditorBin * bin, GstObject * child);
+gboolean gst_editor_canvas_realize_step (GstEditorCanvas * canvas,
+    gint64 deadline, guint * n_realized);
 
 GstElement * gst_editor_canvas_get_selected_bin (GstEditorCanvas * canvas, GError ** error);
 
+void gst_editor_canvas_freeze (GstEditorCanvas * canvas);
+void gst_editor_canvas_thaw (GstEditorCanvas * canvas);
+
+void gst_editor_canvas_set_zoom (GstEditorCanvas * canvas, gdouble scale);
+
+void gst_editor_canvas_queue_move (GstEditorCanvas * canvas,
+    GstEditorItem * item);
+void gst_editor_canvas_flush_moves (GstEditorCanvas * canvas);
+
+void gst_editor_canvas_queue_sync_state (GstEditorCanvas * canvas,
+    GstEditorElement * element);
+void gst_editor_canvas_flush_states (GstEditorCanvas * canvas);
+void gst_editor_canvas_count_state (GstEditorCanvas * canvas,
+    GstEditorElement * element);
+
+void gst_editor_canvas_mark_dirty (GstEditorCanvas * canvas,
+    GstEditorItem * item);
+GHashTable *gst_editor_canvas_steal_dirty (GstEditorCanvas * canvas);
+
 #endif /* __GST_EDITOR_CANVAS_H__ */
@@ -0,0 +1,334 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Cache of caps intersections between pads.
+ *
+ * While a link is dragged, every pad it could be linked to is lit up.
+ * Querying and intersecting the caps of hundreds of pads is too slow
+ * for the UI thread, so gst_editor_caps_cache_lookup() only answers
+ * from the cache and collects the unknown pairs. They are computed in
+ * a worker thread once gst_editor_caps_cache_flush() is called, and
+ * the caller is notified in the main thread to look them up again.
+ *
+ * Pairs are keyed by the objects of the GstEditorPads: the GstPadTemplate
+ * of a template pad, or the GstPad itself. Template caps never change.
+ * The caps of a GstPad depend on what it is linked to, so its entries are
+ * dropped by gst_editor_caps_cache_invalidate() whenever a link is made or
+ * broken.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/common/gste-debug.h>
+
+#include "gsteditorcapscache.h"
+
+typedef struct
+{
+  GstObject *a, *b;		/* a < b, both referenced */
+} CapsPair;
+
+struct _GstEditorCapsCache
+{
+  gint ref_count;		/* held by the canvas and by every job */
+
+  GMutex lock;			/* protects caps, pairs and generation */
+  GHashTable *caps;		/* GstPad or GstPadTemplate -> GstCaps */
+  GHashTable *pairs;		/* CapsPair -> GstEditorCapsResult */
+  gint generation;		/* bumped by every invalidation */
+
+  /* main thread only */
+  GThreadPool *pool;
+  GHashTable *queued;		/* set of CapsPairs pending or in a job */
+  GPtrArray *pending;		/* CapsPairs of the next job, in queued */
+};
+
+typedef struct
+{
+  GstEditorCapsCache *cache;
+  GPtrArray *pairs;		/* CapsPairs, in queued */
+  gint generation;
+
+  GstEditorCapsCacheNotify notify;
+  gpointer user_data;
+  GDestroyNotify destroy;
+} CapsJob;
+
+static CapsPair *
+caps_pair_new (GstObject * a, GstObject * b)
+{
+  CapsPair *pair = g_new (CapsPair, 1);
+
+  pair->a = gst_object_ref (MIN (a, b));
+  pair->b = gst_object_ref (MAX (a, b));
+  return pair;
+}
+
+static void
+caps_pair_free (CapsPair * pair)
+{
+  gst_object_unref (pair->a);
+  gst_object_unref (pair->b);
+  g_free (pair);
+}
+
+static guint
+caps_pair_hash (gconstpointer key)
+{
+  const CapsPair *pair = key;
+
+  return g_direct_hash (pair->a) * 31 + g_direct_hash (pair->b);
+}
+
+static gboolean
+caps_pair_equal (gconstpointer a, gconstpointer b)
+{
+  const CapsPair *pa = a, *pb = b;
+
+  return pa->a == pb->a && pa->b == pb->b;
+}
+
+static gboolean
+caps_pair_is_live (gpointer key, gpointer value, gpointer user_data)
+{
+  CapsPair *pair = key;
+
+  return GST_IS_PAD (pair->a) || GST_IS_PAD (pair->b);
+}
+
+static gboolean
+caps_is_live (gpointer key, gpointer value, gpointer user_data)
+{
+  return GST_IS_PAD (key);
+}
+
+/* Returns a reference to the caps of object, querying them if necessary. */
+static GstCaps *
+caps_cache_get_caps (GstEditorCapsCache * cache, GstObject * object,
+    gint generation)
+{
+  GstCaps *caps;
+
+  g_mutex_lock (&cache->lock);
+  caps = g_hash_table_lookup (cache->caps, object);
+  if (caps)
+    gst_caps_ref (caps);
+  g_mutex_unlock (&cache->lock);
+  if (caps)
+    return caps;
+
+  if (GST_IS_PAD (object))
+    caps = gst_pad_query_caps (GST_PAD (object), NULL);
+  else
+    caps = gst_pad_template_get_caps (GST_PAD_TEMPLATE (object));
+
+  g_mutex_lock (&cache->lock);
+  if (generation == cache->generation)
+    g_hash_table_replace (cache->caps, gst_object_ref (object),
+        gst_caps_ref (caps));
+  g_mutex_unlock (&cache->lock);
+
+  return caps;
+}
+
+static gboolean
+caps_cache_job_done (gpointer user_data)
+{
+  CapsJob *job = user_data;
+
+  for (guint i = 0; i < job->pairs->len; i++)
+    g_hash_table_remove (job->cache->queued, g_ptr_array_index (job->pairs,
+            i));
+  g_ptr_array_unref (job->pairs);
+
+  if (job->notify)
+    job->notify (job->user_data);
+  if (job->destroy)
+    job->destroy (job->user_data);
+
+  gst_editor_caps_cache_unref (job->cache);
+  g_free (job);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* runs in the worker thread */
+static void
+caps_cache_run (gpointer data, gpointer user_data)
+{
+  CapsJob *job = data;
+  GstEditorCapsCache *cache = user_data;
+
+  for (guint i = 0; i < job->pairs->len; i++) {
+    CapsPair *pair = g_ptr_array_index (job->pairs, i);
+    GstCaps *a, *b;
+    GstEditorCapsResult result;
+
+    /* invalidated since, let the next lookups queue a fresh job */
+    if (g_atomic_int_get (&cache->generation) != job->generation)
+      break;
+
+    a = caps_cache_get_caps (cache, pair->a, job->generation);
+    b = caps_cache_get_caps (cache, pair->b, job->generation);
+    result = gst_caps_can_intersect (a, b) ?
+        GST_EDITOR_CAPS_COMPATIBLE : GST_EDITOR_CAPS_INCOMPATIBLE;
+    gst_caps_unref (a);
+    gst_caps_unref (b);
+
+    g_mutex_lock (&cache->lock);
+    if (job->generation == cache->generation)
+      g_hash_table_replace (cache->pairs, caps_pair_new (pair->a, pair->b),
+          GINT_TO_POINTER (result));
+    g_mutex_unlock (&cache->lock);
+  }
+
+  g_idle_add (caps_cache_job_done, job);
+}
+
+/* Returns the caps cache of canvas, creating it if necessary. */
+GstEditorCapsCache *
+gst_editor_caps_cache_get (GstEditorCanvas * canvas)
+{
+  GstEditorCapsCache *cache;
+
+  g_return_val_if_fail (GST_IS_EDITOR_CANVAS (canvas), NULL);
+
+  if (canvas->caps_cache)
+    return canvas->caps_cache;
+
+  cache = g_new0 (GstEditorCapsCache, 1);
+  cache->ref_count = 1;
+  g_mutex_init (&cache->lock);
+  cache->caps = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+      gst_object_unref, (GDestroyNotify) gst_caps_unref);
+  cache->pairs = g_hash_table_new_full (caps_pair_hash, caps_pair_equal,
+      (GDestroyNotify) caps_pair_free, NULL);
+  cache->pool = g_thread_pool_new (caps_cache_run, cache, 1, FALSE, NULL);
+  cache->queued = g_hash_table_new_full (caps_pair_hash, caps_pair_equal,
+      (GDestroyNotify) caps_pair_free, NULL);
+  cache->pending = g_ptr_array_new ();
+
+  canvas->caps_cache = cache;
+  return cache;
+}
+
+/* Notes that links were made or broken, which changes the caps of pads. */
+void
+gst_editor_caps_cache_invalidate (GstEditorCanvas * canvas)
+{
+  GstEditorCapsCache *cache;
+
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+
+  if (!(cache = canvas->caps_cache))
+    return;
+
+  g_mutex_lock (&cache->lock);
+  g_atomic_int_inc (&cache->generation);
+  g_hash_table_foreach_remove (cache->caps, caps_is_live, NULL);
+  g_hash_table_foreach_remove (cache->pairs, caps_pair_is_live, NULL);
+  g_mutex_unlock (&cache->lock);
+}
+
+void
+gst_editor_caps_cache_unref (GstEditorCapsCache * cache)
+{
+  if (!cache || --cache->ref_count > 0)
+    return;
+
+  /* only jobs hold references, so none is left in the pool */
+  g_thread_pool_free (cache->pool, FALSE, TRUE);
+  g_ptr_array_unref (cache->pending);
+  g_hash_table_unref (cache->queued);
+  g_hash_table_unref (cache->pairs);
+  g_hash_table_unref (cache->caps);
+  g_mutex_clear (&cache->lock);
+  g_free (cache);
+}
+
+/*
+ * Returns whether a link between pad and other is possible as far as
+ * their caps are concerned. An unknown pair is computed by the next
+ * gst_editor_caps_cache_flush().
+ */
+GstEditorCapsResult
+gst_editor_caps_cache_lookup (GstEditorCapsCache * cache,
+    GstEditorPad * pad, GstEditorPad * other)
+{
+  GstObject *a = GST_EDITOR_ITEM (pad)->object;
+  GstObject *b = GST_EDITOR_ITEM (other)->object;
+  CapsPair key;
+  GstEditorCapsResult result;
+
+  g_return_val_if_fail (cache != NULL, GST_EDITOR_CAPS_UNKNOWN);
+
+  if (!a || !b)
+    return GST_EDITOR_CAPS_UNKNOWN;
+
+  key.a = MIN (a, b);
+  key.b = MAX (a, b);
+
+  g_mutex_lock (&cache->lock);
+  result = GPOINTER_TO_INT (g_hash_table_lookup (cache->pairs, &key));
+  g_mutex_unlock (&cache->lock);
+
+  if (result == GST_EDITOR_CAPS_UNKNOWN
+      && !g_hash_table_contains (cache->queued, &key)) {
+    CapsPair *pair = caps_pair_new (a, b);
+
+    g_hash_table_add (cache->queued, pair);
+    g_ptr_array_add (cache->pending, pair);
+  }
+
+  return result;
+}
+
+/*
+ * Computes the pairs collected by gst_editor_caps_cache_lookup() in the
+ * worker thread, and then calls notify in the main thread. Does nothing
+ * but destroy user_data if there are none.
+ */
+void
+gst_editor_caps_cache_flush (GstEditorCapsCache * cache,
+    GstEditorCapsCacheNotify notify, gpointer user_data,
+    GDestroyNotify destroy)
+{
+  CapsJob *job;
+
+  g_return_if_fail (cache != NULL);
+
+  if (cache->pending->len == 0) {
+    if (destroy)
+      destroy (user_data);
+    return;
+  }
+
+  job = g_new (CapsJob, 1);
+  job->cache = cache;
+  cache->ref_count++;
+  job->pairs = cache->pending;
+  job->generation = g_atomic_int_get (&cache->generation);
+  job->notify = notify;
+  job->user_data = user_data;
+  job->destroy = destroy;
+
+  EDITOR_LOG ("caps cache: intersecting %u pad pairs", job->pairs->len);
+
+  cache->pending = g_ptr_array_new ();
+  g_thread_pool_push (cache->pool, job, NULL);
+}
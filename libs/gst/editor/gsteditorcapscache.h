@@ -0,0 +1,54 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef __GST_EDITOR_CAPS_CACHE_H__
+#define __GST_EDITOR_CAPS_CACHE_H__
+
+#include <gst/editor/gsteditorcanvas.h>
+#include <gst/editor/gsteditorpad.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Whether the caps of two pads intersect, for every pair of GstPads
+ * and GstPadTemplates looked up so far. Unknown pairs are computed in
+ * a worker thread. The cache belongs to the GstEditorCanvas.
+ */
+typedef struct _GstEditorCapsCache GstEditorCapsCache;
+
+typedef enum
+{
+  GST_EDITOR_CAPS_UNKNOWN = 0,
+  GST_EDITOR_CAPS_COMPATIBLE,
+  GST_EDITOR_CAPS_INCOMPATIBLE
+} GstEditorCapsResult;
+
+/* called in the main thread when a flushed batch of pairs is done */
+typedef void (*GstEditorCapsCacheNotify) (gpointer user_data);
+
+GstEditorCapsCache *gst_editor_caps_cache_get (GstEditorCanvas * canvas);
+void gst_editor_caps_cache_invalidate (GstEditorCanvas * canvas);
+void gst_editor_caps_cache_unref (GstEditorCapsCache * cache);
+
+GstEditorCapsResult gst_editor_caps_cache_lookup (GstEditorCapsCache * cache,
+    GstEditorPad * pad, GstEditorPad * other);
+void gst_editor_caps_cache_flush (GstEditorCapsCache * cache,
+    GstEditorCapsCacheNotify notify, gpointer user_data, GDestroyNotify destroy);
+
+G_END_DECLS
+
+#endif /* __GST_EDITOR_CAPS_CACHE_H__ */
@@ -0,0 +1,149 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Main thread dispatch of GStreamer signals.
+ *
+ * Signals like "pad-added", "element-added" or "linked" may be emitted
+ * by streaming threads. Their handlers used to update the canvas right
+ * away while holding the canvas-wide globallock, which serialized them
+ * against the UI and could deadlock against it.
+ *
+ * Now the handlers only push a record to a lock-free queue: a stack of
+ * records pushed with compare-and-exchange, which the main thread takes
+ * as a whole. The first record pushed to an empty queue schedules a
+ * drain, so a storm of signals is handled in one batch. The records are
+ * run in the order they were pushed.
+ *
+ * Signals emitted in the main thread are handled immediately, after the
+ * records queued before them, so the callers see the canvas updated as
+ * before.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/common/gste-debug.h>
+
+#include "gsteditordispatch.h"
+
+typedef struct _DispatchRecord DispatchRecord;
+
+struct _DispatchRecord
+{
+  DispatchRecord *next;
+
+  GstEditorDispatchFunc func;
+  GObject *target;		/* referenced */
+  GstObject *a, *b;		/* referenced, may be NULL */
+};
+
+static GThread *main_thread;
+
+/* most recently pushed first */
+static DispatchRecord *queue;
+
+/* main thread only, the records being run in order */
+static GQueue batch = G_QUEUE_INIT;
+
+static void
+dispatch_record_run (DispatchRecord * record)
+{
+  record->func (record->target, record->a, record->b);
+
+  g_object_unref (record->target);
+  if (record->a)
+    gst_object_unref (record->a);
+  if (record->b)
+    gst_object_unref (record->b);
+  g_free (record);
+}
+
+static gboolean
+dispatch_drain_cb (gpointer user_data)
+{
+  gst_editor_dispatch_flush ();
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Notes the main thread, call it from the main thread. */
+void
+gst_editor_dispatch_init (void)
+{
+  if (!main_thread)
+    main_thread = g_thread_self ();
+}
+
+/*
+ * Calls func with target, a and b in the main thread. Can be called
+ * from any thread.
+ */
+void
+gst_editor_dispatch (GstEditorDispatchFunc func, gpointer target,
+    gpointer a, gpointer b)
+{
+  DispatchRecord *record, *head;
+
+  g_return_if_fail (func != NULL);
+  g_return_if_fail (G_IS_OBJECT (target));
+
+  record = g_new (DispatchRecord, 1);
+  record->func = func;
+  record->target = g_object_ref (target);
+  record->a = a ? gst_object_ref (a) : NULL;
+  record->b = b ? gst_object_ref (b) : NULL;
+
+  if (g_thread_self () == main_thread) {
+    gst_editor_dispatch_flush ();
+    dispatch_record_run (record);
+    return;
+  }
+
+  do {
+    head = g_atomic_pointer_get (&queue);
+    record->next = head;
+  } while (!g_atomic_pointer_compare_and_exchange (&queue, head, record));
+
+  /* the queue was empty, so no drain is pending yet */
+  if (!head)
+    g_idle_add_full (G_PRIORITY_DEFAULT, dispatch_drain_cb, NULL, NULL);
+}
+
+/* Runs the queued records, call it from the main thread. */
+void
+gst_editor_dispatch_flush (void)
+{
+  DispatchRecord *records, *record;
+  GList *tail;
+
+  do {
+    records = g_atomic_pointer_get (&queue);
+  } while (records
+      && !g_atomic_pointer_compare_and_exchange (&queue, records, NULL));
+
+  /* append in the order they were pushed, behind a batch being run */
+  tail = batch.tail;
+  for (record = records; record; record = record->next)
+    g_queue_insert_after (&batch, tail, record);
+
+  if (records)
+    EDITOR_LOG ("dispatching %u records", batch.length);
+
+  /* records might dispatch again, which runs the rest of the batch */
+  while ((record = g_queue_pop_head (&batch)))
+    dispatch_record_run (record);
+}
@@ -0,0 +1,40 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef __GST_EDITOR_DISPATCH_H__
+#define __GST_EDITOR_DISPATCH_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Handles a GStreamer signal in the main thread. target is the editor
+ * object the signal handler was connected with, a and b are the
+ * GstObjects passed by the signal (or NULL).
+ */
+typedef void (*GstEditorDispatchFunc) (gpointer target, gpointer a,
+    gpointer b);
+
+void gst_editor_dispatch_init (void);
+void gst_editor_dispatch (GstEditorDispatchFunc func, gpointer target,
+    gpointer a, gpointer b);
+void gst_editor_dispatch_flush (void);
+
+G_END_DECLS
+
+#endif /* __GST_EDITOR_DISPATCH_H__ */
@@ -28,13 +28,16 @@
 #include <gst/common/gste-marshal.h>
 #include <gst/common/gste-debug.h>
 #include <gst/common/gste-serialize.h>
+#include <gst/common/gste-placeholder.h>
 #include "../../../pixmaps/pixmaps.h"
 
 #include "gst-helper.h"
 #include "gsteditorpad.h"
 #include "gsteditoritem.h"
+#include "gsteditorbody.h"
 #include "gsteditorcanvas.h"
 #include "gsteditorelement.h"
+#include "gsteditordispatch.h"
 
 GST_DEBUG_CATEGORY (gste_element_debug);
 #define GST_CAT_DEFAULT gste_element_debug
@@ -63,6 +66,8 @@ static void gst_editor_element_resize (GstEditorItem * item);
 static void gst_editor_element_repack (GstEditorItem * item);
 static void gst_editor_element_object_changed (GstEditorItem * bin,
     GstObject * object);
+static void gst_editor_element_motion (GstEditorItem * item, gdouble x,
+    gdouble y);
 
 /* events fired by items within self */
 //static gint gst_editor_element_resizebox_event (GooCanvasItem * citem,
@@ -96,12 +101,30 @@ static gboolean gst_editor_element_resizebox_motion_notify_event (GooCanvasItem
     * item, GooCanvasItem * target_item, GdkEventMotion * event,
     GstEditorItem * user_data);
 
+/* events of the compact GstEditorBody */
+static gboolean gst_editor_element_body_leave_notify_event (GooCanvasItem *
+    item, GooCanvasItem * target_item, GdkEventCrossing * event,
+    GstEditorItem * user_data);
+static gboolean gst_editor_element_body_button_press_event (GooCanvasItem *
+    item, GooCanvasItem * target_item, GdkEventButton * event,
+    GstEditorItem * user_data);
+static gboolean gst_editor_element_body_button_release_event (GooCanvasItem *
+    item, GooCanvasItem * target_item, GdkEventButton * event,
+    GstEditorItem * user_data);
+static gboolean gst_editor_element_body_motion_notify_event (GooCanvasItem *
+    item, GooCanvasItem * target_item, GdkEventMotion * event,
+    GstEditorItem * user_data);
+
 
 /* callbacks on the GstElement */
 static void on_new_pad (GstElement * element, GstPad * pad,
     GstEditorElement * editor_element);
 static void on_pad_removed (GstElement * element, GstPad * pad,
     GstEditorElement * editor_element);
+static void gst_editor_element_pad_added (GstEditorElement * editor_element,
+    GstElement * element, GstPad * pad);
+static void gst_editor_element_pad_removed (GstEditorElement * editor_element,
+    GstElement * element, GstPad * pad);
 //static void on_state_change (GstElement * element, GstState old,
 //    GstState state, GstEditorElement * editor_element);
 
@@ -117,6 +140,7 @@ static gboolean gst_editor_element_set_state_cb (GstEditorElement * element);
 
 /*static gboolean gst_editor_element_sync_state (GstEditorElement * element);*/
 static void gst_editor_element_add_pads (GstEditorElement * element);
+static void gst_editor_element_clear_template_pads (GstEditorElement * element);
 
 /* callbacks for the popup menu */
 static void on_copy (GSimpleAction * action,
@@ -144,6 +168,7 @@ enum
 enum
 {
   SIZE_CHANGED,
+  PADS_ADDED,
   LAST_SIGNAL
 };
 
@@ -245,6 +270,12 @@ gst_editor_element_class_init (GstEditorElementClass * klass)
       g_signal_new ("size_changed", G_OBJECT_CLASS_TYPE (klass),
       G_SIGNAL_RUN_FIRST, G_STRUCT_OFFSET (GstEditorElementClass, size_changed),
       NULL, NULL, gst_editor_marshal_VOID__VOID, G_TYPE_NONE, 0);
+  /* the GPtrArray of the GstPads added in one batch */
+  gst_editor_element_signals[PADS_ADDED] =
+      g_signal_new ("pads-added", G_OBJECT_CLASS_TYPE (klass),
+      G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (GstEditorElementClass, pads_added),
+      NULL, NULL, gst_editor_marshal_VOID__POINTER, G_TYPE_NONE, 1,
+      G_TYPE_POINTER);
 
   object_class->set_property = gst_editor_element_set_property;
   object_class->get_property = gst_editor_element_get_property;
@@ -266,6 +297,7 @@ gst_editor_element_class_init (GstEditorElementClass * klass)
   item_class->resize = gst_editor_element_resize;
   item_class->repack = gst_editor_element_repack;
   item_class->object_changed = gst_editor_element_object_changed;
+  item_class->motion = gst_editor_element_motion;
 
   GST_DEBUG_CATEGORY_INIT (gste_element_debug, "GSTE_ELEMENT", 0,
       "GStreamer Editor Element Model");
@@ -295,9 +327,12 @@ gst_editor_element_init (GstEditorElement * element)
 
   element->next_state = GST_STATE_VOID_PENDING;
   element->set_state_idle_id = 0;
-  
-  g_rw_lock_init (&element->rwlock);
 
+  element->sort_index = -1;
+
+  element->new_pads = g_ptr_array_new_with_free_func (gst_object_unref);
+  element->template_pads = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, NULL);
 }
 
 static void
@@ -305,13 +340,28 @@ gst_editor_element_dispose (GObject * object)
 {
   GstEditorElement *element = GST_EDITOR_ELEMENT (object);
 
-  g_rw_lock_clear (&element->rwlock);
-
   if (element->set_state_idle_id) {
     g_source_remove (element->set_state_idle_id);
     element->set_state_idle_id = 0;
   }
   element->next_state = GST_STATE_VOID_PENDING;
+
+  /* the tick callback references the element, so it is gone unless the
+   * element is disposed explicitly */
+  if (element->new_pads_tick_id) {
+    GooCanvas *canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (element));
+
+    if (canvas)
+      gtk_widget_remove_tick_callback (GTK_WIDGET (canvas),
+          element->new_pads_tick_id);
+    element->new_pads_tick_id = 0;
+  }
+  g_clear_pointer (&element->new_pads, g_ptr_array_unref);
+  if (element->template_pads) {
+    gst_editor_element_clear_template_pads (element);
+    g_clear_pointer (&element->template_pads, g_hash_table_unref);
+  }
+
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
@@ -326,14 +376,19 @@ gst_editor_element_set_property (GObject * object, guint prop_id,
       element->active = g_value_get_boolean (value);
       g_object_set (G_OBJECT (GST_EDITOR_ITEM (element)->border),
           "line-width", (element->active ? 2.0 : 1.0), NULL);
-      g_object_set (G_OBJECT (element->statebox),
-          "line-width", (element->active ? 2.0 : 1.0), NULL);
+      /* the compact body uses its line width for the state box */
+      if (element->statebox)
+        g_object_set (G_OBJECT (element->statebox),
+            "line-width", (element->active ? 2.0 : 1.0), NULL);
       break;
     case ARG_RESIZEABLE:
       element->resizeable = g_value_get_boolean (value);
       if (!GST_EDITOR_ITEM (element)->realized)
         break;
-      if (element->resizeable)
+      if (GST_EDITOR_ITEM (element)->compact)
+        g_object_set (GST_EDITOR_ITEM (element)->border,
+            "resizeable", element->resizeable, NULL);
+      else if (element->resizeable)
         goo_canvas_item_simple_show (GOO_CANVAS_ITEM_SIMPLE (element->
                 resizebox));
       else
@@ -371,12 +426,15 @@ gst_editor_element_get_property (GObject * object, guint prop_id,
   }
 }
 
-/*static*/ void
-gst_editor_element_realize (GooCanvasItem * citem)
+/*
+ * Creates the resize box, state box and state icons as separate
+ * canvas items.
+ */
+static void
+gst_editor_element_realize_items (GstEditorElement * element,
+    GstEditorCanvas * canvas)
 {
-  GstEditorCanvas *canvas;
-  GstEditorElement *element;
-  GstEditorItem *item;
+  GstEditorItem *item = GST_EDITOR_ITEM (element);
   GdkPixbuf *pixbuf;
   static const guint8 *state_icons[] = {
     off_stock_image,
@@ -385,17 +443,8 @@ gst_editor_element_realize (GooCanvasItem * citem)
     play_stock_image
   };
 
-  element = GST_EDITOR_ELEMENT (citem);
-  item = GST_EDITOR_ITEM (citem);
-
-  g_rw_lock_reader_lock (&element->rwlock);
-  //g_print("realize called for GooCanvas Item Pointer %p, Item-Pointer %p gotten mutex\n",(void*)citem, item);
-  g_return_if_fail (GST_IS_EDITOR_ELEMENT (element));//if it has been deleted we dont touch it...
-
-  gst_editor_item_realize (citem);
-
   /* the resize box */
-  element->resizebox = goo_canvas_rect_new (GOO_CANVAS_ITEM (citem),
+  element->resizebox = goo_canvas_rect_new (GOO_CANVAS_ITEM (element),
       0., 0., 0., 0.,
       "line-width", 1.,
       "fill_color", "white", "stroke_color", "black", "antialias",
@@ -414,11 +463,12 @@ gst_editor_element_realize (GooCanvasItem * citem)
   g_signal_connect (G_OBJECT (element->resizebox), "button-release-event",
       G_CALLBACK (gst_editor_element_resizebox_button_release_event), element);
 
+  gst_editor_item_set_detail (element->resizebox);
   if (!element->resizeable)
     goo_canvas_item_simple_hide (GOO_CANVAS_ITEM_SIMPLE (element->resizebox));
 
   /* create the state boxen */
-  element->statebox = goo_canvas_rect_new (GOO_CANVAS_ITEM (item),
+  element->statebox = goo_canvas_rect_new (GOO_CANVAS_ITEM (element),
       0., 0., 0., 0.,
       "line-width", 1.,
       "fill_color", "white", "stroke_color", "black", "antialias",
@@ -426,13 +476,15 @@ gst_editor_element_realize (GooCanvasItem * citem)
   g_return_if_fail (element->statebox != NULL);
 
   GST_EDITOR_SET_OBJECT (element->statebox, element);
+  gst_editor_item_set_detail (element->statebox);
 
   for (gint i = 0; i < 4; i++) {
     pixbuf = gdk_pixbuf_new_from_inline (-1, state_icons[i], FALSE, NULL);
-    element->stateicons[i] = goo_canvas_image_new (GOO_CANVAS_ITEM (item),
+    element->stateicons[i] = goo_canvas_image_new (GOO_CANVAS_ITEM (element),
         pixbuf, 0.0, 0.0, "antialias", CAIRO_ANTIALIAS_NONE, NULL);
 
     GST_EDITOR_SET_OBJECT (element->stateicons[i], element);
+    gst_editor_item_set_detail (element->stateicons[i]);
 
     g_signal_connect (element->stateicons[i], "enter-notify-event",
         G_CALLBACK (gst_editor_element_state_enter_notify_event),
@@ -452,12 +504,64 @@ gst_editor_element_realize (GooCanvasItem * citem)
    * If the GooCanvas (GstEditorCanvas) is set as a non-live canvas,
    * it makes no sense to be able to change element states.
    */
-  canvas = GST_EDITOR_CANVAS (goo_canvas_item_get_canvas (citem));
   if (!canvas->live) {
     goo_canvas_item_simple_hide (GOO_CANVAS_ITEM_SIMPLE (element->statebox));
     for (gint i = 0; i < 4; i++)
       goo_canvas_item_simple_hide (GOO_CANVAS_ITEM_SIMPLE (element->stateicons[i]));
   }
+}
+
+/*
+ * In compact mode, the border (see gst_editor_item_realize()) is a
+ * GstEditorBody that paints the title, resize box and state icons
+ * itself and whose events are dispatched by the part they hit.
+ */
+static void
+gst_editor_element_realize_body (GstEditorElement * element,
+    GstEditorCanvas * canvas)
+{
+  GooCanvasItem *body = GST_EDITOR_ITEM (element)->border;
+
+  /* see the comment in gst_editor_element_realize_items() */
+  g_object_set (body, "show-states", canvas->live,
+      "resizeable", element->resizeable, NULL);
+
+  g_signal_connect (body, "leave-notify-event",
+      G_CALLBACK (gst_editor_element_body_leave_notify_event), element);
+  g_signal_connect (body, "button-press-event",
+      G_CALLBACK (gst_editor_element_body_button_press_event), element);
+  g_signal_connect (body, "motion-notify-event",
+      G_CALLBACK (gst_editor_element_body_motion_notify_event), element);
+  g_signal_connect (body, "button-release-event",
+      G_CALLBACK (gst_editor_element_body_button_release_event), element);
+}
+
+/*static*/ void
+gst_editor_element_realize (GooCanvasItem * citem)
+{
+  GstEditorCanvas *canvas;
+  GstEditorElement *element;
+  GstEditorItem *item;
+
+  element = GST_EDITOR_ELEMENT (citem);
+  item = GST_EDITOR_ITEM (citem);
+
+  //g_print("realize called for GooCanvas Item Pointer %p, Item-Pointer %p gotten mutex\n",(void*)citem, item);
+  g_return_if_fail (GST_IS_EDITOR_ELEMENT (element));//if it has been deleted we dont touch it...
+
+  /* placeholders are greyed out until they are instantiated */
+  if (GSTE_IS_PLACEHOLDER (item->object))
+    item->fill_color = 0xddddddff;
+
+  canvas = GST_EDITOR_CANVAS (goo_canvas_item_get_canvas (citem));
+  item->compact = canvas->compact;
+
+  gst_editor_item_realize (citem);
+
+  if (item->compact)
+    gst_editor_element_realize_body (element, canvas);
+  else
+    gst_editor_element_realize_items (element, canvas);
 
   gst_editor_element_add_pads (element);
 
@@ -468,8 +572,7 @@ gst_editor_element_realize (GooCanvasItem * citem)
 
   if (G_OBJECT_TYPE (item) == GST_TYPE_EDITOR_ELEMENT)
     gst_editor_item_resize (item);
-  g_rw_lock_reader_unlock (&element->rwlock);
-
+  gst_editor_canvas_count_state (canvas, element);
 }
 
 static void
@@ -499,24 +602,22 @@ gst_editor_element_resize (GstEditorItem * item)
   /* now go and try to calculate necessary space for the pads */
   element->sinkwidth = 0.0;
   element->sinkheight = 0.0;
-  element->sinks = 0;
-  for (l = element->sinkpads; l; l = l->next) {
+  element->sinks = element->sinkpads.length;
+  for (l = element->sinkpads.head; l; l = l->next) {
     subitem = GST_EDITOR_ITEM (l->data);
     element->sinkwidth = MAX (element->sinkwidth, subitem->width);
     element->sinkheight = MAX (element->sinkheight, subitem->height);
-    element->sinks++;
   }
   item->l.w = MAX (item->l.w, element->sinkwidth + 12.0);
   item->l.h += element->sinkheight * element->sinks;
 
   element->srcwidth = 0.0;
   element->srcheight = 0.0;
-  element->srcs = 0;
-  for (l = element->srcpads; l; l = l->next) {
+  element->srcs = element->srcpads.length;
+  for (l = element->srcpads.head; l; l = l->next) {
     subitem = GST_EDITOR_ITEM (l->data);
     element->srcwidth = MAX (element->srcwidth, subitem->width);
     element->srcheight = MAX (element->srcheight, subitem->height);
-    element->srcs++;
   }
   item->r.w = MAX (item->r.w, element->srcwidth + 12.0);
   item->r.h += element->srcheight * element->srcs;
@@ -530,6 +631,7 @@ gst_editor_element_repack (GstEditorItem * item)
   GstEditorElement *element;
   GList *l;
   GstEditorItem *subitem;
+  GooCanvasItem *parent;
   gint sinks;
   gint srcs;
   gdouble x1, x2, y2;
@@ -540,9 +642,10 @@ gst_editor_element_repack (GstEditorItem * item)
 
   element = GST_EDITOR_ELEMENT (item);
 
-  /* the resize box */
-  g_object_set (element->resizebox, "x", item->width - 4.0, "y",
-      item->height - 4.0, "width", 4.0, "height", 4.0, NULL);
+  /* the resize box, the compact body places it itself */
+  if (element->resizebox)
+    g_object_set (element->resizebox, "x", item->width - 4.0, "y",
+        item->height - 4.0, "width", 4.0, "height", 4.0, NULL);
 
   /* make sure args to goo_canvas_item_set are doubles */
   x1 = 0.0;
@@ -551,7 +654,7 @@ gst_editor_element_repack (GstEditorItem * item)
   y2 = item->height;
 
   /* place the state boxes */
-  for (i = 0; i < 4; i++) {
+  for (i = 0; !item->compact && i < 4; i++) {
     g_return_if_fail (element->stateicons[i] != NULL);
     g_object_set (element->stateicons[i],
         "x", x1 + (element->statewidth * i) + 1.0,
@@ -562,7 +665,7 @@ gst_editor_element_repack (GstEditorItem * item)
   g_idle_add ((GSourceFunc) gst_editor_element_sync_state, element);
   /* place the pads */
   sinks = element->sinks;
-  l = element->sinkpads;
+  l = element->sinkpads.head;
   while (l) {
     subitem = GST_EDITOR_ITEM (l->data);
 
@@ -575,7 +678,7 @@ gst_editor_element_repack (GstEditorItem * item)
     l = g_list_next (l);
   }
   srcs = element->srcs;
-  l = element->srcpads;
+  l = element->srcpads.head;
   while (l) {
     subitem = GST_EDITOR_ITEM (l->data);
 
@@ -590,6 +693,11 @@ gst_editor_element_repack (GstEditorItem * item)
   if (GST_EDITOR_ITEM_CLASS (parent_class)->repack)
     (GST_EDITOR_ITEM_CLASS (parent_class)->repack) (item);
   //g_print("survived repack");
+
+  /* the size might have changed */
+  parent = goo_canvas_item_get_parent (GOO_CANVAS_ITEM (item));
+  if (GST_IS_EDITOR_BIN (parent))
+    gst_editor_bin_sort_update (GST_EDITOR_BIN (parent), element);
 }
 
 static gboolean
@@ -636,12 +744,30 @@ gst_editor_element_button_press_event (GooCanvasItem * citem,
   return FALSE;
 }
 
+/*
+ * Applies the latest pointer position of a drag or resize, once per
+ * frame. x and y are in the element's coordinate space, so the drag
+ * offset is relative to the button press.
+ */
+static void
+gst_editor_element_motion (GstEditorItem * item, gdouble x, gdouble y)
+{
+  GstEditorElement *element = GST_EDITOR_ELEMENT (item);
+
+  if (element->resizing) {
+    if (x > 0.0 && y > 0.0)
+      g_object_set (G_OBJECT (element), "width", x, "height", y, NULL);
+  } else if (element->dragging) {
+    gst_editor_element_move (element, x - element->dragx, y - element->dragy);
+//     element->dragx = x;
+//     element->dragy = y;
+  }
+}
+
 static gboolean
 gst_editor_element_motion_notify_event (GooCanvasItem * citem,
     GooCanvasItem * target, GdkEventMotion * event)
 {
-  gdouble dx, dy;
-
   GstEditorElement *element = GST_EDITOR_ELEMENT (citem);
 
   if (element->dragging) {
@@ -649,12 +775,9 @@ gst_editor_element_motion_notify_event (GooCanvasItem * citem,
 //   g_print ("%p received 'move' signal at %g, %g (root: %g, %g)\n",
 //         citem, event->x, event->y, event->x_root, event->y_root);
 
-    dx = event->x - element->dragx;
-    dy = event->y - element->dragy;
-    gst_editor_element_move (element, dx, dy);
-//     element->dragx = event->x;
-//     element->dragy = event->y;
-//       g_print ("%p received 'moved' at %g, %g \n", citem, dx, dy);
+    /* see gst_editor_element_motion() */
+    gst_editor_item_queue_motion (GST_EDITOR_ITEM (element), event->x,
+        event->y);
     element->moved = TRUE;
     return TRUE;
   }
@@ -694,6 +817,7 @@ gst_editor_element_ungrab (GstEditorElement * element, guint32 time)
   if (!element->dragging)
     return FALSE;
 
+  gst_editor_item_flush_motion (GST_EDITOR_ITEM (element));
   element->dragging = FALSE;
   goo_canvas_pointer_ungrab (goo_canvas_item_get_canvas (citem),
       citem, time);
@@ -709,6 +833,8 @@ gst_editor_element_object_changed (GstEditorItem * item, GstObject * object)
     // g_source_remove                     (guint tag);
     g_signal_handlers_disconnect_by_func (item->object, on_new_pad, item);
     g_signal_handlers_disconnect_by_func (item->object, on_pad_removed, item);
+    /* the templates of the new object may differ */
+    gst_editor_element_clear_template_pads (GST_EDITOR_ELEMENT (item));
     //in case it stays alive..
     //if(G_IS_OBJECT(item)&&G_OBJECT_PARENT(item)&&GST_IS_EDITOR_BIN(G_OBJECT_PARENT(item))){
     //  GstEditorBin* parent=GST_EDITOR_BIN(G_OBJECT_PARENT(item));
@@ -857,6 +983,7 @@ gst_editor_element_resizebox_button_release_event (GooCanvasItem * citem,
   element = GST_EDITOR_ELEMENT (item);
 
   if (element->resizing) {
+    gst_editor_item_flush_motion (item);
     element->resizing = FALSE;
     goo_canvas_pointer_ungrab (goo_canvas_item_get_canvas (citem),
         citem, event->time);
@@ -882,10 +1009,8 @@ gst_editor_element_resizebox_motion_notify_event (GooCanvasItem * citem,
 //      goo_canvas_item_get_parent(citem), &item_x, &item_y);
 
   if (element->resizing) {
-    if (item_x > 0.0 && item_y > 0.0)
-      g_object_set (G_OBJECT (element), "width", item_x, "height", item_y,
-          NULL);
-
+    /* see gst_editor_element_motion() */
+    gst_editor_item_queue_motion (item, item_x, item_y);
     return TRUE;
   }
 
@@ -893,6 +1018,73 @@ gst_editor_element_resizebox_motion_notify_event (GooCanvasItem * citem,
 }
 
 
+static gboolean
+gst_editor_element_body_leave_notify_event (GooCanvasItem * citem,
+    GooCanvasItem * target_item, GdkEventCrossing * event, GstEditorItem * item)
+{
+  GstEditorElement *element = GST_EDITOR_ELEMENT (item);
+
+  g_object_set (citem, "resize-highlight", FALSE, NULL);
+  element->hesitating = FALSE;
+
+  return FALSE;
+}
+
+static gboolean
+gst_editor_element_body_button_press_event (GooCanvasItem * citem,
+    GooCanvasItem * target_item, GdkEventButton * event, GstEditorItem * item)
+{
+  GstEditorBodyPart part =
+      gst_editor_body_get_part (GST_EDITOR_BODY (citem), event->x, event->y);
+
+  if (part == GST_EDITOR_BODY_PART_RESIZE)
+    return gst_editor_element_resizebox_button_press_event (citem,
+        target_item, event, item);
+  if (part >= GST_EDITOR_BODY_PART_STATE)
+    return gst_editor_element_state_button_press_event (citem, target_item,
+        event, GINT_TO_POINTER (part - GST_EDITOR_BODY_PART_STATE));
+
+  /* the element itself is dragged */
+  return FALSE;
+}
+
+static gboolean
+gst_editor_element_body_button_release_event (GooCanvasItem * citem,
+    GooCanvasItem * target_item, GdkEventButton * event, GstEditorItem * item)
+{
+  GstEditorBodyPart part;
+
+  if (GST_EDITOR_ELEMENT (item)->resizing)
+    return gst_editor_element_resizebox_button_release_event (citem,
+        target_item, event, item);
+
+  part = gst_editor_body_get_part (GST_EDITOR_BODY (citem), event->x, event->y);
+  if (part >= GST_EDITOR_BODY_PART_STATE)
+    return gst_editor_element_state_button_release_event (citem, target_item,
+        event, GINT_TO_POINTER (part - GST_EDITOR_BODY_PART_STATE));
+
+  return FALSE;
+}
+
+static gboolean
+gst_editor_element_body_motion_notify_event (GooCanvasItem * citem,
+    GooCanvasItem * target_item, GdkEventMotion * event, GstEditorItem * item)
+{
+  GstEditorBody *body = GST_EDITOR_BODY (citem);
+  gboolean highlight;
+
+  if (GST_EDITOR_ELEMENT (item)->resizing)
+    return gst_editor_element_resizebox_motion_notify_event (citem,
+        target_item, event, item);
+
+  highlight = gst_editor_body_get_part (body, event->x, event->y) ==
+      GST_EDITOR_BODY_PART_RESIZE;
+  if (highlight != body->resize_highlight)
+    g_object_set (body, "resize-highlight", highlight, NULL);
+
+  return FALSE;
+}
+
 static gboolean
 gst_editor_element_state_enter_notify_event (GooCanvasItem * citem,
     GooCanvasItem * target_item, GdkEventCrossing * event, gpointer user_data)
@@ -936,13 +1128,20 @@ gst_editor_element_state_button_press_event (GooCanvasItem * item,
 void
 gst_editor_element_stop_child (GstEditorElement * child)
 {
+  GooCanvas *canvas;
+
   if GST_IS_EDITOR_BIN(child){//make this recursive to work for bin inside bin too
         GstEditorBin *bin=GST_EDITOR_BIN(child);
-        GList *children;
-        children = bin->elements;
-        g_list_foreach (children, (GFunc) gst_editor_element_stop_child, NULL);
+        for (guint i = 0; i < bin->sort.len; i++)
+          gst_editor_element_stop_child (bin->sort.elements[i]);
         }
-  g_idle_add ((GSourceFunc) gst_editor_element_sync_state, &(child->item));
+
+  /* once per frame for the whole bin */
+  canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (child));
+  if (GST_IS_EDITOR_CANVAS (canvas))
+    gst_editor_canvas_queue_sync_state (GST_EDITOR_CANVAS (canvas), child);
+  else
+    g_idle_add ((GSourceFunc) gst_editor_element_sync_state, &(child->item));
 }
 
 
@@ -964,9 +1163,8 @@ gst_editor_element_state_button_release_event (GooCanvasItem * citem,
   //g_print("Button released %d\n",id);
   if (id == 0 && bin != NULL)   // it needs extra handling as there will be no message on the bus on change to NULL state...
   {
-    GList *children;
-    children = bin->elements;
-    g_list_foreach (children, (GFunc) gst_editor_element_stop_child, NULL);
+    for (guint i = 0; i < bin->sort.len; i++)
+      gst_editor_element_stop_child (bin->sort.elements[i]);
     gst_element_set_state (GST_ELEMENT (element->item.object), GST_STATE_NULL);
     g_idle_add ((GSourceFunc) gst_editor_element_sync_state, &(element->item));
 //  } else if (id == 0 && bin == NULL){//so any DAU hit stop directly on the element...
@@ -994,39 +1192,205 @@ gst_editor_element_state_button_release_event (GooCanvasItem * citem,
  * Callbacks from the gstelement (must be threadsafe)
  **********************************************************************/
 
+/* these only queue the pad, see gsteditordispatch.c */
 static void
 on_new_pad (GstElement * element, GstPad * pad,
     GstEditorElement * editor_element)
 {
-  g_rw_lock_writer_lock (GST_EDITOR_ITEM(editor_element)->globallock);
+  gst_editor_dispatch ((GstEditorDispatchFunc) gst_editor_element_pad_added,
+      editor_element, element, pad);
+}
+
+static void
+on_pad_removed (GstElement * element, GstPad * pad,
+    GstEditorElement * editor_element)
+{
+  gst_editor_dispatch ((GstEditorDispatchFunc) gst_editor_element_pad_removed,
+      editor_element, element, pad);
+}
+
+static gboolean
+gst_editor_element_new_pads_tick_cb (GtkWidget * widget,
+    GdkFrameClock * frame_clock, gpointer user_data)
+{
+  GstEditorElement *element = GST_EDITOR_ELEMENT (user_data);
+
+  element->new_pads_tick_id = 0;
+  gst_editor_element_flush_pads (element);
+
+  return G_SOURCE_REMOVE;
+}
+
+/*
+ * Demuxers may add hundreds of pads in a row. They are collected and
+ * added in one batch before the next frame, so the element is only
+ * repacked once (see gst_editor_element_flush_pads()).
+ */
+static void
+gst_editor_element_pad_added (GstEditorElement * editor_element,
+    GstElement * element, GstPad * pad)
+{
+  GooCanvas *canvas;
+
   GST_CAT_DEBUG (gste_debug_cat, "new_pad in element %s\n",
       GST_OBJECT_NAME (element));
 
-  gst_editor_element_add_pad (editor_element, pad);
-  gst_editor_item_resize (GST_EDITOR_ITEM (editor_element));
-  gst_editor_element_move(editor_element,0.0,0.0);
-  g_rw_lock_writer_unlock (GST_EDITOR_ITEM(editor_element)->globallock);  
+  /* unset by the time the record is run */
+  if (GST_EDITOR_ITEM (editor_element)->object != GST_OBJECT (element))
+    return;
+
+  g_ptr_array_add (editor_element->new_pads, gst_object_ref (pad));
+  if (editor_element->new_pads_tick_id)
+    return;
+
+  canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (editor_element));
+  if (!canvas || !gtk_widget_get_realized (GTK_WIDGET (canvas))) {
+    gst_editor_element_flush_pads (editor_element);
+    return;
+  }
+
+  editor_element->new_pads_tick_id =
+      gtk_widget_add_tick_callback (GTK_WIDGET (canvas),
+      gst_editor_element_new_pads_tick_cb, g_object_ref (editor_element),
+      g_object_unref);
+}
+
+/*
+ * Adds the pads collected by gst_editor_element_pad_added() now, and
+ * emits "pads-added" with those that were added.
+ */
+void
+gst_editor_element_flush_pads (GstEditorElement * element)
+{
+  GstObject *object;
+  GPtrArray *pads, *added;
+  GooCanvas *canvas;
+
+  g_return_if_fail (GST_IS_EDITOR_ELEMENT (element));
+
+  if (!element->new_pads || !element->new_pads->len)
+    return;
+
+  /* removing the tick callback drops its reference */
+  g_object_ref (element);
+  if (element->new_pads_tick_id) {
+    canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (element));
+    if (canvas)
+      gtk_widget_remove_tick_callback (GTK_WIDGET (canvas),
+          element->new_pads_tick_id);
+    element->new_pads_tick_id = 0;
+  }
+
+  /* pads added by the handlers are queued for the next frame */
+  pads = element->new_pads;
+  element->new_pads = g_ptr_array_new_with_free_func (gst_object_unref);
+
+  object = GST_EDITOR_ITEM (element)->object;
+  added = g_ptr_array_new ();
+  for (guint i = 0; i < pads->len; i++) {
+    GstPad *pad = g_ptr_array_index (pads, i);
+
+    /* removed again or already added, e.g. by a realize */
+    if (!object || GST_OBJECT_PARENT (pad) != object ||
+        gst_editor_item_get (GST_OBJECT (pad)))
+      continue;
+
+    gst_editor_element_add_pad (element, pad);
+    g_ptr_array_add (added, pad);
+  }
+
+  EDITOR_LOG ("element %s: added %u of %u new pads",
+      object ? GST_OBJECT_NAME (object) : "(none)", added->len, pads->len);
+
+  if (added->len) {
+    gst_editor_item_resize (GST_EDITOR_ITEM (element));
+    gst_editor_element_move(element,0.0,0.0);
+    g_signal_emit (element, gst_editor_element_signals[PADS_ADDED], 0, added);
+  }
+
+  g_ptr_array_unref (added);
+  g_ptr_array_unref (pads);
+  g_object_unref (element);
+}
+
+static gboolean
+is_template_pad (gpointer key, gpointer value, gpointer user_data)
+{
+  return value == user_data;
 }
 
 static void
-on_pad_removed (GstElement * element, GstPad * pad,
-    GstEditorElement * editor_element)
+gst_editor_element_template_pad_gone (gpointer data, GObject * pad)
+{
+  GstEditorElement *element = GST_EDITOR_ELEMENT (data);
+
+  g_hash_table_foreach_remove (element->template_pads, is_template_pad, pad);
+}
+
+/* see gst_editor_element_get_template_pad() */
+static void
+gst_editor_element_add_template_pad (GstEditorElement * element,
+    GstPadTemplate * pad_template, GstEditorPad * pad)
 {
-  g_rw_lock_writer_lock (GST_EDITOR_ITEM(editor_element)->globallock);
+  g_object_weak_ref (G_OBJECT (pad), gst_editor_element_template_pad_gone,
+      element);
+  g_hash_table_replace (element->template_pads,
+      g_strdup (GST_PAD_TEMPLATE_NAME_TEMPLATE (pad_template)), pad);
+}
+
+/* forgets the template pads, e.g. when the element's object changes */
+static void
+gst_editor_element_clear_template_pads (GstEditorElement * element)
+{
+  GHashTableIter iter;
+  gpointer pad;
+
+  g_hash_table_iter_init (&iter, element->template_pads);
+  while (g_hash_table_iter_next (&iter, NULL, &pad))
+    g_object_weak_unref (G_OBJECT (pad), gst_editor_element_template_pad_gone,
+        element);
+  g_hash_table_remove_all (element->template_pads);
+}
+
+/*
+ * Returns the pad representing the sometimes or request template
+ * named name_template, or NULL.
+ */
+GstEditorPad *
+gst_editor_element_get_template_pad (GstEditorElement * element,
+    const gchar * name_template)
+{
+  g_return_val_if_fail (GST_IS_EDITOR_ELEMENT (element), NULL);
+  g_return_val_if_fail (name_template != NULL, NULL);
+
+  if (!element->template_pads)
+    return NULL;
+  return g_hash_table_lookup (element->template_pads, name_template);
+}
+
+static void
+gst_editor_element_pad_removed (GstEditorElement * editor_element,
+    GstElement * element, GstPad * pad)
+{
+  GstEditorItem *editor_pad;
+
   GST_CAT_DEBUG (gste_debug_cat, "pad_removed in element %s\n",
       GST_OBJECT_NAME (element));
 
+  /* never added, or already gone with the element */
+  editor_pad = gst_editor_item_get (GST_OBJECT (pad));
+  if (!editor_pad || GST_EDITOR_ITEM (editor_element)->object !=
+      GST_OBJECT (element))
+    return;
+
   gst_editor_element_remove_pad (editor_element, pad);
   gst_editor_item_resize (GST_EDITOR_ITEM (editor_element));
 
-  GstEditorItem *editor_pad = gst_editor_item_get (GST_OBJECT (pad));
   g_object_set (editor_pad, "object", NULL, NULL);
 
   if (GST_EDITOR_PAD (editor_pad)->link)
     gst_editor_link_unlink (GST_EDITOR_PAD (editor_pad)->link);
   goo_canvas_item_remove (GOO_CANVAS_ITEM (editor_pad));
-
-  g_rw_lock_writer_unlock (GST_EDITOR_ITEM(editor_element)->globallock);  
 }
 
 #if 0
@@ -1106,10 +1470,12 @@ gst_editor_element_add_pad (GstEditorElement * element, GstPad * pad)
 //  goo_canvas_item_translate(editor_pad, bounds.x1, bounds.y1);
 
   if (GST_PAD_DIRECTION (pad) == GST_PAD_SINK) {
-    element->sinkpads = g_list_append (element->sinkpads, editor_pad);
+    g_queue_push_tail (&element->sinkpads, editor_pad);
+    GST_EDITOR_PAD (editor_pad)->element_link = element->sinkpads.tail;
     element->sinks++;
   } else {
-    element->srcpads = g_list_append (element->srcpads, editor_pad);
+    g_queue_push_tail (&element->srcpads, editor_pad);
+    GST_EDITOR_PAD (editor_pad)->element_link = element->srcpads.tail;
     element->srcs++;
   }
   //gst_editor_element_repack(GST_EDITOR_ITEM(element));
@@ -1147,7 +1513,7 @@ static void
 gst_editor_element_add_pads (GstEditorElement * element)
 {
   GstPadTemplate *pad_template;
-  GList *pad_templates, *l, *w, *reversed;
+  GList *pad_templates, *l, *reversed;
   GstEditorItem *item = GST_EDITOR_ITEM (element), *editor_pad;
   GstElement *e = GST_ELEMENT (item->object);
 
@@ -1170,31 +1536,10 @@ gst_editor_element_add_pads (GstEditorElement * element)
       case GST_ITERATOR_OK:
         /* NOTE: g_value_get_object() does not increase the refcount */
         pad = GST_PAD (g_value_get_object (&gitem));
-        pad_template = gst_pad_get_pad_template (pad);
-        /* 
-         * Go through the pad_templates list and remove the pad_template for
-         * this pad, rather than show both the pad and pad_template.
-         * Comment of Hannes: Why should we do this!?!?! We maybe want to edit the graph!!!
-         * TODO: rewrite it instead of just commenting out the code
-         */
-        if (pad_template) {
-          w = pad_templates;
-          EDITOR_LOG ("Trying to find pad template %s\n",
-              GST_OBJECT_NAME (pad_template));
-          while (w) {
-            if (g_ascii_strcasecmp (GST_OBJECT_NAME (w->data),
-                    GST_OBJECT_NAME (pad_template)) == 0) {
-              break;
-            }
-            w = g_list_next (w);
-          }
-          if (w) {
-            //pad_templates = g_list_remove_link (pad_templates, w);
-          }
-        } else {
+        /* both the pad and its template are shown */
+        if (!GST_PAD_PAD_TEMPLATE (pad))
           EDITOR_LOG ("Element %s: pad '%s' has no pad template",
               g_type_name (G_OBJECT_TYPE (e)), GST_OBJECT_NAME (pad));
-        }
 
         EDITOR_DEBUG ("adding pad %s to element %s",
             GST_OBJECT_NAME (pad), gst_element_get_name (e));
@@ -1244,12 +1589,16 @@ gst_editor_element_add_pads (GstEditorElement * element)
             type, "object", G_OBJECT (pad_template), NULL));
     gst_editor_pad_realize (GOO_CANVAS_ITEM (editor_pad));
 
+    gst_editor_element_add_template_pad (element, pad_template,
+        GST_EDITOR_PAD (editor_pad));
 
     if (GST_PAD_TEMPLATE_DIRECTION (pad_template) == GST_PAD_SINK) {
-      element->sinkpads = g_list_prepend (element->sinkpads, editor_pad);
+      g_queue_push_head (&element->sinkpads, editor_pad);
+      GST_EDITOR_PAD (editor_pad)->element_link = element->sinkpads.head;
       element->sinks++;
     } else {
-      element->srcpads = g_list_prepend (element->srcpads, editor_pad);
+      g_queue_push_head (&element->srcpads, editor_pad);
+      GST_EDITOR_PAD (editor_pad)->element_link = element->srcpads.head;
       element->srcs++;
     }
   }
@@ -1261,12 +1610,21 @@ static void
 gst_editor_element_remove_pad (GstEditorElement * element, GstPad * pad)
 {
   GstEditorItem *editor_pad = gst_editor_item_get (GST_OBJECT (pad));
+  GList *link;
+
+  if (!editor_pad)
+    return;
+
+  link = GST_EDITOR_PAD (editor_pad)->element_link;
+  GST_EDITOR_PAD (editor_pad)->element_link = NULL;
+  if (!link)
+    return;
 
   if (GST_PAD_DIRECTION (pad) == GST_PAD_SINK) {
-    element->sinkpads = g_list_remove (element->sinkpads, editor_pad);
+    g_queue_delete_link (&element->sinkpads, link);
     element->sinks--;
   } else {
-    element->srcpads = g_list_remove (element->srcpads, editor_pad);
+    g_queue_delete_link (&element->srcpads, link);
     element->srcs--;
   }
 }
@@ -1275,20 +1633,38 @@ static void
 gst_editor_element_set_state (GstEditorElement * element, GstState state)
 {
   GstEditorItem *item = GST_EDITOR_ITEM (element);
+  GstElement *object;
+  GError *error = NULL;
 
-  if (item->object)
-    gst_element_set_state (GST_ELEMENT (item->object), state);
+  if (!item->object)
+    return;
+
+  /* placeholders cannot change their state */
+  object = state > GST_STATE_NULL ?
+      gst_editor_element_instantiate (element, &error) :
+      GST_ELEMENT (item->object);
+  if (!object) {
+    g_warning ("Could not instantiate %s: %s",
+        GST_OBJECT_NAME (item->object), error->message);
+    g_error_free (error);
+    return;
+  }
+
+  gst_element_set_state (object, state);
 }
 
 static gboolean
 gst_editor_element_set_state_cb (GstEditorElement * element)
 {
-  //g_print("gst_editor_element_set_state_cb\n");
-  if (element->next_state != GST_STATE_VOID_PENDING)
-    gst_editor_element_set_state (element, element->next_state);
+  GstState state = element->next_state;
 
+  //g_print("gst_editor_element_set_state_cb\n");
+  /* instantiating a placeholder may destroy element */
   element->next_state = GST_STATE_VOID_PENDING;
   element->set_state_idle_id = 0;
+
+  if (state != GST_STATE_VOID_PENDING)
+    gst_editor_element_set_state (element, state);
   return FALSE;
 }
 
@@ -1304,7 +1680,6 @@ gst_editor_element_sync_state (GstEditorElement * element)
     g_print("Fixme: gst_editor_element_sync_state called with element that is no element!\n");
     return FALSE;
     }
-  g_rw_lock_writer_lock (GST_EDITOR_ITEM(element)->globallock);
   //g_print("Sync State!\n");
   gint id;
   GstEditorItem *item;
@@ -1315,7 +1690,6 @@ gst_editor_element_sync_state (GstEditorElement * element)
 
   if (item->object == NULL){
     g_print("Warning: Sync State Item Object Invalid!\n");
-    g_rw_lock_writer_unlock (GST_EDITOR_ITEM(element)->globallock);
     return FALSE;
   }
   state = GST_STATE (GST_ELEMENT (item->object));
@@ -1327,14 +1701,15 @@ gst_editor_element_sync_state (GstEditorElement * element)
   y2 = item->height;
 
   for (id = 0; id < 4; id++) {
-    if (_gst_element_states[id] == state) {
+    if (_gst_element_states[id] == state && item->compact) {
+      g_object_set (item->border, "state", id, NULL);
+    } else if (_gst_element_states[id] == state) {
       g_object_set (element->statebox,
           "x", x1 + (element->statewidth * id),
           "y", y2 - element->stateheight,
           "width", element->statewidth, "height", element->stateheight, NULL);
     }
   }
-  g_rw_lock_writer_unlock (GST_EDITOR_ITEM(element)->globallock);
   return FALSE;
 }
 
@@ -1452,6 +1827,8 @@ gst_editor_element_move (GstEditorElement * element, gdouble dx, gdouble dy)
   }
 
   gst_editor_item_move (GST_EDITOR_ITEM (element), dx, dy);
+  if (GST_IS_EDITOR_BIN (parent))
+    gst_editor_bin_sort_update (GST_EDITOR_BIN (parent), element);
   //g_print("finished moving element %p\n",element);
   //usleep(1);
 }
@@ -1509,3 +1886,55 @@ gst_editor_element_remove (GstEditorElement * element)
   gsth_element_unlink_all (e);
   gst_bin_remove (bin, e);
 }
+
+/*
+ * Replaces the placeholder (see gste-placeholder.h) element stands for
+ * or, for bins, all placeholders in it with real elements, keeping
+ * their positions. element may be destroyed in the process.
+ * Returns the element now in element's place or NULL on errors.
+ */
+GstElement *
+gst_editor_element_instantiate (GstEditorElement * element, GError ** error)
+{
+  GstEditorItem *item = GST_EDITOR_ITEM (element);
+
+  if (GSTE_IS_PLACEHOLDER (item->object)) {
+    GooCanvasItem *parent =
+        goo_canvas_item_get_parent (GOO_CANVAS_ITEM (element));
+
+    /* picked up by gst_editor_bin_element_added() */
+    if (GST_IS_EDITOR_BIN (parent) && GST_EDITOR_BIN (parent)->attributes) {
+      GstEditorItemAttr *attr = g_new0 (GstEditorItemAttr, 1);
+      gdouble scale, rotation;
+
+      goo_canvas_item_get_simple_transform (GOO_CANVAS_ITEM (element),
+          &attr->x, &attr->y, &scale, &rotation);
+      attr->w = item->width;
+      attr->h = item->height;
+      g_hash_table_replace (GST_EDITOR_BIN (parent)->attributes,
+          g_strdup (GST_OBJECT_NAME (item->object)), attr);
+    }
+
+    return gste_placeholder_instantiate (GSTE_PLACEHOLDER (item->object),
+        error);
+  }
+
+  if (GST_IS_EDITOR_BIN (element)) {
+    GstEditorBin *bin = GST_EDITOR_BIN (element);
+    /* instantiating the children modifies the sort state */
+    GPtrArray *children = g_ptr_array_new_with_free_func (g_object_unref);
+    gboolean ret = TRUE;
+
+    for (guint i = 0; i < bin->sort.len; i++)
+      g_ptr_array_add (children, g_object_ref (bin->sort.elements[i]));
+    for (guint i = 0; ret && i < children->len; i++)
+      ret = gst_editor_element_instantiate (g_ptr_array_index (children, i),
+          error) != NULL;
+    g_ptr_array_unref (children);
+
+    if (!ret)
+      return NULL;
+  }
+
+  return GST_ELEMENT (item->object);
+}
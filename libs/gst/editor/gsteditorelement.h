@@ -57,7 +57,7 @@ typedef struct _GstEditorElement
   gboolean resizeable;
   gboolean moveable;
 
-  GList *srcpads, *sinkpads;	/* list of pads */
+  GQueue srcpads, sinkpads;	/* GstEditorPads, see GstEditorPad::element_link */
   gboolean padlistchange;
 
   guint source;			/* the GSource id for gst_bin_iterate */
@@ -70,7 +70,13 @@ typedef struct _GstEditorElement
   GstState next_state;
 
   guint bus_id;
-  GRWLock rwlock; 
+
+  /* see gst_editor_element_flush_pads() */
+  GPtrArray *new_pads;		/* GstPads added since the last frame */
+  guint new_pads_tick_id;
+  GHashTable *template_pads;	/* name template -> GstEditorPad */
+
+  gint sort_index;		/* index into the parent bin's sort state or -1 */
 } GstEditorElement;
 
 typedef struct _GstEditorElementClass
@@ -79,6 +85,7 @@ typedef struct _GstEditorElementClass
 
   void (*position_changed) (GstEditorElement * element);
   void (*size_changed) (GstEditorElement * element);
+  void (*pads_added) (GstEditorElement * element, GPtrArray * pads);
 //gint (*event) (GnomeCanvasItem * item, GdkEvent * event,
 //      GstEditorElement * element);
   gint (*event) (GooCanvasItemSimple * item, GdkEvent * event,
@@ -96,6 +103,11 @@ void gst_editor_element_remove (GstEditorElement * element);
 void gst_editor_element_stop_child (GstEditorElement * child);
 
 gboolean gst_editor_element_sync_state (GstEditorElement * element);
+void gst_editor_element_flush_pads (GstEditorElement * element);
+struct _GstEditorPad *gst_editor_element_get_template_pad (GstEditorElement *
+    element, const gchar * name_template);
+GstElement *gst_editor_element_instantiate (GstEditorElement * element,
+    GError ** error);
 
 /*
  * FIXME: This is not used in the GstEditorElement class but only
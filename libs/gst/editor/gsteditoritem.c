@@ -32,6 +32,7 @@
 #include "gsteditorcanvas.h"
 #include "gsteditorelement.h"
 #include "gsteditoritem.h"
+#include "gsteditorbody.h"
 
 GST_DEBUG_CATEGORY (gste_item_debug);
 #define GST_CAT_DEFAULT gste_item_debug
@@ -58,12 +59,9 @@ static void gst_editor_item_object_changed (GstEditorItem * item,
 static void gst_editor_item_resize_real (GstEditorItem * item);
 static void gst_editor_item_repack_real (GstEditorItem * item);
 static void gst_editor_item_default_on_whats_this (GstEditorItem * item);
+static void gst_editor_item_set_dirty (GstEditorItem * item);
 
 
-/* callbacks on the parent item */
-static void on_parent_item_position_changed (GstEditorItem * parent,
-    GstEditorItem * item);
-
 /* popup callbacks */
 static void on_whats_this (GSimpleAction * action,
     GVariant * parameter, gpointer user_data);
@@ -115,6 +113,9 @@ gst_editor_item_update_title (GstEditorItem * item)
     g_object_set (G_OBJECT (item->title), "text", item->title_text, NULL);
     GST_DEBUG ("updated title of editor item to %s", item->title_text);
     }
+    else if (item->compact && item->border && item->object) {
+      g_object_set (G_OBJECT (item->border), "title", item->title_text, NULL);
+    }
     else GST_DEBUG ("did not updated title because editor element seems to be deleted");
 }
 
@@ -128,6 +129,30 @@ gst_editor_notify_name_cb (GstObject * object, GParamSpec * arg1,
 
   /* FIXME: we could do a block/unblock by_func, see mr project */
   gst_editor_item_update_title (item);
+  /* the metadata is saved by name */
+  gst_editor_item_set_dirty (item);
+}
+
+/*
+ * Notes that the metadata of item has to be saved again.
+ * Realized items are reported to their canvas.
+ */
+static void
+gst_editor_item_set_dirty (GstEditorItem * item)
+{
+  GooCanvas *canvas;
+
+  if (item->dirty)
+    return;
+  item->dirty = TRUE;
+
+  /* see gst_editor_item_realize() */
+  if (!item->realized)
+    return;
+
+  canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (item));
+  if (GST_IS_EDITOR_CANVAS (canvas))
+    gst_editor_canvas_mark_dirty (GST_EDITOR_CANVAS (canvas), item);
 }
 
 /* GOBject-y stuff */
@@ -245,6 +270,7 @@ gst_editor_item_init (GstEditorItem * item)
   item->height = 10;
   item->width = 30;
   item->textanchor = GOO_CANVAS_ANCHOR_NORTH_WEST;
+  item->dirty = TRUE;
 }
 
 static void
@@ -286,9 +312,11 @@ gst_editor_item_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case ARG_WIDTH:
       item->width = g_value_get_double (value);
+      gst_editor_item_set_dirty (item);
       break;
     case ARG_HEIGHT:
       item->height = g_value_get_double (value);
+      gst_editor_item_set_dirty (item);
       break;
     case ARG_OBJECT:
     {
@@ -362,10 +390,14 @@ gst_editor_item_get_property (GObject * object, guint prop_id, GValue * value,
 gst_editor_item_realize (GooCanvasItem * citem)
 {
   GstEditorItem *item = GST_EDITOR_ITEM (citem);
-  GooCanvasItem *cparent;
 
-  item->border =
-      goo_canvas_rect_new (citem, 0., 0., 0., 0.,
+  if (item->compact) {
+    item->border = gst_editor_body_new (citem);
+    g_object_set (item->border, "title", item->title_text, NULL);
+  } else {
+    item->border = goo_canvas_rect_new (citem, 0., 0., 0., 0., NULL);
+  }
+  g_object_set (item->border,
       "line-width", 1., "fill-color-rgba", item->fill_color,
       "stroke-color-rgba", item->outline_color, "antialias",
       CAIRO_ANTIALIAS_NONE, NULL);
@@ -379,26 +411,48 @@ gst_editor_item_realize (GooCanvasItem * citem)
       goo_canvas_item_lower (item->border, NULL);
   g_return_if_fail (item->border != NULL);
   GST_EDITOR_SET_OBJECT (item->border, item);
-  item->title =
-      goo_canvas_text_new (citem, NULL, 0, 0, -1,
-          GOO_CANVAS_ANCHOR_NW, "font", "Sans", "fill-color", "black", NULL);
-  g_return_if_fail (item->title != NULL);
-  g_object_set (G_OBJECT (item->title), "text", item->title_text, NULL);
-  GST_EDITOR_SET_OBJECT (item->title, item);
+  if (!item->compact) {
+    item->title =
+        goo_canvas_text_new (citem, NULL, 0, 0, -1,
+            GOO_CANVAS_ANCHOR_NW, "font", "Sans", "fill-color", "black", NULL);
+    g_return_if_fail (item->title != NULL);
+    g_object_set (G_OBJECT (item->title), "text", item->title_text, NULL);
+    GST_EDITOR_SET_OBJECT (item->title, item);
+    gst_editor_item_set_detail (item->title);
+  }
 
   item->realized = TRUE;
 
-  /* emission of position-changed on a parent item will propogate to all
-     children */
-  cparent = goo_canvas_item_get_parent (citem);
-  if (GST_IS_EDITOR_ITEM (cparent))
-    g_signal_connect (cparent, "position-changed",
-        G_CALLBACK (on_parent_item_position_changed), citem);
+  /* new items are dirty, see gst_editor_item_set_dirty() */
+  if (item->dirty) {
+    GooCanvas *canvas = goo_canvas_item_get_canvas (citem);
+
+    if (GST_IS_EDITOR_CANVAS (canvas))
+      gst_editor_canvas_mark_dirty (GST_EDITOR_CANVAS (canvas), item);
+  }
 
   if (G_OBJECT_TYPE (item) == GST_TYPE_EDITOR_ITEM)
     gst_editor_item_resize (item);
 }
 
+/*
+ * Marks citem as a detail that is neither painted nor picked when
+ * zoomed out below GST_EDITOR_CANVAS_DETAIL_SCALE.
+ * Items hidden with goo_canvas_item_simple_hide() stay hidden.
+ */
+void
+gst_editor_item_set_detail (GooCanvasItem * citem)
+{
+  GooCanvasItemVisibility visibility;
+
+  g_object_get (citem, "visibility", &visibility, NULL);
+  g_object_set (citem, "visibility-threshold", GST_EDITOR_CANVAS_DETAIL_SCALE,
+      NULL);
+  if (visibility > GOO_CANVAS_ITEM_INVISIBLE)
+    g_object_set (citem, "visibility",
+        GOO_CANVAS_ITEM_VISIBLE_ABOVE_THRESHOLD, NULL);
+}
+
 static void
 gst_editor_item_resize_real (GstEditorItem * item)
 {
@@ -423,6 +477,11 @@ gst_editor_item_resize_real (GstEditorItem * item)
     itemheight = bounds.y2 - bounds.y1;
     item->t.w += itemwidth + 2.0;
     item->t.h = MAX (item->t.h, itemheight + 2.0);
+  } else if (item->compact && item->border) {
+    gst_editor_body_get_title_size (GST_EDITOR_BODY (item->border),
+        &itemwidth, &itemheight);
+    item->t.w += itemwidth + 2.0;
+    item->t.h = MAX (item->t.h, itemheight + 2.0);
   }
 
   /* force the thing to grow if necessary */
@@ -435,6 +494,7 @@ gst_editor_item_resize_real (GstEditorItem * item)
       MAX (MAX (MAX (item->t.w, item->b.w), item->l.w + item->r.w), item->width);
   item->height =
       MAX (MAX (item->l.h, item->r.h) + item->t.h + item->b.h, item->height);
+  gst_editor_item_set_dirty (item);
 //g_print("nearly finished resize %p\n",item);
   GST_EDITOR_ITEM_CLASS (G_OBJECT_GET_CLASS (item))->repack (item);
 //g_print("finished resize\n");
@@ -452,8 +512,9 @@ gst_editor_item_repack_real (GstEditorItem * item)
       item->width, "height", item->height, NULL);
 
   /* move the text to the right place */ 
-  g_object_set (G_OBJECT (item->title), "x", item->textx, "y", item->texty,
-      "anchor", item->textanchor, NULL);
+  if (item->title)
+    g_object_set (G_OBJECT (item->title), "x", item->textx, "y", item->texty,
+        "anchor", item->textanchor, NULL);
 }
 
 static void
@@ -572,6 +633,21 @@ gst_editor_item_save (GstEditorItem * item, GsteSerializeFlags flags)
   return g_string_free (ctx.pipeline, FALSE);
 }
 
+/*
+ * Like gst_editor_item_save(), but writes the serialization
+ * to stream without building it in memory first.
+ */
+gboolean
+gst_editor_item_save_to_stream (GstEditorItem * item, GOutputStream * stream,
+    GsteSerializeFlags flags, GError ** error)
+{
+  GsteSerializeSink *sink = gste_serialize_sink_new (stream);
+
+  gste_serialize_save_to_sink (item->object, flags, sink, NULL, NULL);
+
+  return gste_serialize_sink_free (sink, error);
+}
+
 void
 gst_editor_item_save_with_metadata (GstEditorItem * item, GKeyFile * key_file,
     GsteSerializeFlags flags)
@@ -584,6 +660,7 @@ gst_editor_item_save_with_metadata (GstEditorItem * item, GKeyFile * key_file,
    * one section per element meta data.
    * GstEditor/Version will contain the program version which may
    * be used to check the save file for compatibility on loading.
+   * Editors save in the background instead (see gsteditorautosave.c).
    */
   ctx.pipeline = g_string_new ("");
   /* we do not take over `key_file`'s ownership */
@@ -610,7 +687,8 @@ gst_editor_item_save_with_metadata (GstEditorItem * item, GKeyFile * key_file,
    * settings can be restored on loading -- we do not usually
    * prompt for file name and settings again.
    */
-  g_key_file_set_integer (key_file, PACKAGE_NAME, "Flags", flags);
+  g_key_file_set_integer (key_file, PACKAGE_NAME, "Flags",
+      flags & ~GSTE_SERIALIZE_CACHE);
 
   gste_serialize_save (item->object, flags,
       serialize_append_cb, serialize_object_saved_cb, &ctx);
@@ -624,19 +702,6 @@ gst_editor_item_save_with_metadata (GstEditorItem * item, GKeyFile * key_file,
       "Autosize", canvas->autosize);
 }
 
-/**********************************************************************
- * Callbacks on the parent editor item
- **********************************************************************/
-
-static void
-on_parent_item_position_changed (GstEditorItem * parent, GstEditorItem * item)
-{
-  g_return_if_fail (item != parent);
-
-  g_signal_emit (G_OBJECT (item), gst_editor_item_signals[POSITION_CHANGED], 0,
-      NULL);
-}
-
 /**********************************************************************
  * Popup menu callbacks
  **********************************************************************/
@@ -694,9 +759,11 @@ gst_editor_item_get (GstObject * object)
 void
 gst_editor_item_disconnect (GstEditorItem * parent,GstEditorItem * child)
 {
+  GooCanvas *canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (child));
 
-  g_signal_handlers_disconnect_by_func (G_OBJECT (parent),
-        on_parent_item_position_changed, child);
+  /* forget a pending move, see gst_editor_canvas_queue_move() */
+  if (GST_IS_EDITOR_CANVAS (canvas) && GST_EDITOR_CANVAS (canvas)->moved)
+    g_hash_table_remove (GST_EDITOR_CANVAS (canvas)->moved, child);
   return;
 }
 
@@ -707,16 +774,92 @@ gst_editor_item_hash_remove (GstObject * object)
   return;
 }
 
+static gboolean
+gst_editor_item_motion_tick_cb (GtkWidget * widget,
+    GdkFrameClock * frame_clock, gpointer user_data)
+{
+  GstEditorItem *item = GST_EDITOR_ITEM (user_data);
+
+  item->motion_tick_id = 0;
+  GST_EDITOR_ITEM_CLASS (G_OBJECT_GET_CLASS (item))->motion (item,
+      item->motion_x, item->motion_y);
+
+  return G_SOURCE_REMOVE;
+}
+
+/*
+ * Queues a pointer motion of a drag on item. However many motion events
+ * arrive, the class' motion method is only called once per frame, with
+ * the latest position.
+ */
+void
+gst_editor_item_queue_motion (GstEditorItem * item, gdouble x, gdouble y)
+{
+  GooCanvas *canvas;
+
+  g_return_if_fail (GST_IS_EDITOR_ITEM (item));
+  g_return_if_fail (GST_EDITOR_ITEM_CLASS (G_OBJECT_GET_CLASS (item))->motion);
+
+  item->motion_x = x;
+  item->motion_y = y;
+  if (item->motion_tick_id)
+    return;
+
+  canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (item));
+  if (!canvas || !gtk_widget_get_realized (GTK_WIDGET (canvas))) {
+    GST_EDITOR_ITEM_CLASS (G_OBJECT_GET_CLASS (item))->motion (item, x, y);
+    return;
+  }
+
+  item->motion_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (canvas),
+      gst_editor_item_motion_tick_cb, g_object_ref (item), g_object_unref);
+}
+
+/* Applies a queued motion now, e.g. before ending the drag. */
+void
+gst_editor_item_flush_motion (GstEditorItem * item)
+{
+  GooCanvas *canvas;
+
+  g_return_if_fail (GST_IS_EDITOR_ITEM (item));
+
+  if (!item->motion_tick_id)
+    return;
+
+  /* removing the tick callback drops its reference */
+  g_object_ref (item);
+  canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (item));
+  if (canvas)
+    gtk_widget_remove_tick_callback (GTK_WIDGET (canvas),
+        item->motion_tick_id);
+  item->motion_tick_id = 0;
+
+  GST_EDITOR_ITEM_CLASS (G_OBJECT_GET_CLASS (item))->motion (item,
+      item->motion_x, item->motion_y);
+  g_object_unref (item);
+}
+
+/*
+ * Moves item by dx, dy. position-changed is emitted on the item and its
+ * pads once per frame, however often it is moved (see
+ * gst_editor_canvas_queue_move()).
+ */
 void
 gst_editor_item_move (GstEditorItem * item, gdouble dx, gdouble dy)
 {
+  GooCanvas *canvas;
+
   g_return_if_fail (GST_IS_EDITOR_ITEM (item));
 
   if (!item->object)
     g_print("Warning, item: %p has no object\n",item);
   goo_canvas_item_translate (GOO_CANVAS_ITEM (item), dx, dy);
-//g_print("translate finished, emitting signal\n");  
-  g_signal_emit ((GObject *) item, gst_editor_item_signals[POSITION_CHANGED], 0,
-      item);
-//g_print("Signal emitted\n");  
+  gst_editor_item_set_dirty (item);
+
+  canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (item));
+  if (GST_IS_EDITOR_CANVAS (canvas))
+    gst_editor_canvas_queue_move (GST_EDITOR_CANVAS (canvas), item);
+  else
+    g_signal_emit ((GObject *) item, gst_editor_item_signals[POSITION_CHANGED],
+        0);
 }
@@ -90,6 +90,8 @@ typedef struct _GstEditorItem
   /* visual stuff */
   GooCanvasItem *border;
   GooCanvasItem *title;
+  /* border is a GstEditorBody that also paints the title */
+  gboolean compact;
 
   gulong notify_cb_id;		/* for element property notification */
 
@@ -102,12 +104,21 @@ typedef struct _GstEditorItem
 
   gboolean resize;
   gboolean realized;
+  /*
+   * moved, resized or renamed since the metadata was last saved,
+   * see gst_editor_canvas_mark_dirty()
+   */
+  gboolean dirty;
 
   /* these apply to the border */
   guint32 fill_color;
   guint32 outline_color;
 
   GRWLock *globallock;
+
+  /* latest pointer position of a drag, see gst_editor_item_queue_motion() */
+  gdouble motion_x, motion_y;
+  guint motion_tick_id;
 } GstEditorItem;
 
 typedef struct _GstEditorItemClass
@@ -121,6 +132,8 @@ typedef struct _GstEditorItemClass
 
   /* virtual method, does not chain up */
   void (*whats_this) (GstEditorItem * item);
+  /* applies a drag, see gst_editor_item_queue_motion() */
+  void (*motion) (GstEditorItem * item, gdouble x, gdouble y);
 
   GMenu *gmenu;
 } GstEditorItemClass;
@@ -139,10 +152,14 @@ void gst_editor_item_resize (GstEditorItem * item);
 void gst_editor_item_repack (GstEditorItem * item);
 GstEditorItem *gst_editor_item_get (GstObject * object);
 void gst_editor_item_move (GstEditorItem * item, gdouble dx, gdouble dy);
+void gst_editor_item_queue_motion (GstEditorItem * item, gdouble x, gdouble y);
+void gst_editor_item_flush_motion (GstEditorItem * item);
 void gst_editor_item_disconnect (GstEditorItem * parent, GstEditorItem * child);
 void gst_editor_item_hash_remove (GstObject * object);
 
 gchar *gst_editor_item_save (GstEditorItem * item, GsteSerializeFlags flags);
+gboolean gst_editor_item_save_to_stream (GstEditorItem * item,
+    GOutputStream * stream, GsteSerializeFlags flags, GError ** error);
 void gst_editor_item_save_with_metadata (GstEditorItem * item, GKeyFile * key_file,
     GsteSerializeFlags flags);
 
@@ -152,4 +169,6 @@ void gst_editor_item_save_with_metadata (GstEditorItem * item, GKeyFile * key_fi
  */
 void gst_editor_item_realize (GooCanvasItem * citem);
 
+void gst_editor_item_set_detail (GooCanvasItem * citem);
+
 #endif /* __GST_EDITOR_ITEM_H__ */
@@ -0,0 +1,799 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Force-directed layout of GstEditorBins.
+ *
+ * The layout iterates on a snapshot of the bins' sort states
+ * (see GstEditorBinSortState) in a separate thread, so the canvas
+ * stays responsive. The repulsion forces of large bins are split
+ * across a pool of worker threads. Finished frames are applied to
+ * the canvas items from a tick callback, i.e. at most once per
+ * frame of the canvas' frame clock.
+ *
+ * Every bin is cooled down individually (see gst_editor_layout_cool()),
+ * so bins that have converged stop being laid out while others
+ * are still busy.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+
+#include "gsteditorlink.h"
+#include "gsteditorelement.h"
+#include "gsteditoritem.h"
+#include "gsteditorbin.h"
+#include "gsteditorcanvas.h"
+#include "gsteditorlayout.h"
+
+GST_DEBUG_CATEGORY_STATIC (gste_layout_debug);
+#define GST_CAT_DEFAULT gste_layout_debug
+
+/* initial step size */
+#define LAYOUT_STEP 0.1
+/* initial maximum step size */
+#define LAYOUT_STEP_MAX 0.2
+/* lower bound of the adaptive step size (until the maximum decays below) */
+#define LAYOUT_STEP_MIN 0.005
+/* factor to adapt the step size by */
+#define LAYOUT_COOLING 0.9
+/* number of iterations with decreasing energy before the step grows again */
+#define LAYOUT_PROGRESS 5
+/* decay of the maximum step size per iteration */
+#define LAYOUT_DECAY 0.995
+/* a bin has converged if the children moved less than LAYOUT_EPSILON
+   pixels on average for LAYOUT_CALM_ITERATIONS iterations */
+#define LAYOUT_EPSILON 0.05
+#define LAYOUT_CALM_ITERATIONS 5
+/* give up if the layout did not converge after this many iterations */
+#define LAYOUT_MAX_ITERATIONS 2000
+/* minimum number of elements per worker thread job */
+#define LAYOUT_CHUNK_SIZE 128
+
+/*
+ * Uniform grid over the element centers.
+ * Elements in cells that are not adjacent cannot repel each other.
+ */
+typedef struct _LayoutGrid
+{
+  gint cols, rows;
+  gdouble minx, miny, cw, ch;
+
+  gint *cell;                   /* cell of every element */
+  gint *cell_start;             /* first index into order of every cell */
+  gint *order;                  /* elements sorted by cell */
+} LayoutGrid;
+
+typedef struct _LayoutLink
+{
+  /* indices into the bin's state or -1 for elements outside the bin */
+  gint src, sink;
+  /* link end points relative to src/sink or absolute */
+  gdouble x1, y1, x2, y2;
+} LayoutLink;
+
+typedef struct _LayoutBin
+{
+  GstEditorBin *bin;
+
+  /* private copy of the bin's sort state */
+  GstEditorBinSortState state;
+  /* area available to the children */
+  gdouble minx, miny, maxx, maxy;
+
+  LayoutLink *links;
+  guint n_links;
+
+  LayoutGrid grid;
+
+  /* last published positions (protected by frame_lock) */
+  gdouble *px, *py;
+  guint frame;                  /* frame px/py have been published in */
+  gboolean stepped;             /* not settled in the last iteration */
+} LayoutBin;
+
+typedef struct _LayoutChunk
+{
+  LayoutBin *lbin;
+  guint start, end;
+} LayoutChunk;
+
+struct _GstEditorLayout
+{
+  GstEditorCanvas *canvas;
+  GPtrArray *bins;              /* LayoutBin */
+
+  GThread *thread;
+  gint cancelled, finished;
+
+  /* worker threads for the repulsion forces */
+  GThreadPool *pool;
+  guint n_threads;
+  LayoutChunk *chunks;
+  GMutex lock;
+  GCond cond;
+  guint pending;
+
+  /* frame publishing */
+  GMutex frame_lock;
+  guint frame, applied_frame;
+  guint tick_id;
+
+  GstEditorLayoutFinishedCallback finished_cb;
+  gpointer user_data;
+};
+
+/**********************************************************************
+ * Force model
+ **********************************************************************/
+
+static void
+layout_grid_build (LayoutGrid * grid, const GstEditorBinSortState * s)
+{
+  gint num_children = s->len;
+  gint i, ncells;
+  gdouble maxx, maxy, maxw, maxh;
+  gint *cell_fill;
+
+  grid->minx = grid->miny = G_MAXDOUBLE;
+  maxx = maxy = -G_MAXDOUBLE;
+  maxw = maxh = 0;
+  for (i = 0; i < num_children; i++) {
+    gdouble x = s->x[i] + s->w[i] * 0.5;
+    gdouble y = s->y[i] + s->h[i] * 0.5;
+
+    grid->minx = MIN (grid->minx, x);
+    maxx = MAX (maxx, x);
+    grid->miny = MIN (grid->miny, y);
+    maxy = MAX (maxy, y);
+    maxw = MAX (maxw, s->w[i]);
+    maxh = MAX (maxh, s->h[i]);
+  }
+
+  /* cells must be at least as large as the repulsion range */
+  grid->cw = maxw + 15;
+  grid->ch = maxh + 5;
+  grid->cols = (gint) ((maxx - grid->minx) / grid->cw) + 1;
+  grid->rows = (gint) ((maxy - grid->miny) / grid->ch) + 1;
+
+  /* widely scattered elements would result in a sparse grid: grow the
+     cells (which never drops any pairs) until the grid stays small */
+  while ((gint64) grid->cols * grid->rows > 4 * (gint64) num_children) {
+    grid->cw *= 2;
+    grid->ch *= 2;
+    grid->cols = (gint) ((maxx - grid->minx) / grid->cw) + 1;
+    grid->rows = (gint) ((maxy - grid->miny) / grid->ch) + 1;
+  }
+  ncells = grid->cols * grid->rows;
+
+  /* counting sort of the elements by cell */
+  grid->cell = g_renew (gint, grid->cell, num_children);
+  grid->order = g_renew (gint, grid->order, num_children);
+  g_free (grid->cell_start);
+  grid->cell_start = g_new0 (gint, ncells + 1);
+  cell_fill = g_new0 (gint, ncells);
+
+  for (i = 0; i < num_children; i++) {
+    gint cx = (gint) ((s->x[i] + s->w[i] * 0.5 - grid->minx) / grid->cw);
+    gint cy = (gint) ((s->y[i] + s->h[i] * 0.5 - grid->miny) / grid->ch);
+
+    grid->cell[i] = CLAMP (cy, 0, grid->rows - 1) * grid->cols +
+        CLAMP (cx, 0, grid->cols - 1);
+    grid->cell_start[grid->cell[i] + 1]++;
+  }
+  for (i = 0; i < ncells; i++)
+    grid->cell_start[i + 1] += grid->cell_start[i];
+  for (i = 0; i < num_children; i++)
+    grid->order[grid->cell_start[grid->cell[i]] + cell_fill[grid->cell[i]]++] =
+        i;
+
+  g_free (cell_fill);
+}
+
+static void
+layout_grid_clear (LayoutGrid * grid)
+{
+  g_free (grid->cell);
+  g_free (grid->cell_start);
+  g_free (grid->order);
+  memset (grid, 0, sizeof (LayoutGrid));
+}
+
+/* elements repel each other in direct proportion to the degree that they
+   overlap in the x and y directions. This repulsion starts when elements get
+   closer than 15 pixels away in the x direction, and 5 in the y direction.
+   If only_i is set, only the force on element i is accumulated, which
+   allows computing the forces of disjunct elements in parallel. Ties are
+   broken by index so both variants push elements in the same directions. */
+static inline void
+layout_pair_force (GstEditorBinSortState * s, gint i, gint j, gboolean only_i)
+{
+  gdouble fx, fy;
+  gdouble x1, y1, x2, y2;
+  gdouble sx, sy;
+
+  /* we want the coordinates of the centers of the elements */
+  x1 = s->x[i] + s->w[i] * 0.5;
+  x2 = s->x[j] + s->w[j] * 0.5;
+  y1 = s->y[i] + s->h[i] * 0.5;
+  y2 = s->y[j] + s->h[j] * 0.5;
+
+  /* x distance more important than y distance */
+  fx = (0.5 * (s->w[i] + s->w[j]) + 15 - ABS (x2 - x1)) * 1.5;
+  fy = (0.5 * (s->h[i] + s->h[j]) + 5 - ABS (y2 - y1)) * 1.5;
+
+  if (fx <= 0 || fy <= 0)
+    return;
+
+  sx = x1 > x2 || (x1 == x2 && i > j) ? 1.0 : -1.0;
+  sy = y1 > y2 || (y1 == y2 && i > j) ? 1.0 : -1.0;
+
+  s->fx[i] += fx * sx;
+  s->fy[i] += fy * sy;
+  if (!only_i) {
+    s->fx[j] -= fx * sx;
+    s->fy[j] -= fy * sy;
+  }
+}
+
+/*
+ * Accumulates the repulsion forces of the elements [start, end).
+ * If pairwise is set, every pair of elements is handled only once
+ * (updating both elements) which requires start == 0 and end == len.
+ */
+static void
+layout_grid_forces (const LayoutGrid * grid, GstEditorBinSortState * s,
+    guint start, guint end, gboolean pairwise)
+{
+  for (guint i = start; i < end; i++) {
+    gint cx = grid->cell[i] % grid->cols;
+    gint cy = grid->cell[i] / grid->cols;
+
+    for (gint ny = MAX (cy - 1, 0); ny <= MIN (cy + 1, grid->rows - 1); ny++) {
+      for (gint nx = MAX (cx - 1, 0); nx <= MIN (cx + 1, grid->cols - 1); nx++) {
+        gint c = ny * grid->cols + nx;
+
+        for (gint k = grid->cell_start[c]; k < grid->cell_start[c + 1]; k++) {
+          gint j = grid->order[k];
+
+          if (pairwise ? j > (gint) i : j != (gint) i)
+            layout_pair_force (s, i, j, !pairwise);
+        }
+      }
+    }
+  }
+}
+
+/*
+ * Accumulates the element repulsion forces of a bin into s->fx and s->fy.
+ */
+void
+gst_editor_layout_repulsion_forces (GstEditorBinSortState * s)
+{
+  LayoutGrid grid = { 0 };
+
+  /* the grid does not pay off for a handful of elements */
+  if (s->len < 16) {
+    for (guint i = 0; i < s->len; i++)
+      for (guint j = i + 1; j < s->len; j++)
+        layout_pair_force (s, i, j, FALSE);
+    return;
+  }
+
+  layout_grid_build (&grid, s);
+  layout_grid_forces (&grid, s, 0, s->len, TRUE);
+  layout_grid_clear (&grid);
+}
+
+/*
+ * Resets the step size and convergence of a bin, e.g. when its
+ * children have been changed.
+ */
+void
+gst_editor_layout_heat (GstEditorBinSortState * s)
+{
+  s->step = LAYOUT_STEP;
+  s->max_step = LAYOUT_STEP_MAX;
+  s->energy = G_MAXDOUBLE;
+  s->progress = s->calm = 0;
+  s->settled = s->subtree_settled = FALSE;
+}
+
+/*
+ * Adapts the step size of a bin after an iteration.
+ * energy is the sum of the absolute forces and movement the distance
+ * the children have actually been moved.
+ *
+ * The step shrinks whenever the energy does not decrease and grows
+ * again after a couple of iterations of steady progress. On top of
+ * that the maximum step decays, so oscillating layouts settle in a
+ * bounded number of iterations, too.
+ */
+void
+gst_editor_layout_cool (GstEditorBinSortState * s, gdouble energy,
+    gdouble movement)
+{
+  if (energy < s->energy) {
+    if (++s->progress >= LAYOUT_PROGRESS) {
+      s->progress = 0;
+      s->step /= LAYOUT_COOLING;
+    }
+  } else {
+    s->progress = 0;
+    s->step *= LAYOUT_COOLING;
+  }
+  s->energy = energy;
+
+  s->max_step *= LAYOUT_DECAY;
+  s->step = CLAMP (s->step, MIN (LAYOUT_STEP_MIN, s->max_step), s->max_step);
+
+  if (movement < LAYOUT_EPSILON * s->len)
+    s->calm++;
+  else
+    s->calm = 0;
+  s->settled = s->calm >= LAYOUT_CALM_ITERATIONS;
+}
+
+static void
+layout_copy_cooling (GstEditorBinSortState * dest,
+    const GstEditorBinSortState * src)
+{
+  dest->step = src->step;
+  dest->max_step = src->max_step;
+  dest->energy = src->energy;
+  dest->progress = src->progress;
+  dest->calm = src->calm;
+  dest->settled = src->settled;
+}
+
+/**********************************************************************
+ * Layout thread
+ **********************************************************************/
+
+static void
+layout_chunk_func (gpointer data, gpointer user_data)
+{
+  LayoutChunk *chunk = data;
+  GstEditorLayout *layout = user_data;
+
+  layout_grid_forces (&chunk->lbin->grid, &chunk->lbin->state,
+      chunk->start, chunk->end, FALSE);
+
+  g_mutex_lock (&layout->lock);
+  if (--layout->pending == 0)
+    g_cond_signal (&layout->cond);
+  g_mutex_unlock (&layout->lock);
+}
+
+static void
+layout_repulsion_forces_parallel (GstEditorLayout * layout, LayoutBin * lbin)
+{
+  GstEditorBinSortState *s = &lbin->state;
+  guint n_chunks, chunk_size;
+
+  layout_grid_build (&lbin->grid, s);
+
+  n_chunks = MIN (layout->n_threads, s->len / LAYOUT_CHUNK_SIZE);
+  chunk_size = (s->len + n_chunks - 1) / n_chunks;
+
+  g_mutex_lock (&layout->lock);
+  layout->pending = n_chunks;
+  g_mutex_unlock (&layout->lock);
+
+  for (guint i = 0; i < n_chunks; i++) {
+    layout->chunks[i].lbin = lbin;
+    layout->chunks[i].start = i * chunk_size;
+    layout->chunks[i].end = MIN ((i + 1) * chunk_size, s->len);
+    g_thread_pool_push (layout->pool, &layout->chunks[i], NULL);
+  }
+
+  g_mutex_lock (&layout->lock);
+  while (layout->pending > 0)
+    g_cond_wait (&layout->cond, &layout->lock);
+  g_mutex_unlock (&layout->lock);
+}
+
+/* links are ideally 20 pixels long and horizontal. The force is directly
+   proportional to the 'stretching' of the links. */
+static void
+layout_link_forces (LayoutBin * lbin)
+{
+  GstEditorBinSortState *s = &lbin->state;
+
+  for (guint i = 0; i < lbin->n_links; i++) {
+    LayoutLink *l = &lbin->links[i];
+    gdouble x1 = l->x1, y1 = l->y1, x2 = l->x2, y2 = l->y2;
+    gdouble fx, fy;
+
+    if (l->src >= 0) {
+      x1 += s->x[l->src];
+      y1 += s->y[l->src];
+    }
+    if (l->sink >= 0) {
+      x2 += s->x[l->sink];
+      y2 += s->y[l->sink];
+    }
+
+    fx = (x2 - x1 - 20) * 0.5;
+    fy = (y2 - y1) * 0.5;
+
+    if (l->src >= 0) {
+      s->fx[l->src] += fx;
+      s->fy[l->src] += fy;
+    }
+    if (l->sink >= 0) {
+      s->fx[l->sink] -= fx;
+      s->fy[l->sink] -= fy;
+    }
+  }
+}
+
+/*
+ * Performs one iteration on a bin's snapshot like gst_editor_bin_sort().
+ */
+static void
+layout_bin_step (GstEditorLayout * layout, LayoutBin * lbin)
+{
+  GstEditorBinSortState *s = &lbin->state;
+  gdouble energy = 0, movement = 0;
+
+  if (s->len == 0) {
+    s->settled = TRUE;
+    return;
+  }
+
+  memset (s->fx, 0, s->len * sizeof (gdouble));
+  memset (s->fy, 0, s->len * sizeof (gdouble));
+
+  layout_link_forces (lbin);
+  if (layout->pool && s->len >= 2 * LAYOUT_CHUNK_SIZE)
+    layout_repulsion_forces_parallel (layout, lbin);
+  else
+    gst_editor_layout_repulsion_forces (s);
+
+  /* do the moving, staying within the bin like gst_editor_element_move() */
+  for (guint i = 0; i < s->len; i++) {
+    gdouble x = s->x[i], y = s->y[i];
+
+    energy += ABS (s->fx[i]) + ABS (s->fy[i]);
+
+    s->x[i] = CLAMP (x + s->fx[i] * s->step,
+        lbin->minx, MAX (lbin->minx, lbin->maxx - s->w[i]));
+    s->y[i] = CLAMP (y + s->fy[i] * s->step,
+        lbin->miny, MAX (lbin->miny, lbin->maxy - s->h[i]));
+
+    movement += ABS (s->x[i] - x) + ABS (s->y[i] - y);
+  }
+
+  gst_editor_layout_cool (s, energy, movement);
+}
+
+static void
+layout_publish (GstEditorLayout * layout)
+{
+  g_mutex_lock (&layout->frame_lock);
+  layout->frame++;
+  for (guint i = 0; i < layout->bins->len; i++) {
+    LayoutBin *lbin = g_ptr_array_index (layout->bins, i);
+
+    if (!lbin->stepped)
+      continue;
+
+    memcpy (lbin->px, lbin->state.x, lbin->state.len * sizeof (gdouble));
+    memcpy (lbin->py, lbin->state.y, lbin->state.len * sizeof (gdouble));
+    lbin->frame = layout->frame;
+  }
+  g_mutex_unlock (&layout->frame_lock);
+}
+
+static gpointer
+layout_thread_func (gpointer user_data)
+{
+  GstEditorLayout *layout = user_data;
+  guint iteration;
+
+  for (iteration = 0; iteration < LAYOUT_MAX_ITERATIONS &&
+      !g_atomic_int_get (&layout->cancelled); iteration++) {
+    guint active = 0;
+
+    for (guint i = 0; i < layout->bins->len; i++) {
+      LayoutBin *lbin = g_ptr_array_index (layout->bins, i);
+
+      lbin->stepped = !lbin->state.settled;
+      if (lbin->stepped) {
+        layout_bin_step (layout, lbin);
+        active++;
+      }
+    }
+
+    if (!active)
+      break;
+    layout_publish (layout);
+  }
+
+  GST_DEBUG ("layout finished after %u iterations", iteration);
+
+  g_atomic_int_set (&layout->finished, TRUE);
+  return NULL;
+}
+
+/**********************************************************************
+ * Main thread
+ **********************************************************************/
+
+static void
+layout_apply (GstEditorLayout * layout)
+{
+  g_mutex_lock (&layout->frame_lock);
+
+  if (layout->frame == layout->applied_frame) {
+    g_mutex_unlock (&layout->frame_lock);
+    return;
+  }
+
+  for (guint i = 0; i < layout->bins->len; i++) {
+    LayoutBin *lbin = g_ptr_array_index (layout->bins, i);
+    GstEditorBinSortState *s = &lbin->bin->sort;
+
+    /* nothing new since the last frame */
+    if (lbin->frame <= layout->applied_frame)
+      continue;
+
+    g_rw_lock_writer_lock (GST_EDITOR_ITEM (lbin->bin)->globallock);
+
+    for (guint j = 0; j < lbin->state.len; j++) {
+      GstEditorElement *element = lbin->state.elements[j];
+      gint index = element->sort_index;
+
+      /* the element might have been removed in the meantime */
+      if (index < 0 || (guint) index >= s->len || s->elements[index] != element)
+        continue;
+
+      gst_editor_element_move (element,
+          lbin->px[j] - s->x[index], lbin->py[j] - s->y[index]);
+    }
+
+    g_rw_lock_writer_unlock (GST_EDITOR_ITEM (lbin->bin)->globallock);
+  }
+
+  layout->applied_frame = layout->frame;
+  g_mutex_unlock (&layout->frame_lock);
+}
+
+/*
+ * Keeps the convergence state, so the converged bins are skipped
+ * by the next layout.
+ */
+static void
+layout_store_cooling (GstEditorLayout * layout)
+{
+  for (guint i = 0; i < layout->bins->len; i++) {
+    LayoutBin *lbin = g_ptr_array_index (layout->bins, i);
+
+    /* the children might have changed in the meantime */
+    if (lbin->bin->sort.len == lbin->state.len)
+      layout_copy_cooling (&lbin->bin->sort, &lbin->state);
+  }
+}
+
+static gboolean
+layout_tick_cb (GtkWidget * widget, GdkFrameClock * frame_clock,
+    gpointer user_data)
+{
+  GstEditorLayout *layout = user_data;
+  /* the last frame is published before finished gets set */
+  gboolean finished = g_atomic_int_get (&layout->finished);
+
+  layout_apply (layout);
+
+  if (!finished)
+    return G_SOURCE_CONTINUE;
+
+  layout_store_cooling (layout);
+
+  /* the callback is allowed to stop (free) the layout */
+  layout->tick_id = 0;
+  if (layout->finished_cb)
+    layout->finished_cb (layout, layout->user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+layout_add_bin (GstEditorLayout * layout, GstEditorBin * bin)
+{
+  GstEditorItem *item = GST_EDITOR_ITEM (bin);
+  GstEditorBinSortState *s;
+  LayoutBin *lbin;
+  guint len = bin->sort.len;
+  GHashTableIter iter;
+  gpointer l;
+
+  /* nothing left to do in this subtree */
+  if (bin->sort.subtree_settled)
+    return;
+
+  lbin = g_new0 (LayoutBin, 1);
+  lbin->bin = g_object_ref (bin);
+
+  s = &lbin->state;
+  layout_copy_cooling (s, &bin->sort);
+  s->len = s->allocated = len;
+  s->elements = g_memdup (bin->sort.elements, len * sizeof (GstEditorElement *));
+  s->x = g_memdup (bin->sort.x, len * sizeof (gdouble));
+  s->y = g_memdup (bin->sort.y, len * sizeof (gdouble));
+  s->w = g_memdup (bin->sort.w, len * sizeof (gdouble));
+  s->h = g_memdup (bin->sort.h, len * sizeof (gdouble));
+  s->fx = g_new0 (gdouble, len);
+  s->fy = g_new0 (gdouble, len);
+  lbin->px = g_new (gdouble, len);
+  lbin->py = g_new (gdouble, len);
+
+  lbin->minx = item->l.w;
+  lbin->miny = item->t.h;
+  lbin->maxx = item->width - item->r.w;
+  lbin->maxy = item->height - item->b.h;
+
+  lbin->links = g_new0 (LayoutLink, g_hash_table_size (bin->links));
+  g_hash_table_iter_init (&iter, bin->links);
+  while (g_hash_table_iter_next (&iter, &l, NULL)) {
+    GstEditorLink *link = GST_EDITOR_LINK (l);
+    LayoutLink *ll = &lbin->links[lbin->n_links];
+    GooCanvasItem *src, *sink;
+
+    /* links that are currently dragged */
+    if (!link->srcpad || !link->sinkpad)
+      continue;
+
+    src = goo_canvas_item_get_parent (GOO_CANVAS_ITEM (link->srcpad));
+    sink = goo_canvas_item_get_parent (GOO_CANVAS_ITEM (link->sinkpad));
+
+    g_object_get (link, "x1", &ll->x1, "y1", &ll->y1,
+        "x2", &ll->x2, "y2", &ll->y2, NULL);
+
+    /* links may lead to elements outside of this bin (ghost pads) */
+    ll->src = goo_canvas_item_get_parent (src) == GOO_CANVAS_ITEM (bin) ?
+        GST_EDITOR_ELEMENT (src)->sort_index : -1;
+    ll->sink = goo_canvas_item_get_parent (sink) == GOO_CANVAS_ITEM (bin) ?
+        GST_EDITOR_ELEMENT (sink)->sort_index : -1;
+
+    if (ll->src >= 0) {
+      ll->x1 -= s->x[ll->src];
+      ll->y1 -= s->y[ll->src];
+    }
+    if (ll->sink >= 0) {
+      ll->x2 -= s->x[ll->sink];
+      ll->y2 -= s->y[ll->sink];
+    }
+
+    lbin->n_links++;
+  }
+
+  g_ptr_array_add (layout->bins, lbin);
+
+  for (guint i = 0; i < len; i++) {
+    g_object_ref (s->elements[i]);
+
+    if (GST_IS_EDITOR_BIN (s->elements[i]))
+      layout_add_bin (layout, GST_EDITOR_BIN (s->elements[i]));
+  }
+}
+
+static void
+layout_bin_free (LayoutBin * lbin)
+{
+  GstEditorBinSortState *s = &lbin->state;
+
+  for (guint i = 0; i < s->len; i++)
+    g_object_unref (s->elements[i]);
+  g_object_unref (lbin->bin);
+
+  g_free (s->elements);
+  g_free (s->x);
+  g_free (s->y);
+  g_free (s->w);
+  g_free (s->h);
+  g_free (s->fx);
+  g_free (s->fy);
+  g_free (lbin->px);
+  g_free (lbin->py);
+  g_free (lbin->links);
+  layout_grid_clear (&lbin->grid);
+
+  g_free (lbin);
+}
+
+/**********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/*
+ * Starts laying out bin and all of its child bins in the background.
+ * Must be called from the main thread.
+ */
+GstEditorLayout *
+gst_editor_layout_start (GstEditorBin * bin,
+    GstEditorLayoutFinishedCallback finished, gpointer user_data)
+{
+  GstEditorLayout *layout;
+
+  g_return_val_if_fail (GST_IS_EDITOR_BIN (bin), NULL);
+
+  if (G_UNLIKELY (!gste_layout_debug))
+    GST_DEBUG_CATEGORY_INIT (gste_layout_debug, "GSTE_LAYOUT", 0,
+        "GStreamer Editor Layout");
+
+  layout = g_new0 (GstEditorLayout, 1);
+  layout->canvas =
+      GST_EDITOR_CANVAS (goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (bin)));
+  layout->finished_cb = finished;
+  layout->user_data = user_data;
+
+  layout->bins = g_ptr_array_new_with_free_func ((GDestroyNotify) layout_bin_free);
+  g_rw_lock_reader_lock (GST_EDITOR_ITEM (bin)->globallock);
+  layout_add_bin (layout, bin);
+  g_rw_lock_reader_unlock (GST_EDITOR_ITEM (bin)->globallock);
+
+  g_mutex_init (&layout->lock);
+  g_cond_init (&layout->cond);
+  g_mutex_init (&layout->frame_lock);
+
+  layout->n_threads = g_get_num_processors ();
+  if (layout->n_threads > 1) {
+    layout->pool = g_thread_pool_new (layout_chunk_func, layout,
+        layout->n_threads, TRUE, NULL);
+    layout->chunks = g_new (LayoutChunk, layout->n_threads);
+  }
+
+  layout->tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (layout->canvas),
+      layout_tick_cb, layout, NULL);
+  layout->thread = g_thread_new ("gste-layout", layout_thread_func, layout);
+
+  return layout;
+}
+
+/*
+ * Stops the layout (if it is still running) and frees it.
+ * Positions that have already been applied to the canvas are kept.
+ */
+void
+gst_editor_layout_stop (GstEditorLayout * layout)
+{
+  g_atomic_int_set (&layout->cancelled, TRUE);
+  g_thread_join (layout->thread);
+
+  if (layout->tick_id)
+    gtk_widget_remove_tick_callback (GTK_WIDGET (layout->canvas),
+        layout->tick_id);
+
+  if (layout->pool)
+    g_thread_pool_free (layout->pool, FALSE, TRUE);
+  g_free (layout->chunks);
+
+  g_ptr_array_free (layout->bins, TRUE);
+
+  g_mutex_clear (&layout->lock);
+  g_cond_clear (&layout->cond);
+  g_mutex_clear (&layout->frame_lock);
+
+  g_free (layout);
+}
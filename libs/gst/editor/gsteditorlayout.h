@@ -0,0 +1,47 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef __GST_EDITOR_LAYOUT_H__
+#define __GST_EDITOR_LAYOUT_H__
+
+#include <glib.h>
+
+#include "gsteditorbin.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GstEditorLayout GstEditorLayout;
+
+/*
+ * Invoked in the main thread once the layout has converged
+ * and the last frame has been applied to the canvas.
+ */
+typedef void (*GstEditorLayoutFinishedCallback) (GstEditorLayout * layout,
+    gpointer user_data);
+
+void gst_editor_layout_repulsion_forces (GstEditorBinSortState * s);
+void gst_editor_layout_heat (GstEditorBinSortState * s);
+void gst_editor_layout_cool (GstEditorBinSortState * s, gdouble energy,
+    gdouble movement);
+
+GstEditorLayout *gst_editor_layout_start (GstEditorBin * bin,
+    GstEditorLayoutFinishedCallback finished, gpointer user_data);
+void gst_editor_layout_stop (GstEditorLayout * layout);
+
+G_END_DECLS
+
+#endif /* __GST_EDITOR_LAYOUT_H__ */
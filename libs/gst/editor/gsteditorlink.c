@@ -28,10 +28,13 @@
 #include "gst-helper.h"
 #include "gsteditorpad.h"
 #include "gsteditorlink.h"
+#include "gsteditorlinklayer.h"
+#include "gsteditordispatch.h"
 
 /* class functions */
 static void gst_editor_link_class_init (GstEditorLinkClass * klass);
 static void gst_editor_link_init (GstEditorLink * link);
+static void gst_editor_link_dispose (GObject * object);
 
 static void gst_editor_link_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -41,7 +44,11 @@ static void gst_editor_link_resize (GstEditorLink * link);
 
 /* callbacks from gstreamer */
 static void on_pad_unlink (GstPad * pad, GstPad * peer, GstEditorLink * link);
-static void on_new_pad (GstElement * element, GstPad * pad,
+static void gst_editor_link_pad_unlinked (GstEditorLink * link, GstPad * pad,
+    GstPad * peer);
+
+/* callbacks from editor elements */
+static void on_pads_added (GstEditorElement * element, GPtrArray * pads,
     GstEditorLink * link);
 
 /* callbacks from editor pads */
@@ -50,6 +57,10 @@ static void on_editor_pad_position_changed (GstEditorPad * pad,
 
 /* utility */
 static void make_dynamic_link (GstEditorLink * link);
+static GstEditorBin *gst_editor_link_get_bin (GstEditorBin * srcbin,
+    GstEditorBin * sinkbin);
+static void gst_editor_link_set_layer (GstEditorLink * link,
+    GstEditorBin * bin);
 
 
 enum
@@ -108,6 +119,7 @@ gst_editor_link_class_init (GstEditorLinkClass * klass)
   object_class = G_OBJECT_CLASS (klass);
   parent_class = g_type_class_ref (goo_canvas_polyline_get_type ());
 
+  object_class->dispose = gst_editor_link_dispose;
   object_class->set_property = gst_editor_link_set_property;
   object_class->get_property = gst_editor_link_get_property;
 
@@ -144,11 +156,23 @@ static void
 gst_editor_link_init (GstEditorLink * link)
 {
   link->points = goo_canvas_points_new (2);
+  link->layer_index = -1;
   
 //   goo_canvas_item_raise_pos ((GooCanvasItem *) link, 10);
   goo_canvas_item_raise ((GooCanvasItem *) link, NULL);
 }
 
+static void
+gst_editor_link_dispose (GObject * object)
+{
+  GstEditorLink *link = GST_EDITOR_LINK (object);
+
+  if (link->layer)
+    gst_editor_link_layer_remove (link->layer, link);
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
 static void
 gst_editor_link_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -363,7 +387,7 @@ gst_editor_link_get_property (GObject * object, guint prop_id, GValue * value,
 /*static*/ void
 gst_editor_link_realize (GooCanvasItem * citem)
 {
-  GooCanvasLineDash * dash;
+  GooCanvas *canvas;
   if ((citem == NULL) || (!GST_EDITOR_LINK (citem))) {
     g_print (
         "Warning: gst_editor_link_realize failed because citem %p is no "
@@ -379,23 +403,45 @@ gst_editor_link_realize (GooCanvasItem * citem)
   link->points->coords[3] = 0.0;
 
 /* we need to be realized before setting properties */
-  dash = goo_canvas_line_dash_new (2, 5.0, 5.0);
-
   /* see goo-canvas-line.h for the docs */
   g_object_set (G_OBJECT (citem), "points", link->points, "line-width", 2.0,
-      "line-dash", dash, "start-arrow", TRUE, NULL);
-  goo_canvas_line_dash_unref (dash);
+      NULL);
+  canvas = goo_canvas_item_get_canvas (citem);
+  gst_editor_link_set_detailed (link, !GST_IS_EDITOR_CANVAS (canvas) ||
+      GST_EDITOR_CANVAS (canvas)->detailed);
 
   //  goo_canvas_item_raise_pos (citem, 10);
   goo_canvas_item_raise (citem, NULL);
 }
 
+/*
+ * Draws link dashed with an arrow or, when zoomed out, as a plain line
+ * which is much cheaper to paint.
+ */
+void
+gst_editor_link_set_detailed (GstEditorLink * link, gboolean detailed)
+{
+  GooCanvasLineDash *dash = NULL;
+
+  /* the layer decides on its own, see gst_editor_link_layer_paint() */
+  if (link->layer)
+    return;
+
+  if (detailed)
+    dash = goo_canvas_line_dash_new (2, 5.0, 5.0);
+  g_object_set (G_OBJECT (link), "line-dash", dash, "start-arrow", detailed,
+      NULL);
+  if (dash)
+    goo_canvas_line_dash_unref (dash);
+}
+
 static void
 gst_editor_link_resize (GstEditorLink * link)
 {
   gdouble x1, y1, x2, y2;
 
   GooCanvas * canvas;
+  GooCanvasItem * space;
 
   g_object_get (link, "x1", &x1, "y1", &y1, "x2", &x2, "y2", &y2, NULL);
   canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (link));
@@ -403,16 +449,23 @@ gst_editor_link_resize (GstEditorLink * link)
     g_print ("Warning: gst_editor_link_resize canvas null\n");
     return;
   }
+  /* once linked, the line is painted by the bin's link layer */
+  space = link->layer ? GOO_CANVAS_ITEM (link->layer) : GOO_CANVAS_ITEM (link);
+
   goo_canvas_convert_from_pixels (canvas, &x1, &y1);
-  goo_canvas_convert_to_item_space (canvas, GOO_CANVAS_ITEM (link), &x1, &y1);
+  goo_canvas_convert_to_item_space (canvas, space, &x1, &y1);
 
   // goo_canvas_item_get_parent(GOO_CANVAS_ITEM (link)),&x1, &y1);
   goo_canvas_convert_from_pixels (canvas, &x2, &y2);
-  goo_canvas_convert_to_item_space (canvas, GOO_CANVAS_ITEM (link), &x2, &y2);
+  goo_canvas_convert_to_item_space (canvas, space, &x2, &y2);
 
   // goo_canvas_item_get_parent(GOO_CANVAS_ITEM (link)), &x2, &y2);
   /* we do this in reverse so that with dot-dash lines it gives the illusion of
      pulling out a rope from the element */
+  if (link->layer) {
+    gst_editor_link_layer_set_segment (link->layer, link, x2, y2, x1, y1);
+    return;
+  }
   link->points->coords[2] = x1;
   link->points->coords[3] = y1;
   link->points->coords[0] = x2;
@@ -420,19 +473,25 @@ gst_editor_link_resize (GstEditorLink * link)
   g_object_set (G_OBJECT (link), "points", link->points, NULL);
 }
 
+/*
+ * May be called from a streaming thread, see gsteditordispatch.c.
+ * Both pads of a link emit "unlinked".
+ */
 static void
 on_pad_unlink (GstPad * pad, GstPad * peer, GstEditorLink * link)
 {
-  GRWLock *globallock;
-  if ((GST_IS_EDITOR_LINK (link)) && (GST_IS_EDITOR_PAD (link->srcpad))) {
-    globallock = GST_EDITOR_ITEM (link->srcpad)->globallock;
-  } else if ((GST_IS_EDITOR_LINK (link)) && (GST_IS_EDITOR_PAD (link->sinkpad))) {
-    globallock = GST_EDITOR_ITEM (link->sinkpad)->globallock;
-  } else {
-    g_print ("Warning: On pad unlink without any valid Pads called!!!!");
+  gst_editor_dispatch ((GstEditorDispatchFunc) gst_editor_link_pad_unlinked,
+      link, pad, peer);
+}
+
+static void
+gst_editor_link_pad_unlinked (GstEditorLink * link, GstPad * pad,
+    GstPad * peer)
+{
+  /* already handled for the other pad */
+  if (!GST_IS_EDITOR_PAD (link->srcpad) && !GST_IS_EDITOR_PAD (link->sinkpad))
     return;
-  }
-  g_rw_lock_writer_lock (globallock);
+
   g_print ("Unlink pad signal (%s:%s from %s:%s) with link %p",
       GST_DEBUG_PAD_NAME (pad), GST_DEBUG_PAD_NAME (peer), link);
   GstEditorBin *srcbin = NULL, *sinkbin = NULL;
@@ -473,11 +532,11 @@ on_pad_unlink (GstPad * pad, GstPad * peer, GstEditorLink * link)
   g_print (
       "Removing links from bin; srcbin: %p, sinkbin %p\n", srcbin, sinkbin);
   if (sinkbin)
-    sinkbin->links = g_list_remove (sinkbin->links, link);
+    g_hash_table_remove (sinkbin->links, link);
   else
     g_print ("Warning: On_pad_unlink: Sinkbin not valid\n");
   if ((sinkbin != srcbin) && (srcbin))
-    srcbin->links = g_list_remove (srcbin->links, link);
+    g_hash_table_remove (srcbin->links, link);
   else
     g_print ("Warning: On_pad_unlink: Srcbin not validor same as Sinkbin\n");
   if (link->ghost) {
@@ -491,7 +550,8 @@ on_pad_unlink (GstPad * pad, GstPad * peer, GstEditorLink * link)
     if (link->sinkpad)
       GST_EDITOR_PAD (link->sinkpad)->link = NULL;
   }
-  g_rw_lock_writer_unlock (globallock);
+  if (link->layer)
+    gst_editor_link_layer_remove (link->layer, link);
   link->srcpad = NULL;
   link->sinkpad = NULL;
   /* i have bad luck with actually killing the GCI's */
@@ -654,9 +714,12 @@ gst_editor_link_link (GstEditorLink * link)
       if (GST_IS_EDITOR_BIN (item))
         sinkbin = GST_EDITOR_BIN (item);
       if (sinkbin)
-        sinkbin->links = g_list_prepend (sinkbin->links, link);
+        g_hash_table_add (sinkbin->links, link);
       if (srcbin && sinkbin != srcbin)
-        srcbin->links = g_list_prepend (srcbin->links, link);
+        g_hash_table_add (srcbin->links, link);
+
+      gst_editor_link_set_layer (link, gst_editor_link_get_bin (srcbin,
+              sinkbin));
 
       return TRUE;
     }
@@ -683,7 +746,9 @@ gst_editor_link_destroy (GstEditorLink * link)
   else
     padbin = GST_EDITOR_BIN (goo_canvas_item_get_parent (
         goo_canvas_item_get_parent (GOO_CANVAS_ITEM (link->sinkpad))));
-  padbin->links = g_list_remove (padbin->links, link);
+  g_hash_table_remove (padbin->links, link);
+  if (link->layer)
+    gst_editor_link_layer_remove (link->layer, link);
   if (link->srcpad)
     GST_EDITOR_PAD (link->srcpad)->link = NULL;
   if (link->sinkpad)
@@ -726,10 +791,12 @@ gst_editor_link_unlink (GstEditorLink * link)
   } else {
     /* we must have a dynamic link, then.. */
 
-    g_signal_handlers_disconnect_by_func (link->srcpad->object,
-        on_new_pad, link);
-    g_signal_handlers_disconnect_by_func (link->sinkpad->object,
-        on_new_pad, link);
+    g_signal_handlers_disconnect_by_func (
+        goo_canvas_item_get_parent (GOO_CANVAS_ITEM (link->srcpad)),
+        on_pads_added, link);
+    g_signal_handlers_disconnect_by_func (
+        goo_canvas_item_get_parent (GOO_CANVAS_ITEM (link->sinkpad)),
+        on_pads_added, link);
 
     on_pad_unlink (NULL, NULL, link);
   }
@@ -745,37 +812,44 @@ gst_editor_link_unlink (GstEditorLink * link)
   /* 'link' is now invalid */
 }
 
-/* this function is only linked for dynamic links */
+/*
+ * This function is only connected for dynamic links. The new pads of an
+ * element arrive in batches (see gst_editor_element_flush_pads()).
+ */
 static void
-on_new_pad (GstElement * element, GstPad * pad, GstEditorLink * link)
+on_pads_added (GstEditorElement * element, GPtrArray * pads,
+    GstEditorLink * link)
 {
-  GstPadTemplate *src = NULL, *sink = NULL;
-
-  if (GST_IS_EDITOR_PAD_SOMETIMES (link->srcpad))
-    src = GST_PAD_TEMPLATE (link->srcpad->object);
+  /* unlinked in the meantime */
+  if (!link->srcpad || !link->sinkpad)
+    return;
 
-  if (GST_IS_EDITOR_PAD_SOMETIMES (link->sinkpad))
-    sink = GST_PAD_TEMPLATE (link->sinkpad->object);
+  g_message ("%u new pads", pads->len);
+  for (guint i = 0; i < pads->len; i++) {
+    GstPad *pad = g_ptr_array_index (pads, i);
+    GstEditorPad *template_pad;
 
-  g_message ("new pad");
-  if (pad->padtemplate) {
-    g_message ("from a template");
+    if (!pad->padtemplate)
+      continue;
 
     /* can't do pointer comparison -- some templates appear to be from the
-       elementfactories, some from template factories... have to compare
-       names */
-    if (src &&
-        g_ascii_strcasecmp (
-            pad->padtemplate->name_template, src->name_template) == 0)
+       elementfactories, some from template factories... so the template
+       pads are looked up by name */
+    template_pad = gst_editor_element_get_template_pad (element,
+        pad->padtemplate->name_template);
+    if (!template_pad)
+      continue;
+
+    if ((GstEditorItem *) template_pad == link->srcpad &&
+        GST_IS_EDITOR_PAD_SOMETIMES (link->srcpad))
       g_object_set (G_OBJECT (GOO_CANVAS_ITEM (link)), "src-pad",
           gst_editor_item_get (GST_OBJECT (pad)), NULL);
-    else if (sink &&
-             g_ascii_strcasecmp (
-                 pad->padtemplate->name_template, sink->name_template) == 0)
+    else if ((GstEditorItem *) template_pad == link->sinkpad &&
+        GST_IS_EDITOR_PAD_SOMETIMES (link->sinkpad))
       g_object_set (G_OBJECT (GOO_CANVAS_ITEM (link)), "sink-pad",
           gst_editor_item_get (GST_OBJECT (pad)), NULL);
     else
-      return;
+      continue;
 
     g_message ("we made it, now let's link");
 
@@ -784,33 +858,76 @@ on_new_pad (GstElement * element, GstPad * pad, GstEditorLink * link)
     gst_editor_link_link (link);
     /*gst_element_set_state ((GstElement *)
        gst_element_get_managing_bin (element), GST_STATE_PLAYING); */
+    return;
   }
 }
 
 static void
 make_dynamic_link (GstEditorLink * link)
 {
-  GstElement *srce, *sinke;
-  GstPadTemplate *src = NULL, *sink = NULL;
-
-  if (GST_IS_EDITOR_PAD_SOMETIMES (link->srcpad))
-    src = GST_PAD_TEMPLATE (link->srcpad->object);
+  GooCanvasItem *srce, *sinke;
+  gboolean src, sink;
 
-  if (GST_IS_EDITOR_PAD_SOMETIMES (link->sinkpad))
-    sink = GST_PAD_TEMPLATE (link->sinkpad->object);
-  srce =
-      GST_ELEMENT (GST_EDITOR_ITEM (goo_canvas_item_get_parent (GOO_CANVAS_ITEM
-              (link->srcpad)))->object);
-  sinke =
-      GST_ELEMENT (GST_EDITOR_ITEM (goo_canvas_item_get_parent (GOO_CANVAS_ITEM
-              (link->sinkpad)))->object);
+  src = GST_IS_EDITOR_PAD_SOMETIMES (link->srcpad);
+  sink = GST_IS_EDITOR_PAD_SOMETIMES (link->sinkpad);
+  srce = goo_canvas_item_get_parent (GOO_CANVAS_ITEM (link->srcpad));
+  sinke = goo_canvas_item_get_parent (GOO_CANVAS_ITEM (link->sinkpad));
 
   g_return_if_fail (src || sink);
 
+  /* the editor elements have added the pads by the time they emit this */
   if (src)
-    g_signal_connect_after (srce, "pad-added", G_CALLBACK (on_new_pad), link);
+    g_signal_connect_object (srce, "pads-added", G_CALLBACK (on_pads_added),
+        link, 0);
   if (sink)
-    g_signal_connect_after (sinke, "pad-added", G_CALLBACK (on_new_pad), link);
+    g_signal_connect_object (sinke, "pads-added", G_CALLBACK (on_pads_added),
+        link, 0);
 
   g_print ("dynamic link\n");
 }
+
+/* the innermost of the bins containing the pads of a link */
+static GstEditorBin *
+gst_editor_link_get_bin (GstEditorBin * srcbin, GstEditorBin * sinkbin)
+{
+  GooCanvasItem *item;
+
+  if (!srcbin || !sinkbin)
+    return srcbin ? srcbin : sinkbin;
+
+  /* a ghost link between a bin's ghost pad and one of its children */
+  for (item = GOO_CANVAS_ITEM (srcbin); item;
+      item = goo_canvas_item_get_parent (item))
+    if (item == GOO_CANVAS_ITEM (sinkbin))
+      return srcbin;
+
+  return sinkbin;
+}
+
+/*
+ * Hands the line of an established link over to the link layer of bin,
+ * see gsteditorlinklayer.c. The polyline itself is only painted while
+ * dragging a new link.
+ */
+static void
+gst_editor_link_set_layer (GstEditorLink * link, GstEditorBin * bin)
+{
+  GstEditorLinkLayer *layer = bin ? bin->link_layer : NULL;
+
+  if (link->layer == layer)
+    return;
+
+  if (link->layer)
+    gst_editor_link_layer_remove (link->layer, link);
+
+  if (layer) {
+    gst_editor_link_layer_add (layer, link);
+    g_object_set (G_OBJECT (link), "visibility", GOO_CANVAS_ITEM_HIDDEN,
+        NULL);
+  } else {
+    g_object_set (G_OBJECT (link), "visibility", GOO_CANVAS_ITEM_VISIBLE,
+        NULL);
+  }
+
+  gst_editor_link_resize (link);
+}
@@ -54,6 +54,10 @@ typedef struct _GstEditorLink
   GooCanvasPoints *points;
 
   gdouble x, y;			/* terminating point    */
+
+  /* the GstEditorLinkLayer painting us once linked, or NULL */
+  struct _GstEditorLinkLayer *layer;
+  gint layer_index;		/* index into the layer's segments or -1 */
 } GstEditorLink;
 
 typedef struct _GstEditorLinkClass
@@ -65,6 +69,7 @@ GType gst_editor_link_get_type (void);
 gboolean gst_editor_link_link (GstEditorLink * link);
 void gst_editor_link_destroy(GstEditorLink * link);
 void gst_editor_link_unlink (GstEditorLink * link);
+void gst_editor_link_set_detailed (GstEditorLink * link, gboolean detailed);
 
 /*
  * FIXME: Realize handler used in other compilation
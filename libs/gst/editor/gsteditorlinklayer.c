@@ -0,0 +1,422 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Batched rendering of GstEditorLinks.
+ *
+ * A GstEditorLink used to be painted as a GooCanvasPolyline of its own,
+ * so moving an element with many links caused as many property
+ * notifications, bounds computations and redraw requests. Once linked,
+ * a GstEditorLink hands its line over to the GstEditorLinkLayer of its
+ * bin (see gst_editor_link_link()). The layer lives in the bin's
+ * coordinate space, so links inside a bin do not change at all when the
+ * bin itself is moved. Segments that do change are only marked dirty;
+ * they are measured and invalidated in the next canvas update, which
+ * GooCanvasItemSimple would otherwise do for the whole layer.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include <goocanvas.h>
+
+#include "gsteditorcanvas.h"
+#include "gsteditorlinklayer.h"
+
+/* the GooCanvasPolyline arrow defaults, in line widths */
+#define ARROW_LENGTH 5.0
+#define ARROW_WIDTH 4.0
+#define ARROW_TIP_LENGTH 4.0
+
+/* pad positions converted to pixels and back are not exact */
+#define SEGMENT_EPSILON 1e-6
+
+static void canvas_item_interface_init (GooCanvasItemIface * iface);
+
+G_DEFINE_TYPE_WITH_CODE (GstEditorLinkLayer, gst_editor_link_layer,
+    GOO_TYPE_CANVAS_ITEM_SIMPLE,
+    G_IMPLEMENT_INTERFACE (GOO_TYPE_CANVAS_ITEM, canvas_item_interface_init));
+
+static GooCanvasItemIface *parent_iface;
+
+static void
+gst_editor_link_layer_init (GstEditorLinkLayer * layer)
+{
+  layer->segments = g_array_new (FALSE, FALSE, sizeof (GstEditorLinkSegment));
+}
+
+static void
+gst_editor_link_layer_dispose (GObject * object)
+{
+  GstEditorLinkLayer *layer = GST_EDITOR_LINK_LAYER (object);
+
+  /* the links outlive the bin's items, see unset_deepdelete_editor() */
+  for (guint i = 0; i < layer->segments->len; i++) {
+    GstEditorLink *link =
+        g_array_index (layer->segments, GstEditorLinkSegment, i).link;
+
+    link->layer = NULL;
+    link->layer_index = -1;
+  }
+  g_array_set_size (layer->segments, 0);
+  layer->n_dirty = 0;
+
+  G_OBJECT_CLASS (gst_editor_link_layer_parent_class)->dispose (object);
+}
+
+static void
+gst_editor_link_layer_finalize (GObject * object)
+{
+  GstEditorLinkLayer *layer = GST_EDITOR_LINK_LAYER (object);
+
+  g_array_unref (layer->segments);
+
+  G_OBJECT_CLASS (gst_editor_link_layer_parent_class)->finalize (object);
+}
+
+static gboolean
+bounds_is_empty (const GooCanvasBounds * bounds)
+{
+  return bounds->x1 >= bounds->x2 || bounds->y1 >= bounds->y2;
+}
+
+static void
+bounds_union (GooCanvasBounds * bounds, const GooCanvasBounds * other)
+{
+  if (bounds_is_empty (other))
+    return;
+
+  if (bounds_is_empty (bounds)) {
+    *bounds = *other;
+    return;
+  }
+
+  bounds->x1 = MIN (bounds->x1, other->x1);
+  bounds->y1 = MIN (bounds->y1, other->y1);
+  bounds->x2 = MAX (bounds->x2, other->x2);
+  bounds->y2 = MAX (bounds->y2, other->y2);
+}
+
+static void
+gst_editor_link_layer_request_redraw (GstEditorLinkLayer * layer,
+    const GooCanvasBounds * bounds)
+{
+  GooCanvasItemSimple *simple = GOO_CANVAS_ITEM_SIMPLE (layer);
+
+  if (simple->canvas && !bounds_is_empty (bounds))
+    goo_canvas_request_item_redraw (simple->canvas, bounds,
+        simple->simple_data->is_static);
+}
+
+/* zoomed out, the arrows are left out (see GST_EDITOR_CANVAS_DETAIL_SCALE) */
+static gboolean
+gst_editor_link_layer_is_detailed (GstEditorLinkLayer * layer)
+{
+  GooCanvas *canvas = GOO_CANVAS_ITEM_SIMPLE (layer)->canvas;
+
+  return !canvas ||
+      goo_canvas_get_scale (canvas) >= GST_EDITOR_CANVAS_DETAIL_SCALE;
+}
+
+/*
+ * Stores the device space bounds of segment and returns its user space
+ * bounds. cr must have the layer's transform applied.
+ */
+static GooCanvasBounds
+gst_editor_link_layer_measure (GstEditorLinkLayer * layer,
+    GstEditorLinkSegment * segment, cairo_t * cr)
+{
+  GooCanvasItemSimple *simple = GOO_CANVAS_ITEM_SIMPLE (layer);
+  gdouble extent = goo_canvas_item_simple_get_line_width (simple) *
+      ARROW_WIDTH / 2;
+  GooCanvasBounds bounds;
+
+  bounds.x1 = MIN (segment->x1, segment->x2) - extent;
+  bounds.y1 = MIN (segment->y1, segment->y2) - extent;
+  bounds.x2 = MAX (segment->x1, segment->x2) + extent;
+  bounds.y2 = MAX (segment->y1, segment->y2) + extent;
+
+  segment->bounds = bounds;
+  goo_canvas_item_simple_user_bounds_to_device (simple, cr, &segment->bounds);
+  segment->dirty = FALSE;
+
+  return bounds;
+}
+
+/* a full update, e.g. after zooming or when the layer was added */
+static void
+gst_editor_link_layer_simple_update (GooCanvasItemSimple * simple,
+    cairo_t * cr)
+{
+  GstEditorLinkLayer *layer = GST_EDITOR_LINK_LAYER (simple);
+
+  /* in user space, converted to device space by GooCanvasItemSimple */
+  simple->bounds.x1 = simple->bounds.y1 = 0.;
+  simple->bounds.x2 = simple->bounds.y2 = 0.;
+
+  for (guint i = 0; i < layer->segments->len; i++) {
+    GooCanvasBounds bounds = gst_editor_link_layer_measure (layer,
+        &g_array_index (layer->segments, GstEditorLinkSegment, i), cr);
+
+    bounds_union (&simple->bounds, &bounds);
+  }
+  layer->n_dirty = 0;
+}
+
+/*
+ * Only the dirty segments are measured and redrawn. The layer's bounds
+ * grow to include them but are not shrunk until the next full update.
+ */
+static void
+gst_editor_link_layer_update (GooCanvasItem * citem, gboolean entire_tree,
+    cairo_t * cr, GooCanvasBounds * bounds)
+{
+  GstEditorLinkLayer *layer = GST_EDITOR_LINK_LAYER (citem);
+  GooCanvasItemSimple *simple = GOO_CANVAS_ITEM_SIMPLE (citem);
+
+  if (entire_tree || simple->need_update) {
+    parent_iface->update (citem, entire_tree, cr, bounds);
+    return;
+  }
+
+  if (layer->n_dirty > 0) {
+    cairo_save (cr);
+    if (simple->simple_data->transform)
+      cairo_transform (cr, simple->simple_data->transform);
+
+    for (guint i = 0; i < layer->segments->len; i++) {
+      GstEditorLinkSegment *segment =
+          &g_array_index (layer->segments, GstEditorLinkSegment, i);
+
+      if (!segment->dirty)
+        continue;
+
+      gst_editor_link_layer_request_redraw (layer, &segment->bounds);
+      gst_editor_link_layer_measure (layer, segment, cr);
+      gst_editor_link_layer_request_redraw (layer, &segment->bounds);
+      bounds_union (&simple->bounds, &segment->bounds);
+    }
+    layer->n_dirty = 0;
+
+    cairo_restore (cr);
+  }
+
+  *bounds = simple->bounds;
+}
+
+static gboolean
+segment_is_visible (const GstEditorLinkSegment * segment,
+    const GooCanvasBounds * bounds)
+{
+  return segment->bounds.x1 <= bounds->x2 && segment->bounds.x2 >= bounds->x1 &&
+      segment->bounds.y1 <= bounds->y2 && segment->bounds.y2 >= bounds->y1;
+}
+
+static void
+gst_editor_link_layer_paint (GooCanvasItemSimple * simple, cairo_t * cr,
+    const GooCanvasBounds * bounds)
+{
+  GstEditorLinkLayer *layer = GST_EDITOR_LINK_LAYER (simple);
+  gdouble line_width = goo_canvas_item_simple_get_line_width (simple);
+  gboolean detailed = gst_editor_link_layer_is_detailed (layer);
+
+  if (!goo_canvas_item_simple_set_stroke_options (simple, cr))
+    return;
+
+  /* all lines in one path, from the sink to the src pad */
+  for (guint i = 0; i < layer->segments->len; i++) {
+    GstEditorLinkSegment *segment =
+        &g_array_index (layer->segments, GstEditorLinkSegment, i);
+    gdouble dx = segment->x2 - segment->x1, dy = segment->y2 - segment->y1;
+    gdouble length = sqrt (dx * dx + dy * dy), tip = 0.;
+
+    if (!segment_is_visible (segment, bounds))
+      continue;
+
+    /* start the line under the arrow */
+    if (detailed && length > 0.)
+      tip = ARROW_TIP_LENGTH * line_width / length;
+    cairo_move_to (cr, segment->x1 + dx * tip, segment->y1 + dy * tip);
+    cairo_line_to (cr, segment->x2, segment->y2);
+  }
+  cairo_stroke (cr);
+
+  if (!detailed)
+    return;
+
+  /* and all arrows at the sink ends */
+  for (guint i = 0; i < layer->segments->len; i++) {
+    GstEditorLinkSegment *segment =
+        &g_array_index (layer->segments, GstEditorLinkSegment, i);
+    gdouble dx = segment->x2 - segment->x1, dy = segment->y2 - segment->y1;
+    gdouble length = sqrt (dx * dx + dy * dy);
+    gdouble base, tip, half_width;
+
+    if (length <= 0. || !segment_is_visible (segment, bounds))
+      continue;
+
+    dx /= length;
+    dy /= length;
+    base = ARROW_LENGTH * line_width;
+    tip = ARROW_TIP_LENGTH * line_width;
+    half_width = ARROW_WIDTH * line_width / 2;
+
+    cairo_move_to (cr, segment->x1, segment->y1);
+    cairo_line_to (cr, segment->x1 + dx * base - dy * half_width,
+        segment->y1 + dy * base + dx * half_width);
+    cairo_line_to (cr, segment->x1 + dx * tip, segment->y1 + dy * tip);
+    cairo_line_to (cr, segment->x1 + dx * base + dy * half_width,
+        segment->y1 + dy * base - dx * half_width);
+    cairo_close_path (cr);
+  }
+  cairo_fill (cr);
+}
+
+/* the links are not interactive once established */
+static gboolean
+gst_editor_link_layer_is_item_at (GooCanvasItemSimple * simple, gdouble x,
+    gdouble y, cairo_t * cr, gboolean is_pointer_event)
+{
+  return FALSE;
+}
+
+static void
+canvas_item_interface_init (GooCanvasItemIface * iface)
+{
+  parent_iface = g_type_interface_peek_parent (iface);
+
+  iface->update = gst_editor_link_layer_update;
+}
+
+static void
+gst_editor_link_layer_class_init (GstEditorLinkLayerClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GooCanvasItemSimpleClass *simple_class = GOO_CANVAS_ITEM_SIMPLE_CLASS (klass);
+
+  object_class->dispose = gst_editor_link_layer_dispose;
+  object_class->finalize = gst_editor_link_layer_finalize;
+
+  simple_class->simple_update = gst_editor_link_layer_simple_update;
+  simple_class->simple_paint = gst_editor_link_layer_paint;
+  simple_class->simple_is_item_at = gst_editor_link_layer_is_item_at;
+}
+
+/*
+ * Creates the link layer of a bin. It is painted above the bin's border
+ * but below its children, which are added afterwards.
+ */
+GooCanvasItem *
+gst_editor_link_layer_new (GooCanvasItem * parent)
+{
+  GooCanvasItem *layer = g_object_new (GST_TYPE_EDITOR_LINK_LAYER,
+      "line-width", 2.0, "pointer-events", GOO_CANVAS_EVENTS_NONE, NULL);
+
+  if (parent) {
+    goo_canvas_item_add_child (parent, layer, -1);
+    g_object_unref (layer);
+  }
+
+  return layer;
+}
+
+static void
+gst_editor_link_layer_mark_dirty (GstEditorLinkLayer * layer,
+    GstEditorLinkSegment * segment)
+{
+  if (segment->dirty)
+    return;
+
+  segment->dirty = TRUE;
+  if (layer->n_dirty++ == 0)
+    goo_canvas_item_request_update (GOO_CANVAS_ITEM (layer));
+}
+
+/* The layer paints link from now on, see gst_editor_link_link(). */
+void
+gst_editor_link_layer_add (GstEditorLinkLayer * layer, GstEditorLink * link)
+{
+  GstEditorLinkSegment segment = { link, };
+
+  g_return_if_fail (GST_IS_EDITOR_LINK_LAYER (layer));
+  g_return_if_fail (link->layer == NULL);
+
+  link->layer = layer;
+  link->layer_index = layer->segments->len;
+  g_array_append_val (layer->segments, segment);
+
+  gst_editor_link_layer_mark_dirty (layer,
+      &g_array_index (layer->segments, GstEditorLinkSegment,
+          link->layer_index));
+}
+
+void
+gst_editor_link_layer_remove (GstEditorLinkLayer * layer,
+    GstEditorLink * link)
+{
+  GstEditorLinkSegment *segment;
+  guint index;
+
+  g_return_if_fail (GST_IS_EDITOR_LINK_LAYER (layer));
+  g_return_if_fail (link->layer == layer);
+
+  index = link->layer_index;
+
+  segment = &g_array_index (layer->segments, GstEditorLinkSegment, index);
+  if (segment->dirty)
+    layer->n_dirty--;
+  gst_editor_link_layer_request_redraw (layer, &segment->bounds);
+
+  g_array_remove_index_fast (layer->segments, index);
+  if (index < layer->segments->len)
+    g_array_index (layer->segments, GstEditorLinkSegment, index).link->
+        layer_index = index;
+
+  link->layer = NULL;
+  link->layer_index = -1;
+}
+
+/*
+ * Moves the line of link to the sink end x1,y1 and the src end x2,y2,
+ * in the layer's coordinate space.
+ */
+void
+gst_editor_link_layer_set_segment (GstEditorLinkLayer * layer,
+    GstEditorLink * link, gdouble x1, gdouble y1, gdouble x2, gdouble y2)
+{
+  GstEditorLinkSegment *segment;
+
+  g_return_if_fail (GST_IS_EDITOR_LINK_LAYER (layer));
+  g_return_if_fail (link->layer == layer);
+
+  segment = &g_array_index (layer->segments, GstEditorLinkSegment,
+      link->layer_index);
+
+  /* e.g. both pads were moved along with the bin */
+  if (fabs (segment->x1 - x1) < SEGMENT_EPSILON &&
+      fabs (segment->y1 - y1) < SEGMENT_EPSILON &&
+      fabs (segment->x2 - x2) < SEGMENT_EPSILON &&
+      fabs (segment->y2 - y2) < SEGMENT_EPSILON)
+    return;
+
+  segment->x1 = x1;
+  segment->y1 = y1;
+  segment->x2 = x2;
+  segment->y2 = y2;
+  gst_editor_link_layer_mark_dirty (layer, segment);
+}
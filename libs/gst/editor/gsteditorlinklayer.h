@@ -0,0 +1,73 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef __GST_EDITOR_LINK_LAYER_H__
+#define __GST_EDITOR_LINK_LAYER_H__
+
+#include <goocanvas.h>
+
+#include <gst/editor/gsteditorlink.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_EDITOR_LINK_LAYER (gst_editor_link_layer_get_type())
+#define GST_EDITOR_LINK_LAYER(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_EDITOR_LINK_LAYER, GstEditorLinkLayer))
+#define GST_IS_EDITOR_LINK_LAYER(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_EDITOR_LINK_LAYER))
+
+typedef struct _GstEditorLinkSegment
+{
+  GstEditorLink *link;
+
+  gdouble x1, y1, x2, y2;	/* sink and src end in layer space */
+  GooCanvasBounds bounds;	/* device space, as last painted */
+  gboolean dirty;
+} GstEditorLinkSegment;
+
+/*
+ * Paints the established GstEditorLinks of a GstEditorBin. The line
+ * of every link is a GstEditorLinkSegment in one array, indexed by
+ * GstEditorLink::layer_index. Moving a pad only invalidates the
+ * segments of its links, and all of them are stroked in one path.
+ * The stroke color and line width are the GooCanvasItemSimple style
+ * properties.
+ */
+typedef struct _GstEditorLinkLayer
+{
+  GooCanvasItemSimple simple;
+
+  GArray *segments;		/* GstEditorLinkSegment */
+  guint n_dirty;		/* segments changed since the last update */
+} GstEditorLinkLayer;
+
+typedef struct _GstEditorLinkLayerClass
+{
+  GooCanvasItemSimpleClass parent_class;
+} GstEditorLinkLayerClass;
+
+GType gst_editor_link_layer_get_type (void);
+GooCanvasItem *gst_editor_link_layer_new (GooCanvasItem * parent);
+
+void gst_editor_link_layer_add (GstEditorLinkLayer * layer,
+    GstEditorLink * link);
+void gst_editor_link_layer_remove (GstEditorLinkLayer * layer,
+    GstEditorLink * link);
+void gst_editor_link_layer_set_segment (GstEditorLinkLayer * layer,
+    GstEditorLink * link, gdouble x1, gdouble y1, gdouble x2, gdouble y2);
+
+G_END_DECLS
+
+#endif /* __GST_EDITOR_LINK_LAYER_H__ */
@@ -0,0 +1,325 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Loading pipelines without blocking the main loop.
+ *
+ * The save file is read and the pipeline is instantiated in a worker
+ * thread (see gst_editor_canvas_load_parse()). The canvas items are
+ * then created progressively in idle callbacks that are limited to
+ * LOADER_TIME_SLICE each (see gst_editor_canvas_realize_step()), so
+ * the editor stays responsive even for very large pipelines.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <gst/gst.h>
+
+#include <gst/common/gste-serialize.h>
+
+#include "gsteditorcanvas.h"
+#include "gsteditorloader.h"
+
+GST_DEBUG_CATEGORY_STATIC (gste_loader_debug);
+#define GST_CAT_DEFAULT gste_loader_debug
+
+/* maximum time spent realizing canvas items per main loop iteration (us) */
+#define LOADER_TIME_SLICE (8 * G_TIME_SPAN_MILLISECOND)
+
+typedef struct _LoaderResult
+{
+  GstEditorCanvasLoad *load;
+  GsteSerializeFlags flags;
+} LoaderResult;
+
+/* worker thread input, copied from the canvas in gst_editor_loader_start() */
+typedef struct _LoaderTaskData
+{
+  gchar *filename;
+  gboolean structure_only;
+} LoaderTaskData;
+
+struct _GstEditorLoader
+{
+  GstEditorCanvas *canvas;
+  gchar *filename;
+  GsteSerializeFlags flags;
+
+  /* the worker thread is running */
+  gboolean parsing;
+  /* stopped while parsing, freed once the thread returns */
+  gboolean stopped;
+  GCancellable *cancellable;
+
+  /* canvas items are being realized */
+  guint realize_id;
+  guint n_elements, n_realized;
+
+  GstEditorLoaderProgressCallback progress_cb;
+  GstEditorLoaderFinishedCallback finished_cb;
+  gpointer user_data;
+};
+
+static void
+loader_result_free (LoaderResult * result)
+{
+  gst_editor_canvas_load_free (result->load);
+  g_free (result);
+}
+
+static void
+loader_task_data_free (LoaderTaskData * data)
+{
+  g_free (data->filename);
+  g_free (data);
+}
+
+static void
+loader_free (GstEditorLoader * loader)
+{
+  g_object_unref (loader->canvas);
+  g_object_unref (loader->cancellable);
+  g_free (loader->filename);
+  g_free (loader);
+}
+
+/**********************************************************************
+ * Worker thread
+ **********************************************************************/
+
+static void
+loader_thread_func (GTask * task, gpointer source_object, gpointer task_data,
+    GCancellable * cancellable)
+{
+  LoaderTaskData *data = task_data;
+  GKeyFile *key_file = g_key_file_new ();
+  LoaderResult *result;
+  GError *error = NULL;
+
+  if (!g_key_file_load_from_file (key_file, data->filename, G_KEY_FILE_NONE,
+          &error)) {
+    g_prefix_error (&error, "Error parsing save file: ");
+    goto error;
+  }
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+    goto error;
+
+  result = g_new0 (LoaderResult, 1);
+  result->load = gst_editor_canvas_load_parse (key_file, data->filename,
+      data->structure_only, &error);
+  if (!result->load) {
+    g_free (result);
+    goto error;
+  }
+
+  /*
+   * Restore save flags.
+   * Errors are handled gracefully by assuming no special settings (0).
+   */
+  result->flags = g_key_file_get_integer (key_file, PACKAGE_NAME, "Flags",
+      NULL);
+
+  g_key_file_unref (key_file);
+  g_task_return_pointer (task, result, (GDestroyNotify) loader_result_free);
+  return;
+
+error:
+  g_key_file_unref (key_file);
+  g_task_return_error (task, error);
+}
+
+/**********************************************************************
+ * Progressive realization (main thread)
+ **********************************************************************/
+
+static void
+loader_end_realize (GstEditorLoader * loader)
+{
+  gst_editor_canvas_set_progressive (loader->canvas, FALSE);
+  /* repacks all bins once */
+  gst_editor_canvas_thaw (loader->canvas);
+}
+
+static gboolean
+loader_realize_cb (gpointer user_data)
+{
+  GstEditorLoader *loader = user_data;
+  gboolean more;
+  guint n;
+
+  more = gst_editor_canvas_realize_step (loader->canvas,
+      g_get_monotonic_time () + LOADER_TIME_SLICE, &n);
+  loader->n_realized += n;
+
+  if (more) {
+    /* elements added meanwhile are not included in n_elements */
+    if (loader->progress_cb)
+      loader->progress_cb (loader, loader->n_elements ?
+          MIN ((gdouble) loader->n_realized / loader->n_elements, 1.) : 1.,
+          loader->user_data);
+    return G_SOURCE_CONTINUE;
+  }
+
+  GST_DEBUG ("realized %u of %u elements of %s", loader->n_realized,
+      loader->n_elements, loader->filename);
+
+  loader->realize_id = 0;
+  loader_end_realize (loader);
+
+  if (loader->progress_cb)
+    loader->progress_cb (loader, 1., loader->user_data);
+  loader->finished_cb (loader, NULL, loader->user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+loader_parsed_cb (GObject * source_object, GAsyncResult * res,
+    gpointer user_data)
+{
+  GstEditorLoader *loader = user_data;
+  LoaderResult *result;
+  GError *error = NULL;
+
+  loader->parsing = FALSE;
+  result = g_task_propagate_pointer (G_TASK (res), &error);
+
+  if (loader->stopped) {
+    if (result)
+      loader_result_free (result);
+    g_clear_error (&error);
+    loader_free (loader);
+    return;
+  }
+
+  if (!result) {
+    loader->finished_cb (loader, error, loader->user_data);
+    g_error_free (error);
+    return;
+  }
+
+  loader->flags = result->flags;
+  loader->n_elements = result->load->n_elements;
+
+  /* the canvas items are created by loader_realize_cb() */
+  gst_editor_canvas_freeze (loader->canvas);
+  gst_editor_canvas_set_progressive (loader->canvas, TRUE);
+  gst_editor_canvas_load_apply (loader->canvas, result->load);
+  loader_result_free (result);
+
+  /* at a lower priority than redraws and input events */
+  loader->realize_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+      loader_realize_cb, loader, NULL);
+}
+
+/**********************************************************************
+ * Public functions
+ **********************************************************************/
+
+/*
+ * Starts loading the Gst-Editor pipeline filename into canvas.
+ * The canvas' pipeline is replaced only once filename has been
+ * parsed successfully.
+ * The loader must be freed with gst_editor_loader_stop(), usually
+ * in the finished callback.
+ */
+GstEditorLoader *
+gst_editor_loader_start (GstEditorCanvas * canvas, const gchar * filename,
+    GstEditorLoaderProgressCallback progress,
+    GstEditorLoaderFinishedCallback finished, gpointer user_data)
+{
+  GstEditorLoader *loader;
+  LoaderTaskData *data;
+  GTask *task;
+
+  g_return_val_if_fail (GST_IS_EDITOR_CANVAS (canvas), NULL);
+  g_return_val_if_fail (filename != NULL, NULL);
+  g_return_val_if_fail (finished != NULL, NULL);
+
+  if (G_UNLIKELY (!gste_loader_debug))
+    GST_DEBUG_CATEGORY_INIT (gste_loader_debug, "GSTE_LOADER", 0,
+        "GStreamer Editor Loader");
+
+  loader = g_new0 (GstEditorLoader, 1);
+  loader->canvas = g_object_ref (canvas);
+  loader->filename = g_strdup (filename);
+  loader->cancellable = g_cancellable_new ();
+  loader->progress_cb = progress;
+  loader->finished_cb = finished;
+  loader->user_data = user_data;
+
+  data = g_new0 (LoaderTaskData, 1);
+  data->filename = g_strdup (filename);
+  data->structure_only = canvas->structure_only;
+
+  task = g_task_new (NULL, loader->cancellable, loader_parsed_cb, loader);
+  g_task_set_task_data (task, data, (GDestroyNotify) loader_task_data_free);
+  /* the pipeline of a stopped load is simply dropped */
+  g_task_set_return_on_cancel (task, TRUE);
+  loader->parsing = TRUE;
+  g_task_run_in_thread (task, loader_thread_func);
+  g_object_unref (task);
+
+  return loader;
+}
+
+/*
+ * Cancels the load if it is still in progress and frees loader.
+ * If the canvas has already been partially realized, it is left
+ * with an empty pipeline.
+ * The callbacks are not invoked anymore.
+ */
+void
+gst_editor_loader_stop (GstEditorLoader * loader)
+{
+  if (loader->realize_id) {
+    GstElement *pipeline = gst_editor_canvas_get_pipeline (loader->canvas);
+
+    g_source_remove (loader->realize_id);
+    loader->realize_id = 0;
+
+    gst_editor_canvas_set_progressive (loader->canvas, FALSE);
+    g_object_set (loader->canvas, "bin", gst_pipeline_new (NULL), NULL);
+    gst_object_unref (pipeline);
+    gst_editor_canvas_thaw (loader->canvas);
+  }
+
+  if (loader->parsing) {
+    /* freed by loader_parsed_cb() */
+    loader->stopped = TRUE;
+    g_cancellable_cancel (loader->cancellable);
+    return;
+  }
+
+  loader_free (loader);
+}
+
+const gchar *
+gst_editor_loader_get_filename (GstEditorLoader * loader)
+{
+  return loader->filename;
+}
+
+/* the serialization flags stored in the save file */
+GsteSerializeFlags
+gst_editor_loader_get_flags (GstEditorLoader * loader)
+{
+  return loader->flags;
+}
@@ -0,0 +1,55 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef __GST_EDITOR_LOADER_H__
+#define __GST_EDITOR_LOADER_H__
+
+#include <glib.h>
+
+#include <gst/common/gste-serialize.h>
+
+#include "gsteditorcanvas.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GstEditorLoader GstEditorLoader;
+
+/*
+ * Invoked in the main thread while the canvas is realized.
+ * fraction is between 0 and 1.
+ */
+typedef void (*GstEditorLoaderProgressCallback) (GstEditorLoader * loader,
+    gdouble fraction, gpointer user_data);
+/*
+ * Invoked in the main thread once the pipeline has been loaded
+ * (error is NULL) or could not be loaded.
+ * This is not invoked after gst_editor_loader_stop().
+ */
+typedef void (*GstEditorLoaderFinishedCallback) (GstEditorLoader * loader,
+    const GError * error, gpointer user_data);
+
+GstEditorLoader *gst_editor_loader_start (GstEditorCanvas * canvas,
+    const gchar * filename, GstEditorLoaderProgressCallback progress,
+    GstEditorLoaderFinishedCallback finished, gpointer user_data);
+void gst_editor_loader_stop (GstEditorLoader * loader);
+
+const gchar *gst_editor_loader_get_filename (GstEditorLoader * loader);
+GsteSerializeFlags gst_editor_loader_get_flags (GstEditorLoader * loader);
+
+G_END_DECLS
+
+#endif /* __GST_EDITOR_LOADER_H__ */
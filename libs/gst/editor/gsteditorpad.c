@@ -30,6 +30,15 @@
 #include "gst-helper.h"
 #include "gsteditorelement.h"
 #include "gsteditorpad.h"
+#include "gsteditorpadindex.h"
+#include "gsteditorcapscache.h"
+#include "gsteditordispatch.h"
+
+/* how close to a pad a link has to be dragged to snap to it, in pixels */
+#define LINK_SNAP_DISTANCE 8.0
+
+/* fill of the pads a dragged link could be linked to */
+#define COMPATIBLE_FILL_COLOR 0x99ee99ff
 
 /* interface methods */
 static void canvas_item_interface_init (GooCanvasItemIface * iface);
@@ -55,16 +64,22 @@ static void gst_editor_pad_repack (GstEditorItem * item);
 static void gst_editor_pad_repack (GstEditorItem * item);
 static void gst_editor_pad_object_changed (GstEditorItem * item,
     GstObject * object);
+static void gst_editor_pad_motion (GstEditorItem * item, gdouble x,
+    gdouble y);
 
 /* callbacks on GstPad */
 
 static void on_pad_linked (GstPad  *pad,GstPad  *peer,GstEditorItem * item);
+static void gst_editor_pad_linked (GstEditorItem * item, GstPad * pad,
+    GstPad * peer);
 
 /* utility functions */
 
 static void gst_editor_pad_link_drag (GstEditorPad * pad,
     gdouble wx, gdouble wy);
 static void gst_editor_pad_link_start (GstEditorPad * pad);
+static void gst_editor_pad_find_compatible (GstEditorPad * pad);
+static void gst_editor_pad_unhighlight_compatible (GstEditorPad * pad);
 
 static void on_pad_status (GSimpleAction * action,
     GVariant * parameter, gpointer user_data);
@@ -406,6 +421,7 @@ gst_editor_pad_class_init (GstEditorPadClass * klass)
   item_class->resize = gst_editor_pad_resize;
   item_class->repack = gst_editor_pad_repack;
   item_class->object_changed = gst_editor_pad_object_changed;
+  item_class->motion = gst_editor_pad_motion;
 }
 
 static void
@@ -474,6 +490,8 @@ gst_editor_pad_realize (GooCanvasItem * citem)
   g_return_if_fail (item->object != NULL);
   if (!item->realized) {
     gst_editor_item_realize (citem);
+    /* zoomed out, elements are plain boxes */
+    gst_editor_item_set_detail (citem);
   } else {  // check if links are still valid
     gboolean fail = FALSE;
     if (pad->ghostlink) {
@@ -691,9 +709,7 @@ gst_editor_pad_realize_source (GooCanvasItem * citem)
     g_print ("Not a valid EditorPad anymore, stopping\n");
     return FALSE;
   }
-  g_rw_lock_writer_lock (GST_EDITOR_ITEM (citem)->globallock);
   gst_editor_pad_realize (citem);
-  g_rw_lock_writer_unlock (GST_EDITOR_ITEM (citem)->globallock);
   return FALSE;
 }
 
@@ -776,14 +792,19 @@ gst_editor_pad_leave_notify_event (GooCanvasItem * citem,
   GstEditorItem * item;
   item = GST_EDITOR_ITEM (citem);
   pad = GST_EDITOR_PAD (citem);
+  /* keep lighting up the pads a dragged link can be connected to */
   g_object_set (GOO_CANVAS_ITEM (item->border), "fill_color_rgba",
-      item->fill_color, NULL);
+      pad->highlighted ? COMPATIBLE_FILL_COLOR : item->fill_color, NULL);
   if (pad->unlinking) {
     GstEditorPad * otherpad;
+    GooCanvas * canvas;
     otherpad = 
         (GstEditorPad *) ((pad == 
             (GstEditorPad *) pad->link->srcpad) ? pad->link->sinkpad : pad->
         link->srcpad);
+    canvas = goo_canvas_item_get_canvas (citem);
+    if (GST_IS_EDITOR_CANVAS (canvas))
+      gst_editor_caps_cache_invalidate (GST_EDITOR_CANVAS (canvas));
     gst_editor_link_unlink (pad->link);
     gst_editor_pad_link_start (otherpad);
   }
@@ -794,16 +815,25 @@ gst_editor_pad_leave_notify_event (GooCanvasItem * citem,
   return FALSE;
 }
 
+/* drags the new link once per frame, a hit test is expensive */
+static void
+gst_editor_pad_motion (GstEditorItem * item, gdouble x, gdouble y)
+{
+  GstEditorPad *pad = GST_EDITOR_PAD (item);
+
+  if (pad->linking)
+    gst_editor_pad_link_drag (pad, x, y);
+}
+
 static gboolean 
 gst_editor_pad_motion_notify_event (GooCanvasItem * citem,
     GooCanvasItem * target, GdkEventMotion * event) 
 {
   GstEditorPad * pad = GST_EDITOR_PAD (citem);
   if (pad->linking) {
-    gdouble x, y;
-    x = event->x_root;
-    y = event->y_root;
-    gst_editor_pad_link_drag (pad, x, y);
+    /* see gst_editor_pad_motion() */
+    gst_editor_item_queue_motion (GST_EDITOR_ITEM (pad), event->x_root,
+        event->y_root);
     return TRUE;
   }
   
@@ -852,6 +882,8 @@ gst_editor_pad_button_release_event (GooCanvasItem * citem,
     pad->unlinking = FALSE;
     if (pad->linking) {
       g_assert (pad->link != NULL);
+      gst_editor_item_flush_motion (GST_EDITOR_ITEM (pad));
+      gst_editor_pad_unhighlight_compatible (pad);
       
           //       gnome_canvas_item_ungrab (citem, event->button.time);
       goo_canvas_pointer_ungrab (goo_canvas_item_get_canvas (citem), citem,
@@ -862,6 +894,9 @@ gst_editor_pad_button_release_event (GooCanvasItem * citem,
             //newly added link-destroy function, kicks link from Pad-Canvas
 	    gst_editor_link_destroy(link);
 
+      } else if (GST_IS_EDITOR_CANVAS (goo_canvas_item_get_canvas (citem))) {
+        gst_editor_caps_cache_invalidate (GST_EDITOR_CANVAS (
+                goo_canvas_item_get_canvas (citem)));
       }
       pad->linking = FALSE;
       return TRUE;
@@ -873,10 +908,21 @@ gst_editor_pad_button_release_event (GooCanvasItem * citem,
       return FALSE;
 }
 
+/* may be called from a streaming thread, see gsteditordispatch.c */
 static void
 on_pad_linked (GstPad * pad, GstPad * peer, GstEditorItem * item)
 {
-  g_rw_lock_writer_lock (GST_EDITOR_ITEM (item)->globallock);
+  gst_editor_dispatch ((GstEditorDispatchFunc) gst_editor_pad_linked, item,
+      pad, peer);
+}
+
+static void
+gst_editor_pad_linked (GstEditorItem * item, GstPad * pad, GstPad * peer)
+{
+  /* unset in the meantime */
+  if (item->object != GST_OBJECT (pad))
+    return;
+
   g_print (
       "linking! Padpointer: %p, Peer %p Linkpointer %p, Ghostlinkpointer %p\n",
       pad, peer, GST_EDITOR_PAD (item)->link, GST_EDITOR_PAD (item)->ghostlink);
@@ -979,7 +1025,6 @@ on_pad_linked (GstPad * pad, GstPad * peer, GstEditorItem * item)
     }
   }
   gst_editor_pad_realize (GOO_CANVAS_ITEM (item));
-  g_rw_lock_writer_unlock (GST_EDITOR_ITEM (item)->globallock);
 }
 
 static void
@@ -987,10 +1032,16 @@ gst_editor_pad_link_start (GstEditorPad * pad)
 {
   GdkCursor *cursor;
   GooCanvasItem *link;
+  GooCanvas *canvas;
 
   g_return_if_fail (GST_IS_EDITOR_PAD (pad));
   g_return_if_fail (pad->link == NULL);
 
+  /* pads might have been added or removed since the last link drag */
+  canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (pad));
+  if (GST_IS_EDITOR_CANVAS (canvas))
+    gst_editor_pad_index_invalidate (GST_EDITOR_CANVAS (canvas));
+
   link = goo_canvas_item_new (GOO_CANVAS_ITEM (pad),
       gst_editor_link_get_type (), pad->issrc ? "src-pad" : "sink-pad", pad,
       NULL);
@@ -1003,31 +1054,113 @@ gst_editor_pad_link_start (GstEditorPad * pad)
   g_object_unref (cursor);
 
   pad->linking = TRUE;
+  gst_editor_pad_find_compatible (pad);
+}
+
+/* whether a link dragged from pad may end at destpad */
+static gboolean
+gst_editor_pad_can_link_to (GstEditorPad * destpad, gpointer user_data)
+{
+  GstEditorPad *pad = GST_EDITOR_PAD (user_data);
+
+  return destpad != pad &&
+      (!destpad->link || destpad->link == pad->link) &&
+      destpad->issrc != pad->issrc;
 }
 
+typedef struct
+{
+  GstEditorPad *pad;
+  GstEditorCapsCache *cache;
+} FindCompatibleData;
+
 static void
-gst_editor_pad_link_drag (GstEditorPad * pad, gdouble wx, gdouble wy)
+gst_editor_pad_find_compatible_one (gpointer data, gpointer user_data)
 {
-  GstEditorItem *item;
+  GstEditorPad *destpad = GST_EDITOR_PAD (data);
+  FindCompatibleData *find = user_data;
 
-  GooCanvasItem * underitem, *under = NULL;
-  GstEditorPad *destpad = NULL;
+  if (destpad->highlighted || !gst_editor_pad_can_link_to (destpad, find->pad))
+    return;
+  if (gst_editor_caps_cache_lookup (find->cache, find->pad, destpad) !=
+      GST_EDITOR_CAPS_COMPATIBLE)
+    return;
 
-  item = GST_EDITOR_ITEM (pad);
+  destpad->highlighted = TRUE;
+  g_ptr_array_add (find->pad->compatible, g_object_ref (destpad));
+  g_object_set (GOO_CANVAS_ITEM (GST_EDITOR_ITEM (destpad)->border),
+      "fill_color_rgba", COMPATIBLE_FILL_COLOR, NULL);
+}
 
-  /* if we're on top of an interesting pad */
+static void
+gst_editor_pad_compatible_ready (gpointer user_data)
+{
+  GstEditorPad *pad = GST_EDITOR_PAD (user_data);
 
-  if ((underitem =
-          goo_canvas_get_item_at (goo_canvas_item_get_canvas (GOO_CANVAS_ITEM
-                  (item)), wx, wy, FALSE)))
-    under = GST_EDITOR_GET_OBJECT (underitem);
+  if (pad->linking)
+    gst_editor_pad_find_compatible (pad);
+}
 
-  if (under && GST_IS_EDITOR_PAD (under))
-    destpad = GST_EDITOR_PAD (under);
+/*
+ * Lights up the pads whose caps are known to be compatible with those of
+ * pad. The pairs not in the caps cache yet are computed in the
+ * background, and lit up once they are done.
+ */
+static void
+gst_editor_pad_find_compatible (GstEditorPad * pad)
+{
+  GooCanvas *canvas;
+  FindCompatibleData find;
 
-  if (destpad && destpad != pad &&
-      (!destpad->link || destpad->link == pad->link) &&
-      destpad->issrc != pad->issrc) {
+  canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (pad));
+  if (!GST_IS_EDITOR_CANVAS (canvas))
+    return;
+
+  if (!pad->compatible)
+    pad->compatible = g_ptr_array_new_with_free_func (g_object_unref);
+
+  find.pad = pad;
+  find.cache = gst_editor_caps_cache_get (GST_EDITOR_CANVAS (canvas));
+  gst_editor_pad_index_foreach (gst_editor_pad_index_get (GST_EDITOR_CANVAS
+          (canvas)), gst_editor_pad_find_compatible_one, &find);
+
+  gst_editor_caps_cache_flush (find.cache, gst_editor_pad_compatible_ready,
+      g_object_ref (pad), g_object_unref);
+}
+
+static void
+gst_editor_pad_unhighlight_compatible (GstEditorPad * pad)
+{
+  if (!pad->compatible)
+    return;
+
+  for (guint i = 0; i < pad->compatible->len; i++) {
+    GstEditorPad *destpad = g_ptr_array_index (pad->compatible, i);
+    GstEditorItem *item = GST_EDITOR_ITEM (destpad);
+
+    destpad->highlighted = FALSE;
+    if (item->border)
+      g_object_set (GOO_CANVAS_ITEM (item->border), "fill_color_rgba",
+          item->fill_color, NULL);
+  }
+  g_clear_pointer (&pad->compatible, g_ptr_array_unref);
+}
+
+static void
+gst_editor_pad_link_drag (GstEditorPad * pad, gdouble wx, gdouble wy)
+{
+  GooCanvas *canvas;
+  GstEditorPad *destpad = NULL;
+
+  /* if we're near an interesting pad */
+  canvas = goo_canvas_item_get_canvas (GOO_CANVAS_ITEM (pad));
+  if (GST_IS_EDITOR_CANVAS (canvas))
+    destpad = gst_editor_pad_index_find (
+        gst_editor_pad_index_get (GST_EDITOR_CANVAS (canvas)), wx, wy,
+        LINK_SNAP_DISTANCE / goo_canvas_get_scale (canvas),
+        gst_editor_pad_can_link_to, pad);
+
+  if (destpad) {
     g_object_set (GOO_CANVAS_ITEM (pad->link),
         pad->issrc ? "sink-pad" : "src-pad", destpad, NULL);
   } else {
@@ -84,6 +84,9 @@ struct _GstEditorPad
   gboolean isghost;
   GstPadPresence presence;
 
+  /* node in the parent element's srcpads or sinkpads */
+  GList *element_link;
+
   /* links */
   GstEditorLink *link;
   GstEditorLink *ghostlink;
@@ -98,6 +101,10 @@ struct _GstEditorPad
 
   gboolean linking;
   gboolean unlinking;
+
+  /* while linking, the pads lit up as compatible */
+  GPtrArray *compatible;
+  gboolean highlighted;         /* in the compatible pads of a linking pad */
 };
 
 struct _GstEditorPadClass
@@ -0,0 +1,323 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Spatial index of the pads on a canvas.
+ *
+ * Dragging a link used to hit-test the whole canvas tree with
+ * goo_canvas_get_item_at() for every pointer position. The pad index
+ * answers which pads are near a point by looking at a few grid cells.
+ * The pads of moved elements are re-inserted when the moves are flushed
+ * (see gst_editor_pad_index_update()). Pads that have been added,
+ * removed or resized are picked up by rebuilding the whole index when
+ * a link drag starts.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include <gst/common/gste-debug.h>
+
+#include "gsteditorbin.h"
+#include "gsteditorpadindex.h"
+
+/* in canvas units, a few pads high */
+#define CELL_SIZE 64.0
+
+typedef struct
+{
+  GstEditorPad *pad;
+  GooCanvasBounds bounds;	/* canvas coordinates */
+} PadIndexEntry;
+
+struct _GstEditorPadIndex
+{
+  GHashTable *entries;		/* GstEditorPad -> PadIndexEntry */
+  GHashTable *cells;		/* cell key -> GPtrArray of PadIndexEntry */
+  gboolean valid;
+};
+
+static void
+pad_index_entry_free (PadIndexEntry * entry)
+{
+  g_object_unref (entry->pad);
+  g_free (entry);
+}
+
+static gint64 *
+pad_index_cell_key (gint cx, gint cy)
+{
+  gint64 *key = g_new (gint64, 1);
+
+  *key = ((gint64) cx << 32) | (guint32) cy;
+  return key;
+}
+
+static GPtrArray *
+pad_index_lookup (GstEditorPadIndex * index, gint cx, gint cy)
+{
+  gint64 key = ((gint64) cx << 32) | (guint32) cy;
+
+  return g_hash_table_lookup (index->cells, &key);
+}
+
+/* takes entry out of the cells covered by its bounds */
+static void
+pad_index_unlink_entry (GstEditorPadIndex * index, PadIndexEntry * entry)
+{
+  gint cx1, cy1, cx2, cy2;
+
+  cx1 = floor (entry->bounds.x1 / CELL_SIZE);
+  cy1 = floor (entry->bounds.y1 / CELL_SIZE);
+  cx2 = floor (entry->bounds.x2 / CELL_SIZE);
+  cy2 = floor (entry->bounds.y2 / CELL_SIZE);
+  for (gint cx = cx1; cx <= cx2; cx++) {
+    for (gint cy = cy1; cy <= cy2; cy++) {
+      gint64 key = ((gint64) cx << 32) | (guint32) cy;
+      GPtrArray *cell = g_hash_table_lookup (index->cells, &key);
+
+      if (!cell)
+        continue;
+      g_ptr_array_remove_fast (cell, entry);
+      if (!cell->len)
+        g_hash_table_remove (index->cells, &key);
+    }
+  }
+}
+
+/* adds pad, or moves it to its current position */
+static void
+pad_index_add_pad (GstEditorPadIndex * index, GooCanvas * canvas,
+    GstEditorPad * pad)
+{
+  GstEditorItem *item = GST_EDITOR_ITEM (pad);
+  PadIndexEntry *entry;
+  gint cx1, cy1, cx2, cy2;
+
+  if (!item->realized)
+    return;
+
+  entry = g_hash_table_lookup (index->entries, pad);
+  if (entry) {
+    pad_index_unlink_entry (index, entry);
+  } else {
+    entry = g_new (PadIndexEntry, 1);
+    entry->pad = g_object_ref (pad);
+    g_hash_table_insert (index->entries, pad, entry);
+  }
+
+  entry->bounds.x1 = entry->bounds.y1 = 0.;
+  entry->bounds.x2 = item->width;
+  entry->bounds.y2 = item->height;
+  goo_canvas_convert_from_item_space (canvas, GOO_CANVAS_ITEM (pad),
+      &entry->bounds.x1, &entry->bounds.y1);
+  goo_canvas_convert_from_item_space (canvas, GOO_CANVAS_ITEM (pad),
+      &entry->bounds.x2, &entry->bounds.y2);
+
+  cx1 = floor (entry->bounds.x1 / CELL_SIZE);
+  cy1 = floor (entry->bounds.y1 / CELL_SIZE);
+  cx2 = floor (entry->bounds.x2 / CELL_SIZE);
+  cy2 = floor (entry->bounds.y2 / CELL_SIZE);
+  for (gint cx = cx1; cx <= cx2; cx++) {
+    for (gint cy = cy1; cy <= cy2; cy++) {
+      GPtrArray *cell = pad_index_lookup (index, cx, cy);
+
+      if (!cell) {
+        cell = g_ptr_array_new ();
+        g_hash_table_insert (index->cells, pad_index_cell_key (cx, cy), cell);
+      }
+      g_ptr_array_add (cell, entry);
+    }
+  }
+}
+
+/* the pads of element and of all elements in it */
+static void
+pad_index_add_element (GstEditorPadIndex * index, GooCanvas * canvas,
+    GstEditorElement * element)
+{
+  GQueue *pads[2] = { &element->srcpads, &element->sinkpads };
+
+  for (guint i = 0; i < G_N_ELEMENTS (pads); i++)
+    for (GList * l = pads[i]->head; l; l = l->next)
+      pad_index_add_pad (index, canvas, GST_EDITOR_PAD (l->data));
+
+  if (GST_IS_EDITOR_BIN (element)) {
+    GstEditorBin *bin = GST_EDITOR_BIN (element);
+
+    for (guint i = 0; i < bin->sort.len; i++)
+      pad_index_add_element (index, canvas, bin->sort.elements[i]);
+  }
+}
+
+static void
+pad_index_rebuild (GstEditorPadIndex * index, GstEditorCanvas * canvas)
+{
+  g_hash_table_remove_all (index->cells);
+  g_hash_table_remove_all (index->entries);
+
+  if (canvas->bin)
+    pad_index_add_element (index, GOO_CANVAS (canvas),
+        GST_EDITOR_ELEMENT (canvas->bin));
+
+  EDITOR_LOG ("pad index: %u pads in %u cells",
+      g_hash_table_size (index->entries),
+      g_hash_table_size (index->cells));
+  index->valid = TRUE;
+}
+
+/* Returns the pad index of canvas, rebuilding it if necessary. */
+GstEditorPadIndex *
+gst_editor_pad_index_get (GstEditorCanvas * canvas)
+{
+  GstEditorPadIndex *index;
+
+  g_return_val_if_fail (GST_IS_EDITOR_CANVAS (canvas), NULL);
+
+  if (!canvas->pad_index) {
+    index = g_new0 (GstEditorPadIndex, 1);
+    index->entries = g_hash_table_new_full (NULL, NULL, NULL,
+        (GDestroyNotify) pad_index_entry_free);
+    index->cells = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+        g_free, (GDestroyNotify) g_ptr_array_unref);
+    canvas->pad_index = index;
+  }
+
+  index = canvas->pad_index;
+  if (!index->valid)
+    pad_index_rebuild (index, canvas);
+
+  return index;
+}
+
+/* Notes that pads have been added, removed or resized. */
+void
+gst_editor_pad_index_invalidate (GstEditorCanvas * canvas)
+{
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+
+  if (canvas->pad_index)
+    canvas->pad_index->valid = FALSE;
+}
+
+/*
+ * Re-inserts the pads of element, and of all elements in it, at their
+ * current positions. Called for every moved element when the moves
+ * are flushed (see gst_editor_canvas_flush_moves()).
+ */
+void
+gst_editor_pad_index_update (GstEditorCanvas * canvas,
+    GstEditorElement * element)
+{
+  g_return_if_fail (GST_IS_EDITOR_CANVAS (canvas));
+  g_return_if_fail (GST_IS_EDITOR_ELEMENT (element));
+
+  /* rebuilt by the next query anyway */
+  if (!canvas->pad_index || !canvas->pad_index->valid)
+    return;
+
+  pad_index_add_element (canvas->pad_index, GOO_CANVAS (canvas), element);
+}
+
+void
+gst_editor_pad_index_free (GstEditorPadIndex * index)
+{
+  if (!index)
+    return;
+
+  g_hash_table_unref (index->cells);
+  g_hash_table_unref (index->entries);
+  g_free (index);
+}
+
+/* whether pad was removed since the index was built */
+static gboolean
+pad_index_is_stale (GstEditorPad * pad)
+{
+  return !goo_canvas_item_get_parent (GOO_CANVAS_ITEM (pad)) ||
+      !GST_EDITOR_ITEM (pad)->object;
+}
+
+static gdouble
+bounds_distance (const GooCanvasBounds * bounds, gdouble x, gdouble y)
+{
+  gdouble dx = MAX (MAX (bounds->x1 - x, x - bounds->x2), 0.);
+  gdouble dy = MAX (MAX (bounds->y1 - y, y - bounds->y2), 0.);
+
+  return sqrt (dx * dx + dy * dy);
+}
+
+/*
+ * Finds the pad closest to x,y in canvas coordinates, but at most radius
+ * away, for which func returns TRUE. A pad containing x,y has a distance
+ * of 0.
+ */
+GstEditorPad *
+gst_editor_pad_index_find (GstEditorPadIndex * index, gdouble x, gdouble y,
+    gdouble radius, GstEditorPadIndexFunc func, gpointer user_data)
+{
+  GstEditorPad *best = NULL;
+  gdouble best_distance = radius;
+  gint cx1, cy1, cx2, cy2;
+
+  g_return_val_if_fail (index != NULL, NULL);
+
+  cx1 = floor ((x - radius) / CELL_SIZE);
+  cy1 = floor ((y - radius) / CELL_SIZE);
+  cx2 = floor ((x + radius) / CELL_SIZE);
+  cy2 = floor ((y + radius) / CELL_SIZE);
+
+  for (gint cx = cx1; cx <= cx2; cx++) {
+    for (gint cy = cy1; cy <= cy2; cy++) {
+      GPtrArray *cell = pad_index_lookup (index, cx, cy);
+
+      for (guint i = 0; cell && i < cell->len; i++) {
+        PadIndexEntry *entry = g_ptr_array_index (cell, i);
+        gdouble distance = bounds_distance (&entry->bounds, x, y);
+
+        if (distance > best_distance || entry->pad == best)
+          continue;
+        if (pad_index_is_stale (entry->pad))
+          continue;
+        if (func && !func (entry->pad, user_data))
+          continue;
+
+        best = entry->pad;
+        best_distance = distance;
+      }
+    }
+  }
+
+  return best;
+}
+
+/* Calls func for every pad in the index. */
+void
+gst_editor_pad_index_foreach (GstEditorPadIndex * index, GFunc func,
+    gpointer user_data)
+{
+  GHashTableIter iter;
+  gpointer pad;
+
+  g_return_if_fail (index != NULL);
+
+  g_hash_table_iter_init (&iter, index->entries);
+  while (g_hash_table_iter_next (&iter, &pad, NULL))
+    if (!pad_index_is_stale (GST_EDITOR_PAD (pad)))
+      func (pad, user_data);
+}
@@ -0,0 +1,52 @@
+/* gst-editor
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef __GST_EDITOR_PAD_INDEX_H__
+#define __GST_EDITOR_PAD_INDEX_H__
+
+#include <gst/editor/gsteditorcanvas.h>
+#include <gst/editor/gsteditorpad.h>
+
+G_BEGIN_DECLS
+
+/*
+ * A uniform grid of the bounds of all GstEditorPads on a canvas, in
+ * canvas coordinates. It belongs to the GstEditorCanvas, is updated
+ * when elements move and is rebuilt on demand after it has been
+ * invalidated.
+ */
+typedef struct _GstEditorPadIndex GstEditorPadIndex;
+
+/* whether pad is an acceptable result of gst_editor_pad_index_find() */
+typedef gboolean (*GstEditorPadIndexFunc) (GstEditorPad * pad,
+    gpointer user_data);
+
+GstEditorPadIndex *gst_editor_pad_index_get (GstEditorCanvas * canvas);
+void gst_editor_pad_index_invalidate (GstEditorCanvas * canvas);
+void gst_editor_pad_index_update (GstEditorCanvas * canvas,
+    GstEditorElement * element);
+void gst_editor_pad_index_free (GstEditorPadIndex * index);
+
+GstEditorPad *gst_editor_pad_index_find (GstEditorPadIndex * index,
+    gdouble x, gdouble y, gdouble radius, GstEditorPadIndexFunc func,
+    gpointer user_data);
+void gst_editor_pad_index_foreach (GstEditorPadIndex * index, GFunc func,
+    gpointer user_data);
+
+G_END_DECLS
+
+#endif /* __GST_EDITOR_PAD_INDEX_H__ */
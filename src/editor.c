@@ -34,6 +34,8 @@
 #include <gst/gst.h>
     
 #include <gst/editor/editor.h>
+#include <gst/common/gste-layout.h>
+#include <gst/common/gste-placeholder.h>
 
 int
 main (int argc, char * argv[])
@@ -41,11 +43,22 @@ main (int argc, char * argv[])
   GstEditor * editor;
 
   gboolean launch = FALSE;
+  gboolean layout = FALSE;
+  gboolean structure_only = FALSE;
+  gboolean compact = FALSE;
   const gchar ** remaining_args = NULL;
 
   GOptionEntry options[] = {
     {"launch", 'l', 0, G_OPTION_ARG_NONE, &launch,
      "Create pipeline from gst-launch(1) syntax", NULL},
+    {"layout", 0, 0, G_OPTION_ARG_NONE, &layout,
+     "Lay out pipeline INPUT and save it to OUTPUT (.gep) without a GUI",
+     NULL},
+    {"structure-only", 's', 0, G_OPTION_ARG_NONE, &structure_only,
+     "Load elements as placeholders, instantiating them when selected",
+     NULL},
+    {"compact", 'c', 0, G_OPTION_ARG_NONE, &compact,
+     "Paint each loaded element with a single canvas item", NULL},
       /* last but not least a special option that collects filenames or
          gst-launch arguments */
     {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_STRING_ARRAY, &remaining_args,
@@ -64,37 +77,71 @@ main (int argc, char * argv[])
   ctx = g_option_context_new (PACKAGE);
   g_option_context_add_main_entries (ctx, options, GETTEXT_PACKAGE);
   g_option_context_add_group (ctx, gst_init_get_option_group ());
-  g_option_context_add_group (ctx, gtk_get_option_group (TRUE));
+  /* GTK is initialized below, so --layout works without a display */
+  g_option_context_add_group (ctx, gtk_get_option_group (FALSE));
   if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
     g_print ("Error initializing: %s\n", err->message);
     exit (1);
   }
 
+  if (layout) {
+    if (!remaining_args || g_strv_length ((gchar **) remaining_args) != 2) {
+      g_print ("Usage: %s --layout INPUT OUTPUT\n", argv[0]);
+      exit (1);
+    }
+
+    gste_init ();
+    if (!gste_layout_file (remaining_args[0], remaining_args[1], &err)) {
+      g_print ("Error: %s\n", err->message);
+      exit (1);
+    }
+    exit (0);
+  }
+
+  gtk_init (&argc, &argv);
   gste_init ();
   if (remaining_args != NULL) {
     if (launch) {
       GError * error = NULL;
       GstElement * element;
       GstBin * bin;
-      element = gst_parse_launchv (remaining_args, &error);
+      element = NULL;
+      if (structure_only) {
+        gchar * description = g_strjoinv (" ", (gchar **) remaining_args);
+
+        /* falls back to GstParse for unsupported syntax */
+        element = gste_placeholder_parse_launch (description, NULL);
+        g_free (description);
+      }
+      if (!element)
+        element = gst_parse_launchv (remaining_args, &error);
       if (!element) {
         g_print ("Error: %s\n", error->message);
         exit (1);
       }
       bin = GST_BIN (element);
-      editor = (GstEditor *)gst_editor_new (GST_ELEMENT (bin));
+      editor = (GstEditor *)gst_editor_new (NULL);
+      g_object_set (editor->canvas, "structure-only", structure_only,
+          "compact", compact, NULL);
+      gst_editor_set_pipeline (editor, GST_ELEMENT (bin));
     }
 
     else {
       while (*remaining_args) {
         editor = (GstEditor *)gst_editor_new (NULL);
+        g_object_set (editor->canvas, "structure-only", structure_only,
+            "compact", compact, NULL);
         gst_editor_load (editor, *remaining_args++);
       }
     }
   }
 
   else {
-    gst_editor_new (gst_element_factory_make ("pipeline", NULL));
+    editor = (GstEditor *)gst_editor_new (NULL);
+    g_object_set (editor->canvas, "structure-only", structure_only,
+        "compact", compact, NULL);
+    gst_editor_set_pipeline (editor,
+        gst_element_factory_make ("pipeline", NULL));
   }
   gtk_main ();
   exit (0);